@@ -0,0 +1,94 @@
+#!/bin/bash
+# BENCHMARK SCRIPT FOR THE PACKET TRANSPORTS
+#  *
+#  * @file benchTransports.sh
+#  * @brief This script compares the probe rate of the raw, packet-mmap, xdp and io-uring backends on one veth pair.
+#  */
+
+# ANSI escape codes for colored output
+RESET="\033[0m"
+RED="\033[1;31m"
+GREEN="\033[1;32m"
+YELLOW="\033[1;33m"
+BLUE="\033[1;34m"
+MAGENTA="\033[1;35m"
+
+# Decorations
+SEPARATOR="${BLUE}========================================================${RESET}"
+
+# Test bed, the target lives in its own namespace behind a veth pair
+NETNS="ipkbench"
+VETH_SCAN="ipkb0"
+VETH_TARGET="ipkb1"
+ADDR_SCAN="10.77.0.1"
+ADDR_TARGET="10.77.0.2"
+PORTS=${PORTS:-"1-65535"}
+RUNS=${RUNS:-3}
+
+# Helper function to print a formatted message
+print_section() {
+    echo -e "\n$SEPARATOR"
+    echo -e "${MAGENTA}$1${RESET}"
+    echo -e "$SEPARATOR"
+}
+
+# Helper function to remove the test bed
+cleanup() {
+    ip link del "$VETH_SCAN" 2>/dev/null
+    ip netns del "$NETNS" 2>/dev/null
+}
+
+# Helper function to run one backend and print its probe rate
+run_bench() {
+    local backend=$1
+
+    echo -e "${YELLOW}Running: $backend${RESET}"
+    for run in $(seq "$RUNS"); do
+        local start=$(date +%s%N)
+        local count=$(./ipk-l4-scan -i "$VETH_SCAN" -t "$PORTS" -w 1000 -b "$backend" "$ADDR_TARGET" | wc -l)
+        local end=$(date +%s%N)
+        local elapsed=$(( (end - start) / 1000 ))
+        if [ "$count" -eq 0 ] || [ "$elapsed" -eq 0 ]; then
+            echo -e "${RED}Run $run failed.${RESET}"
+            continue
+        fi
+        echo -e "${GREEN}Run $run: $count ports in $(( elapsed / 1000 )) ms, $(( count * 1000000 / elapsed )) pps${RESET}"
+    done
+}
+
+if [ "$(id -u)" -ne 0 ]; then
+    echo -e "${RED}Error: the benchmark needs root.${RESET}"
+    exit 1
+fi
+
+# Build
+print_section "BUILDING"
+make
+if [ ! -f "./ipk-l4-scan" ]; then
+    echo -e "${RED}Error: ipk-l4-scan binary not created.${RESET}"
+    exit 1
+fi
+
+# Set up the veth pair, no listeners in the namespace, every port answers with RST
+print_section "SETTING UP $VETH_SCAN <-> $VETH_TARGET"
+cleanup
+trap cleanup EXIT
+ip netns add "$NETNS" || exit 1
+ip link add "$VETH_SCAN" type veth peer name "$VETH_TARGET" || exit 1
+ip link set "$VETH_TARGET" netns "$NETNS"
+ip addr add "$ADDR_SCAN/24" dev "$VETH_SCAN"
+ip link set "$VETH_SCAN" up
+ip netns exec "$NETNS" ip addr add "$ADDR_TARGET/24" dev "$VETH_TARGET"
+ip netns exec "$NETNS" ip link set "$VETH_TARGET" up
+ip netns exec "$NETNS" ip link set lo up
+
+# Run the benchmark
+print_section "SCANNING TCP PORTS $PORTS"
+run_bench raw
+run_bench packet-mmap
+run_bench xdp
+run_bench io-uring
+
+print_section "CLEANING UP"
+echo -e "${GREEN}Benchmark completed.${RESET}"
+exit 0
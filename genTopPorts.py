@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+# TOP PORTS GENERATOR
+#  *
+#  * @file genTopPorts.py
+#  * @brief This script reads the open frequencies of nmap-services and writes the TCP and UDP frequency tables of topports.cpp.
+#  */
+
+import re
+import sys
+
+TABLE_FILE = "src/topports.cpp"
+PER_LINE = 6    # entries per line of the tables
+
+# the tables between the markers are replaced, the rest of the file is kept
+BEGIN = "// BEGIN GENERATED TABLES (genTopPorts.py)"
+END = "// END GENERATED TABLES"
+
+
+# parse the lines "name port/protocol frequency [# comment]", the hit rate in hosts per million
+def read_frequencies(path):
+    tables = {"tcp": {}, "udp": {}}
+    with open(path) as services:
+        for line in services:
+            fields = line.split("#", 1)[0].split()
+            if len(fields) < 3:
+                continue
+            match = re.fullmatch(r"(\d+)/(tcp|udp)", fields[1])
+            if match is None:
+                continue
+            port, protocol = int(match.group(1)), match.group(2)
+            hits = round(float(fields[2]) * 1000000)
+            # a port never seen open is not part of the profile
+            if 0 < port <= 65535 and hits > 0:
+                tables[protocol][port] = max(hits, tables[protocol].get(port, 0))
+    return tables
+
+
+# format the table in port order, as topports.cpp expects it
+def format_table(name, protocol, frequencies):
+    entries = ["{%d, %d}," % (port, hits) for port, hits in sorted(frequencies.items())]
+    lines = ["// %s ports with the hosts per million, they were found open on (after the open frequencies of nmap-services), in port order" % protocol,
+             "static constexpr PortFrequency %s[] = {" % name]
+    for start in range(0, len(entries), PER_LINE):
+        lines.append("    " + " ".join(entries[start:start + PER_LINE]))
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        print("Usage: %s NMAP_SERVICES [TABLE_FILE]" % sys.argv[0], file=sys.stderr)
+        return 1
+    tables = read_frequencies(sys.argv[1])
+    target = sys.argv[2] if len(sys.argv) == 3 else TABLE_FILE
+    if not tables["tcp"] or not tables["udp"]:
+        print("No open frequencies found in %s" % sys.argv[1], file=sys.stderr)
+        return 1
+
+    with open(target) as source:
+        text = source.read()
+    begin, end = text.find(BEGIN), text.find(END)
+    if begin < 0 or end < begin:
+        print("No generated tables in %s" % target, file=sys.stderr)
+        return 1
+
+    generated = "\n\n".join([format_table("TCP_FREQUENCIES", "TCP", tables["tcp"]), format_table("UDP_FREQUENCIES", "UDP", tables["udp"])])
+    with open(target, "w") as source:
+        source.write(text[:begin] + BEGIN + "\n" + generated + "\n" + text[end:])
+    print("%d TCP and %d UDP ports written to %s" % (len(tables["tcp"]), len(tables["udp"]), target))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -11,6 +11,7 @@
 #include <vector>
 #include <string>
 #include "utils.hpp"
+#include "exclude.hpp"
 #include <unordered_set>
 
 /**
@@ -20,38 +21,11 @@
 enum class Mode {
     SCAN,
     PRINT_INTERFACES,
+    DAEMON,
+    WATCH,
     UNKNOWN
 };
 
-/**
- * @enum Mode
- * @brief Enumeration for different scanning modes.
- */
-enum class TargetType {
-    IP_v4,
-    IP_v6,
-    DOMAIN_NAME,
-    UNKNOWN
-};
-
-const int MAX_PORT_NUMBER = 65535;
-
-/**
- * @brief Function to parse the ports
- * 
- * @param ports The string containing the ports
- * @return std::vector<int> The vector containing the ports
-*/
-std::vector<int> parsePorts(const std::string &ports);
-
-/**
- * @brief Function to determine the target type
- * 
- * @param target The target string
- * @return TargetType The target type
-*/
-TargetType determinTargetType(const std::string &target);
-
 /**
  * @class Arguments
  * @brief Parses and stores command-line arguments for the scanner.
@@ -92,6 +66,48 @@ class Settings {
          * @return An integer representing the timeout in milliseconds.
         */
         int getTimeout() const { return timeout; };
+
+        /**
+         * @brief Retrieves the packet transport backend.
+         * @return A Backend enum value representing the backend.
+        */
+        Backend getBackend() const { return backend; };
+
+        /**
+         * @brief Retrieves, if the round trip times are printed.
+         * @return True, if the answered ports get the round trip time.
+        */
+        bool isRttShown() const { return showRtt; };
+
+        /**
+         * @brief Retrieves the cap of the probes in flight to one host.
+         * @return The max probes per host, 0 if only the congestion windows limit them.
+        */
+        int getHostProbes() const { return hostProbes; };
+
+        /**
+         * @brief Retrieves the size of the banners read from the open TCP ports.
+         * @return The max bytes of a banner, 0 if no banners are read.
+        */
+        int getBannerBytes() const { return bannerBytes; };
+
+        /**
+         * @brief Retrieves the socket path of the daemon mode.
+         * @return The path of the Unix domain socket, empty if no daemon is run.
+        */
+        std::string getDaemonPath() const { return daemonPath; };
+
+        /**
+         * @brief Retrieves the interval of the watch mode.
+         * @return The seconds between the rounds, 0 if the targets are scanned once.
+        */
+        int getWatchInterval() const { return watchInterval; };
+
+        /**
+         * @brief Retrieves the excluded prefixes.
+         * @return The exclusion list, the targets it covers are already dropped.
+        */
+        const ExcludeList& getExclusions() const { return exclusions; };
     
         /**
          * @brief Retrieves the target type.
@@ -139,6 +155,13 @@ class Settings {
         std::vector<int> TCPports;                      // tcp ports
         std::vector<int> UDPports;                      // udp ports
         int timeout = 5000;                             // timeout
+        Backend backend = Backend::RAW;                 // packet transport
+        bool showRtt = false;                           // print the round trip times
+        int hostProbes = 0;                             // max probes in flight to one host, 0 for the windows only
+        int bannerBytes = 0;                            // max bytes of a banner, 0 for no banners
+        std::string daemonPath = "";                    // socket of the daemon mode
+        int watchInterval = 0;                          // seconds between the rounds of the watch mode, 0 for one scan
+        ExcludeList exclusions;                         // prefixes, that are never probed
         bool Targetipv4 = false;                        // indicates, if we have ipv4 targets
         bool Targetipv6 = false;                        // indicates, if we have ipv4 targets    
         std::vector<NetworkAdress> targetIp4;           // targets ip4
@@ -0,0 +1,147 @@
+/**
+ * @file banner.hpp
+ * @brief Header file for the banner stage (reads the greeting of the open TCP ports over non-blocking connections)
+ * @author Martin Mendl <x247581>
+ * @date 2025-12-23
+ */
+
+#ifndef BANNER_HPP
+#define BANNER_HPP
+
+#include <vector>
+#include <string>
+#include <poll.h>
+#include "scheduler.hpp"
+#include "pool.hpp"
+
+const int BANNER_MAX_BYTES = 4096;      // largest banner read from a port
+const int BANNER_STARTS_PER_PASS = 64;  // connects started per pass of the scan loop, the probes go first
+const int BANNER_EVENTS = 256;          // epoll events read per pass
+
+/**
+ * @class BannerGrabber
+ * @brief Pipeline stage, that reads the first bytes, an open TCP port sends
+ *
+ * The scheduler hands every open TCP port to the stage instead of the
+ * output. The stage connects to the port with a non-blocking socket and
+ * reads up to the given number of bytes, until the service ends a line,
+ * closes the connection or the timeout of the connection runs out, then
+ * the result goes on with the banner. All the connections wait in one
+ * epoll set, its descriptor is polled in the loop of the scheduler, so the
+ * SYN probes and the banners share a single poll(). A pass starts at most
+ * BANNER_STARTS_PER_PASS connects and reads at most BANNER_EVENTS sockets
+ * without blocking, so the probes are never held up by the banners.
+ */
+class BannerGrabber {
+    public:
+        /**
+         * @brief Constructor for BannerGrabber class
+         *
+         * @param sender4 - the interface with its IPv4 address, the sockets are bound to the interface
+         * @param sender6 - the interface with its IPv6 address
+         * @param bytes - max bytes read from a port, at most BANNER_MAX_BYTES
+         * @param timeout - timeout of a connection in ms, from the connect to the last byte
+         * @param avoidProbePorts - true to keep the local ports out of the source ports of the probes (xdp backend)
+         * @param onResult - callback invoked for the port, once its banner is read
+         */
+        BannerGrabber(const NetworkInterface &sender4, const NetworkInterface &sender6, int bytes, int timeout, bool avoidProbePorts, ResultCallback onResult);
+        BannerGrabber(const BannerGrabber&) = delete;
+        BannerGrabber& operator=(const BannerGrabber&) = delete;
+        /**
+         * @brief Destructor for BannerGrabber class, closes the connections still open
+         */
+        ~BannerGrabber();
+
+        /**
+         * @brief Method to queue an open port for its banner
+         *
+         * @param result - the open TCP port
+         */
+        void add(const PortResult &result) { queued.push_back(result); };
+        /**
+         * @brief Method to add the epoll set to the poll set of the scan loop
+         *
+         * @param fds - the poll set
+         * @param timeoutMs - timeout of the poll, shortened to the next deadline or to 0, if connects are waiting
+         */
+        void addPollFds(std::vector<struct pollfd> &fds, int &timeoutMs) const;
+        /**
+         * @brief Method to start the queued connects, read the ready sockets and expire the late ones, without blocking
+         */
+        void process();
+        /**
+         * @brief Method to read the banners of all the queued ports
+         */
+        void run();
+        /**
+         * @brief Method to check, if all the queued ports are finished
+         *
+         * @return bool - true, if nothing is queued or connected
+         */
+        bool finished() const { return queued.empty() && inFlight == 0; };
+
+    private:
+        /**
+         * @struct Connection
+         * @brief Connection to an open port
+         */
+        struct Connection {
+            int fd = -1;                    // the socket, -1 for a free slot
+            PortResult result;              // the port, the banner is added to
+            size_t received = 0;            // bytes of the banner read
+            Clock::time_point startedAt;    // start of the connect, for the timeout
+        };
+
+        /**
+         * @brief Method to start the connects of the queued ports, up to the limits
+         */
+        void startQueued();
+        /**
+         * @brief Method to read from a ready connection
+         *
+         * @param slot - index of the connection
+         * @param events - the epoll events
+         */
+        void receive(int slot, uint32_t events);
+        /**
+         * @brief Method to close a connection and pass on the port with its banner
+         *
+         * @param slot - index of the connection
+         */
+        void finish(int slot);
+        /**
+         * @brief Method to finish the connections, that ran out of time
+         */
+        void expire();
+        /**
+         * @brief Method to get the time until the next connection times out
+         *
+         * @return int - milliseconds, -1 if nothing is connected
+         */
+        int nextTimeoutMs() const;
+
+        NetworkInterface sender4;               // the interface with its IPv4 address
+        NetworkInterface sender6;               // the interface with its IPv6 address
+        size_t bytes;                           // max bytes of a banner
+        int timeout;                            // timeout of a connection in ms
+        bool avoidProbePorts;                   // keep the local ports out of the source ports of the probes
+        ResultCallback onResult;                // the next stage
+        int socketLimit;                        // max connections at once
+        int inFlight = 0;                       // connections open
+        int epollfd = -1;                       // the epoll set of the sockets
+        RingQueue<PortResult> queued;           // open ports waiting for a connection
+        std::vector<Connection> connections;    // the connections, by slot
+        std::vector<int> freeSlots;             // slots without a connection
+        std::vector<char> buffers;              // the banners being read, bytes per slot
+        RingQueue<std::pair<int, Clock::time_point>> expiries; // (slot, start) in start order, a reused slot is told apart by the start
+};
+
+/**
+ * @brief Function to make a banner printable on one line
+ *
+ * @param banner - the bytes of the banner
+ * @return std::string - the banner in quotes, control characters, quotes and backslashes escaped
+ */
+std::string quoteBanner(const std::string &banner);
+
+#endif // BANNER_HPP
@@ -0,0 +1,167 @@
+/**
+ * @file connect.hpp
+ * @brief Header file for the connect scan (non-blocking TCP connects tracked with epoll, no raw sockets needed)
+ * @author Martin Mendl <x247581>
+ * @date 2025-12-16
+ */
+
+#ifndef CONNECT_HPP
+#define CONNECT_HPP
+
+#include <vector>
+#include <cstdint>
+#include <poll.h>
+#include <sys/socket.h>
+#include "scheduler.hpp"
+#include "pool.hpp"
+
+const int CONNECT_MAX_SOCKETS = 4096;   // max connects in flight
+const int CONNECT_RESERVED_FDS = 64;    // descriptors left to the rest of the process (stdio, interfaces, epoll)
+const int CONNECT_EVENTS = 256;         // epoll events read at once
+
+/**
+ * @class ConnectScanner
+ * @brief Scans TCP ports with non-blocking connect() calls, for hosts without CAP_NET_RAW
+ *
+ * The kernel does the handshake (and the SYN retransmissions), the scanner
+ * only opens the sockets and waits for them in one epoll set: a completed
+ * connect is an open port, ECONNREFUSED (a RST) a closed one, an ICMP
+ * unreachable or the timeout a filtered one. The number of sockets open at
+ * once is taken from RLIMIT_NOFILE (the soft limit is raised up to the
+ * hard one first), and a socket() failing with EMFILE lowers it further.
+ * The targets are interleaved like in the scheduler, so a silent host does
+ * not hold up the others. run() waits in epoll itself, a loop, that drives
+ * other scans as well, polls the epoll set (addPollFds) and calls process().
+ */
+class ConnectScanner {
+    public:
+        /**
+         * @brief Constructor for ConnectScanner class
+         *
+         * @param sender4 - the interface with its IPv4 address, the sockets are bound to the interface
+         * @param sender6 - the interface with its IPv6 address
+         * @param targets - targets of both IP versions
+         * @param ports - TCP ports, probed in this order
+         * @param timeout - timeout of a connect in ms
+         */
+        ConnectScanner(const NetworkInterface &sender4, const NetworkInterface &sender6, std::vector<NetworkAdress> targets, std::vector<int> ports, int timeout);
+        ConnectScanner(const ConnectScanner&) = delete;
+        ConnectScanner& operator=(const ConnectScanner&) = delete;
+        /**
+         * @brief Destructor for ConnectScanner class, closes the sockets still open
+         */
+        ~ConnectScanner();
+
+        /**
+         * @brief Method to scan all the ports of all the targets
+         *
+         * @param onResult - callback invoked for every finished port
+         */
+        void run(const ResultCallback &onResult);
+        /**
+         * @brief Method to add the epoll set to the poll set of a loop, that drives several scans
+         *
+         * @param fds - the poll set
+         * @param timeoutMs - timeout of the poll, shortened to the next deadline or to 0, if a connect can be started
+         */
+        void addPollFds(std::vector<struct pollfd> &fds, int &timeoutMs) const;
+        /**
+         * @brief Method to start the connects, that fit, and finish the ready and the late ones, without blocking
+         *
+         * @param onResult - callback invoked for every finished port
+         */
+        void process(const ResultCallback &onResult);
+        /**
+         * @brief Method to check, if all the ports are finished
+         *
+         * @return bool - true, if nothing is left to connect or in flight
+         */
+        bool finished() const { return next >= targets.size() * ports.size() && inFlight == 0; };
+        /**
+         * @brief Method to get the number of sockets, the scan opens at once
+         *
+         * @return int - max connects in flight
+         */
+        int getSocketLimit() const { return socketLimit; };
+
+    private:
+        /**
+         * @struct Attempt
+         * @brief Connect in flight
+         */
+        struct Attempt {
+            int fd = -1;                // the socket, -1 for a free slot
+            size_t target = 0;          // index of the target
+            int port = 0;               // the port
+            Clock::time_point sentAt;   // start of the connect, for the timeout and the round trip time
+        };
+
+        /**
+         * @brief Method to start the connect of the next port
+         *
+         * @param onResult - callback for a connect, that finishes right away
+         * @return bool - false, if no socket could be opened now
+         */
+        bool startNext(const ResultCallback &onResult);
+        /**
+         * @brief Method to finish a connect with its result
+         *
+         * @param slot - index of the attempt
+         * @param error - error of the connect, 0 if it completed
+         * @param onResult - callback invoked for the port
+         */
+        void finish(int slot, int error, const ResultCallback &onResult);
+        /**
+         * @brief Method to start the connects, that fit, wait for the sockets and finish the ready and the late ones
+         *
+         * @param timeoutMs - max time to wait in epoll, -1 to wait for the next deadline
+         * @param onResult - callback invoked for every finished port
+         */
+        void step(int timeoutMs, const ResultCallback &onResult);
+        /**
+         * @brief Method to finish the connects, that ran out of time
+         *
+         * @param onResult - callback invoked for the ports
+         */
+        void expire(const ResultCallback &onResult);
+        /**
+         * @brief Method to get the time until the next connect times out
+         *
+         * @return int - milliseconds, -1 if nothing is in flight
+         */
+        int nextTimeoutMs() const;
+
+        NetworkInterface sender4;               // the interface with its IPv4 address
+        NetworkInterface sender6;               // the interface with its IPv6 address
+        std::vector<NetworkAdress> targets;     // the targets
+        std::vector<int> ports;                 // the ports
+        int timeout;                            // timeout of a connect in ms
+        int socketLimit;                        // max connects in flight
+        int inFlight = 0;                       // connects in flight
+        int epollfd = -1;                       // the epoll set of the sockets
+        size_t next = 0;                        // next (port, target) pair, ports outer, targets inner
+        std::vector<Attempt> attempts;          // the connects in flight, by slot
+        std::vector<int> freeSlots;             // slots without a connect
+        RingQueue<std::pair<int, Clock::time_point>> expiries; // (slot, start) in start order, a reused slot is told apart by the start
+};
+
+/**
+ * @brief Function to open a non-blocking TCP socket bound to the interface and start its connect
+ *
+ * @param sender - the interface with an address of the IP version of the target
+ * @param target - the target
+ * @param port - the port
+ * @param fd - the socket, -1 if it could not be opened
+ * @param avoidProbePorts - true to keep the local port out of the source ports of the probes, while a SYN scan runs
+ * @return int - errno of socket() or connect(), 0 if connected already, EINPROGRESS while the handshake runs
+ */
+int startConnect(const NetworkInterface &sender, const NetworkAdress &target, int port, int &fd, bool avoidProbePorts = false);
+
+/**
+ * @brief Function to get the number of sockets a connect scan may open, raises the soft RLIMIT_NOFILE up to the hard one
+ *
+ * @return int - max connects in flight
+ */
+int connectSocketLimit();
+
+#endif // CONNECT_HPP
@@ -0,0 +1,142 @@
+/**
+ * @file daemon.hpp
+ * @brief Header file for the scan daemon (scan jobs over a Unix domain socket, all of them in one event loop)
+ * @author Martin Mendl <x247581>
+ * @date 2025-12-30
+ */
+
+#ifndef DAEMON_HPP
+#define DAEMON_HPP
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include "l4scan.hpp"
+#include "exclude.hpp"
+
+const uint32_t DAEMON_MAX_FRAME = 65536;    // largest frame of a client, in bytes past the length
+const size_t DAEMON_MAX_OUTPUT = 1 << 20;   // largest backlog of frames not read by a client, a client over it is dropped
+const int DAEMON_MAX_CLIENTS = 64;          // clients connected at once
+const int DAEMON_INITIAL_WINDOW = 256;      // global window of the probes in flight over all the jobs at the start
+const int DAEMON_MAX_WINDOW = 4096;         // largest global window over all the jobs
+
+/**
+ * @struct DaemonDefaults
+ * @brief Settings of the command line, a job overrides them
+ */
+struct DaemonDefaults {
+    std::string interfaceName;  // interface of the jobs
+    Backend backend;            // transport of the jobs
+    int timeout;                // timeout of a probe in ms
+    int hostProbes;             // max probes in flight to one host, 0 for the windows only
+    int bannerBytes;            // max bytes of a banner, 0 for no banners
+};
+
+/**
+ * @class ScanDaemon
+ * @brief Long running scanner, that takes scan jobs over a Unix domain socket
+ *
+ * A client sends a job as a frame (4 byte length in network order and the
+ * text) of "key value" lines, the daemon answers with frames: "accepted",
+ * a "result" per finished port, "done" at the end, or "error". A client
+ * runs one job at a time, several clients run theirs at once. The daemon is
+ * a client of the library: a request is turned into a ScanJob and added to
+ * a ScanRunner, driven from the loop of the daemon, that polls the
+ * listening socket, the clients and the sockets of all the jobs together.
+ * The jobs share the global window of the runner, so the daemon does not
+ * send more probes in flight than DAEMON_MAX_WINDOW, however many jobs run,
+ * and its cache of the interface list and the resolved domains. A client,
+ * that reads its frames slower than its job finishes ports, is dropped with
+ * its job, once DAEMON_MAX_OUTPUT bytes wait for it, so the backlog of a
+ * stalled client does not grow without a bound.
+ */
+class ScanDaemon {
+    public:
+        /**
+         * @brief Constructor for ScanDaemon class, binds and listens on the socket
+         *
+         * @param path - path of the Unix domain socket, a stale socket there is replaced
+         * @param defaults - settings of the jobs, that do not set their own
+         * @param exclusions - prefixes, that no job probes
+         */
+        ScanDaemon(const std::string &path, const DaemonDefaults &defaults, const ExcludeList &exclusions);
+        ScanDaemon(const ScanDaemon&) = delete;
+        ScanDaemon& operator=(const ScanDaemon&) = delete;
+        /**
+         * @brief Destructor for ScanDaemon class, closes the clients and removes the socket
+         */
+        ~ScanDaemon();
+
+        /**
+         * @brief Method to serve the clients, until SIGINT or SIGTERM
+         */
+        void run();
+
+    private:
+        /**
+         * @struct Job
+         * @brief Scan of a client
+         */
+        struct Job {
+            int id;                             // number of the job
+            ScanJob scan;                       // the scan
+            size_t results = 0;                 // finished ports
+            Clock::time_point startedAt;        // start of the job
+        };
+
+        /**
+         * @struct Client
+         * @brief Connection of a client
+         */
+        struct Client {
+            int fd = -1;                        // the connection
+            std::string input;                  // received bytes, not a whole frame yet
+            std::string output;                 // frames not sent yet
+            std::unique_ptr<Job> job;           // the running job, nullptr between the jobs
+            bool closing = false;               // the client left, the connection closes, once the job is stopped
+            bool inputClosed = false;           // the client shut its side down, its job runs on and the connection closes after the answers
+        };
+
+        /**
+         * @brief Method to accept the waiting clients
+         */
+        void acceptClients();
+        /**
+         * @brief Method to read from a client and start the job of a whole frame
+         *
+         * @param client - the client
+         */
+        void readClient(Client &client);
+        /**
+         * @brief Method to send the pending frames of a client
+         *
+         * @param client - the client
+         */
+        void writeClient(Client &client);
+        /**
+         * @brief Method to parse a job and start it
+         *
+         * @param client - the client of the job
+         * @param request - the text of the frame
+         */
+        void startJob(Client &client, const std::string &request);
+        /**
+         * @brief Method to queue a frame for the client, the client is dropped, if its backlog is full
+         *
+         * @param client - the client
+         * @param payload - the text of the frame
+         */
+        void sendFrame(Client &client, const std::string &payload);
+
+        std::string path;                                   // path of the socket
+        DaemonDefaults defaults;                            // settings of the jobs
+        const ExcludeList &exclusions;                      // prefixes, that no job probes
+        int listenfd = -1;                                  // the listening socket
+        std::list<Client> clients;                          // the clients, a job keeps the address of its client
+        ScanRunner runner;                                  // the running jobs, their window and cache
+        int nextJob = 1;                                    // number of the next job
+};
+
+#endif // DAEMON_HPP
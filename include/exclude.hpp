@@ -0,0 +1,145 @@
+/**
+ * @file exclude.hpp
+ * @brief Header file for the exclusion list (CIDR prefixes, that are never probed, in a compressed radix trie)
+ * @author Martin Mendl <x247581>
+ * @date 2025-12-02
+ */
+
+#ifndef EXCLUDE_HPP
+#define EXCLUDE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "utils.hpp"
+
+const int EXCLUDE_STRIDE = 16;     // bits of the address resolved by the direct table in front of the trie
+
+/**
+ * @struct PrefixNode
+ * @brief Node of the trie, two nodes per cache line
+ */
+struct alignas(32) PrefixNode {
+    uint64_t prefix[2];         // the prefix, the bits past the length are zero
+    uint32_t child[2];          // index of the child for the next bit 0 and 1, 0 for none
+    uint8_t length;             // length of the prefix in bits
+    bool excluded;              // the prefix is excluded, the node has no children then
+};
+
+static_assert(sizeof(PrefixNode) == 32, "PrefixNode is expected to be half a cache line");
+
+/**
+ * @class ExcludeList
+ * @brief Set of excluded CIDR prefixes of both IP versions, answers, if an address falls into one of them
+ *
+ * The prefixes are kept in a path compressed binary trie (one root per IP
+ * version) in a flat array of nodes, a node skips the bits its subtree
+ * shares, so the depth depends on the number of prefixes, not on their
+ * length. Only the question "is it excluded" is asked, so a prefix covering
+ * another one replaces its subtree and a lookup stops at the first excluded
+ * node, there is no longer match to look for. After the list is loaded,
+ * build() fills a direct table over the 16 bits past the prefix all the
+ * entries of the IP version share (the skip of an LC-trie or a poptrie, so
+ * IPv6 lists inside 2001::/16 get a useful table as well), a slot either
+ * answers right away or points to the node the walk continues from. A
+ * lookup in a list of 100k prefixes is a table read and a node visit or two.
+ */
+class ExcludeList {
+    public:
+        /**
+         * @brief Constructor for ExcludeList class, the list is empty
+         */
+        ExcludeList();
+
+        /**
+         * @brief Method to add a prefix
+         *
+         * @param cidr - the prefix (10.0.0.0/8, fd00::/8), an address without a length is a single host, host bits are ignored
+         * @return bool - false, if the text is no valid prefix
+         */
+        bool add(const std::string &cidr);
+        /**
+         * @brief Method to add a prefix in binary
+         *
+         * @param address - the address of the prefix
+         * @param length - the length of the prefix in bits
+         */
+        void add(const NetworkAdress &address, int length);
+        /**
+         * @brief Method to add the prefixes of a file, one per line, # starts a comment
+         *
+         * @param path - path of the file
+         */
+        void addFile(const std::string &path);
+        /**
+         * @brief Method to build the direct table, call it once all the prefixes are added
+         */
+        void build();
+        /**
+         * @brief Method to check, if the address is excluded
+         *
+         * @param address - the address
+         * @return bool - true, if a prefix of the list covers the address
+         */
+        bool contains(const NetworkAdress &address) const;
+        /**
+         * @brief Method to get the number of prefixes added
+         *
+         * @return size_t - number of prefixes
+         */
+        size_t size() const { return prefixes; };
+        /**
+         * @brief Method to check, if the list is empty
+         *
+         * @return bool - true, if no prefix was added
+         */
+        bool empty() const { return prefixes == 0; };
+
+    private:
+        /**
+         * @brief Method to add a new node
+         *
+         * @param prefix - the prefix, masked to the length
+         * @param length - length of the prefix
+         * @param excluded - the prefix is excluded
+         * @return uint32_t - index of the node
+         */
+        uint32_t addNode(const uint64_t prefix[2], int length, bool excluded);
+        /**
+         * @brief Method to insert the key of a prefix into the trie
+         *
+         * @param key - the address as a 128 bit key, masked to the length here
+         * @param length - length of the prefix
+         * @param ipv6 - IP version of the prefix
+         */
+        void insert(uint64_t key[2], int length, bool ipv6);
+        /**
+         * @brief Method to parse a prefix
+         *
+         * @param text - the prefix, not terminated
+         * @param size - length of the text
+         * @param address - the parsed address
+         * @param length - the parsed length of the prefix
+         * @return bool - false, if the text is no valid prefix
+         */
+        static bool parse(const char *text, size_t size, NetworkAdress &address, int &length);
+        /**
+         * @brief Method to fill the slots of the table, that the subtree of the node covers
+         *
+         * @param slots - the table of the IP version
+         * @param n - the node
+         * @param start - length of the prefix, the table starts after
+         */
+        void fillSlots(std::vector<uint32_t> &slots, uint32_t n, int start) const;
+
+        static constexpr uint32_t NONE = 0;             // nothing in the list covers the addresses
+        static constexpr uint32_t EXCLUDED = 0xffffffff; // a prefix covers all of the addresses
+
+        std::vector<PrefixNode> nodes;                  // the nodes, 0 is a sentinel, 1 and 2 the roots of IPv4 and IPv6
+        std::vector<uint32_t> table[2];                 // node the lookup continues from for the next 16 bits, per IP version
+        uint32_t tableStart[2] = {0, 0};                // node with the shared prefix, the table covers the bits past it
+        size_t prefixes = 0;                            // number of prefixes added
+};
+
+#endif // EXCLUDE_HPP
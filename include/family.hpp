@@ -0,0 +1,193 @@
+/**
+ * @file family.hpp
+ * @brief Header file for the address family traits (IPv4 and IPv6 selected at compile time)
+ * @author Martin Mendl <x247581>
+ * @date 2025-09-04
+ */
+
+#ifndef FAMILY_HPP
+#define FAMILY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include "utils.hpp"
+
+/**
+ * @struct pseudoHeaderIpv4
+ * @brief Represents the pseudo-header structure used in IPv4 for TCP and UDP checksum calculation.
+ */
+struct pseudoHeaderIpv4 {
+    u_int32_t sourceAdress;
+    u_int32_t destAdress;
+    u_int8_t tmp;
+    u_int8_t protocol;
+    u_int16_t tcp_length;
+};
+
+/**
+ * @struct pseudoHeaderIpv6
+ * @brief Represents the pseudo-header structure used in IPv6 for TCP checksum calculation.
+ */
+struct pseudoHeaderIpv6 {
+    struct in6_addr sourceAddress; // 128-bit source IP address
+    struct in6_addr destAddress;   // 128-bit destination IP address
+    uint32_t tcp_length;           // TCP segment length (excluding IPv6 header)
+    uint8_t zero[3];               // Three bytes of zero padding
+    uint8_t nextHeader;            // Next Header (should be IPPROTO_TCP)
+};
+
+/**
+ * @struct Ipv4
+ * @brief Address family traits of IPv4
+ *
+ * The sockets, packets, scanners and the scheduler are templates over the
+ * traits, so the IPv4 and IPv6 code is written once and the version is
+ * picked when the scan starts, not on every packet.
+ */
+struct Ipv4 {
+    using SockAddr = struct sockaddr_in;        // socket address
+    using Addr = struct in_addr;                // binary address
+    using PseudoHeader = pseudoHeaderIpv4;      // pseudo header of the TCP and UDP checksum
+
+    static constexpr int family = AF_INET;                  // address family
+    static constexpr IpVersion version = IpVersion::IPV4;   // IP version of the NetworkAdress
+    static constexpr Protocol icmp = Protocol::ICMP;        // protocol of the ICMP socket
+
+    /**
+     * @brief Method to get the binary address of the socket address
+     *
+     * @param sockAddr - the socket address
+     * @return const Addr& - the address
+     */
+    static const Addr& address(const SockAddr &sockAddr) { return sockAddr.sin_addr; };
+    /**
+     * @brief Method to get the port of the socket address
+     *
+     * @param sockAddr - the socket address
+     * @return uint16_t& - the port, network byte order
+     */
+    static uint16_t& port(SockAddr &sockAddr) { return sockAddr.sin_port; };
+    /**
+     * @brief Method to get the port of the socket address
+     *
+     * @param sockAddr - the socket address
+     * @return uint16_t - the port, network byte order
+     */
+    static uint16_t port(const SockAddr &sockAddr) { return sockAddr.sin_port; };
+    /**
+     * @brief Method to get the length of the IP header, raw IPv4 sockets deliver it with the packet
+     *
+     * @param packet - the packet from the raw socket
+     * @param size - size of the packet
+     * @return size_t - length of the header, 0 if the packet is shorter than its header
+     */
+    static size_t receivedHeaderLen(const char *packet, size_t size) {
+        if (size < sizeof(struct iphdr)) return 0;
+        size_t len = ((const struct iphdr*)packet)->ihl * 4;
+        return (len < sizeof(struct iphdr) || len > size) ? 0 : len;
+    };
+    /**
+     * @brief Method to fill the pseudo header of the checksum
+     *
+     * @param psh - the pseudo header
+     * @param sender - the sender address
+     * @param receiver - the receiver address
+     * @param protocol - protocol of the segment
+     * @param size - size of the segment
+     */
+    static void fillPseudoHeader(PseudoHeader &psh, const SockAddr &sender, const SockAddr &receiver, int protocol, size_t size) {
+        memset(&psh, 0, sizeof(psh));
+        psh.sourceAdress = sender.sin_addr.s_addr;
+        psh.destAdress = receiver.sin_addr.s_addr;
+        psh.protocol = protocol;
+        psh.tcp_length = htons(size);
+    };
+    /**
+     * @brief Method to write the IP header, for transports without the kernel IP layer
+     *
+     * @param buffer - the buffer to write the header to
+     * @param sender - the sender address
+     * @param receiver - the receiver address
+     * @param protocol - the protocol of the payload
+     * @param payloadSize - the size of the payload
+     * @return size_t - the size of the header
+     */
+    static size_t buildIpHeader(char *buffer, const SockAddr &sender, const SockAddr &receiver, int protocol, size_t payloadSize);
+};
+
+/**
+ * @struct Ipv6
+ * @brief Address family traits of IPv6
+ */
+struct Ipv6 {
+    using SockAddr = struct sockaddr_in6;       // socket address
+    using Addr = struct in6_addr;               // binary address
+    using PseudoHeader = pseudoHeaderIpv6;      // pseudo header of the TCP and UDP checksum
+
+    static constexpr int family = AF_INET6;                 // address family
+    static constexpr IpVersion version = IpVersion::IPV6;   // IP version of the NetworkAdress
+    static constexpr Protocol icmp = Protocol::ICMP6;       // protocol of the ICMP socket
+
+    /**
+     * @brief Method to get the binary address of the socket address
+     *
+     * @param sockAddr - the socket address
+     * @return const Addr& - the address
+     */
+    static const Addr& address(const SockAddr &sockAddr) { return sockAddr.sin6_addr; };
+    /**
+     * @brief Method to get the port of the socket address
+     *
+     * @param sockAddr - the socket address
+     * @return uint16_t& - the port, network byte order
+     */
+    static uint16_t& port(SockAddr &sockAddr) { return sockAddr.sin6_port; };
+    /**
+     * @brief Method to get the port of the socket address
+     *
+     * @param sockAddr - the socket address
+     * @return uint16_t - the port, network byte order
+     */
+    static uint16_t port(const SockAddr &sockAddr) { return sockAddr.sin6_port; };
+    /**
+     * @brief Method to get the length of the IP header, raw IPv6 sockets deliver only the payload
+     *
+     * @param packet - the packet from the raw socket
+     * @param size - size of the packet
+     * @return size_t - always 0
+     */
+    static size_t receivedHeaderLen(const char *packet, size_t size) { (void)packet; (void)size; return 0; };
+    /**
+     * @brief Method to fill the pseudo header of the checksum
+     *
+     * @param psh - the pseudo header
+     * @param sender - the sender address
+     * @param receiver - the receiver address
+     * @param protocol - protocol of the segment
+     * @param size - size of the segment
+     */
+    static void fillPseudoHeader(PseudoHeader &psh, const SockAddr &sender, const SockAddr &receiver, int protocol, size_t size) {
+        memset(&psh, 0, sizeof(psh));
+        psh.sourceAddress = sender.sin6_addr;
+        psh.destAddress = receiver.sin6_addr;
+        psh.tcp_length = htonl(size);
+        psh.nextHeader = protocol;
+    };
+    /**
+     * @brief Method to write the IP header, for transports without the kernel IP layer
+     *
+     * @param buffer - the buffer to write the header to
+     * @param sender - the sender address
+     * @param receiver - the receiver address
+     * @param protocol - the protocol of the payload
+     * @param payloadSize - the size of the payload
+     * @return size_t - the size of the header
+     */
+    static size_t buildIpHeader(char *buffer, const SockAddr &sender, const SockAddr &receiver, int protocol, size_t payloadSize);
+};
+
+#endif // FAMILY_HPP
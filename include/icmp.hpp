@@ -0,0 +1,55 @@
+/**
+ * @file icmp.hpp
+ * @brief Header file for the ICMP and ICMPv6 error parser (quoted headers of the probes)
+ * @author Martin Mendl <x247581>
+ * @date 2025-06-04
+ */
+
+#ifndef ICMP_HPP
+#define ICMP_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @struct IcmpError
+ * @brief ICMP error with the headers of the probe, that caused it
+ *
+ * An ICMP error quotes the IP header and at least the first 8 bytes of the
+ * offending packet, that is the ports of the TCP or UDP header. The quoted
+ * addresses and ports identify the probe, so a single ICMP socket can serve
+ * any number of probes in flight. The error can come from a router on the
+ * way, not only from the target, so the probe is found by the quoted
+ * destination and not by the source of the message.
+ */
+struct IcmpError {
+    int family;                     // address family of the message (AF_INET or AF_INET6)
+    int type;                       // ICMP type
+    int code;                       // ICMP code
+    int protocol;                   // protocol of the quoted probe (IPPROTO_TCP or IPPROTO_UDP)
+    unsigned char source[16];       // quoted source address (in_addr or in6_addr)
+    unsigned char target[16];       // quoted destination address, the probed host
+    uint16_t sourcePort;            // quoted source port, host byte order
+    uint16_t targetPort;            // quoted destination port, the probed port, host byte order
+};
+
+/**
+ * @brief Function to parse an ICMP destination unreachable message down to the quoted probe
+ *
+ * @param family - address family (AF_INET for ICMP, AF_INET6 for ICMPv6)
+ * @param icmp - the ICMP message, starting with the ICMP header
+ * @param len - length of the message
+ * @param error - parsed error
+ * @return bool - false, if it is not a destination unreachable quoting a TCP or UDP packet
+ */
+bool parseIcmpError(int family, const char *icmp, size_t len, IcmpError &error);
+
+/**
+ * @brief Function to check, if the error is a port unreachable (the port is closed)
+ *
+ * @param error - parsed error
+ * @return bool - true for ICMP type 3 code 3 and ICMPv6 type 1 code 4
+ */
+bool isPortUnreachable(const IcmpError &error);
+
+#endif // ICMP_HPP
@@ -0,0 +1,415 @@
+/**
+ * @file l4scan.hpp
+ * @brief Header file for the library interface of the scanner (scan jobs, their errors and results, and a runner of concurrent jobs)
+ * @author Martin Mendl <x247581>
+ * @date 2026-01-06
+ */
+
+#ifndef L4SCAN_HPP
+#define L4SCAN_HPP
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <poll.h>
+#include "portscan.hpp"
+#include "exclude.hpp"
+
+const int SCAN_RESOLVE_TTL_S = 300;         // time, a resolved domain is kept
+const int SCAN_INTERFACES_TTL_S = 60;       // time, the interface list is kept, an unknown name reloads it earlier
+const int RUNNER_INITIAL_WINDOW = 256;      // global window of the probes in flight over all the jobs of a runner at the start
+const int RUNNER_MAX_WINDOW = 4096;         // largest global window over all the jobs of a runner
+
+class ScanRunner;
+
+/**
+ * @struct ScanError
+ * @brief Error of a scan job, the library reports its errors instead of throwing or exiting
+ */
+struct ScanError {
+    std::string message;        // what went wrong, empty on success
+
+    /**
+     * @brief Method to check, if there is an error
+     *
+     * @return bool - true, if the job failed
+     */
+    explicit operator bool() const { return !message.empty(); };
+};
+
+/**
+ * @class ScanCache
+ * @brief Interface list and resolved domains, kept between the jobs
+ */
+class ScanCache {
+    public:
+        /**
+         * @brief Method to get the addresses of a target, the domains from the cache
+         *
+         * @param target - IP address or domain
+         * @param addresses - the addresses are appended
+         * @return ScanError - the error, empty on success
+         */
+        ScanError resolve(const std::string &target, std::vector<NetworkAdress> &addresses);
+        /**
+         * @brief Method to get the interface with its address of the IP version, the list from the cache
+         *
+         * @param name - name of the interface
+         * @param ipv4 - true for the IPv4 address
+         * @param interface - the interface, the address is invalid, if it has none of the version
+         * @return ScanError - the error, empty on success
+         */
+        ScanError findInterface(const std::string &name, bool ipv4, NetworkInterface &interface);
+
+    private:
+        /**
+         * @struct Resolved
+         * @brief Cached addresses of a domain
+         */
+        struct Resolved {
+            std::vector<NetworkAdress> addresses;   // the A and AAAA records
+            Clock::time_point expires;              // end of the cache entry
+        };
+
+        std::vector<NetworkInterface> interfaces;           // cached interface list
+        Clock::time_point interfacesLoaded;                 // time, the list was loaded
+        std::unordered_map<std::string, Resolved> domains;  // cached domains
+};
+
+/**
+ * @class ScanJob
+ * @brief Scan of a target list, set up with a builder and run to the end, step by step or by a runner
+ *
+ * The setters return the job, so a scan is one expression:
+ * ScanJob().interface("eth0").target("example.com").tcpPorts("1-1024").run().
+ * No method throws or exits: an invalid setting is kept as the error of the
+ * job and returned by start() or run(), a failure during the scan ends the
+ * job with its error. The results go to the onResult() callback as they
+ * come, or, without a callback, they are queued for next(). Several jobs
+ * run concurrently in a ScanRunner, a program with its own event loop calls
+ * sendDue(), addPollFds() and process() itself. A job and its runner are
+ * driven from one thread.
+ */
+class ScanJob {
+    public:
+        ScanJob() = default;
+        ScanJob(const ScanJob&) = delete;
+        ScanJob& operator=(const ScanJob&) = delete;
+        /**
+         * @brief Destructor for ScanJob class, cancels the scan and leaves its runner
+         */
+        ~ScanJob();
+
+        /**
+         * @brief Method to set the interface, the probes leave through
+         *
+         * @param name - name of the interface
+         * @return ScanJob& - the job
+         */
+        ScanJob& interface(const std::string &name);
+        /**
+         * @brief Method to add a target
+         *
+         * @param target - IP address or domain, every address of a domain is scanned
+         * @return ScanJob& - the job
+         */
+        ScanJob& target(const std::string &target);
+        /**
+         * @brief Method to add a resolved target
+         *
+         * @param target - the address
+         * @return ScanJob& - the job
+         */
+        ScanJob& target(const NetworkAdress &target);
+        /**
+         * @brief Method to add TCP ports
+         *
+         * @param ranges - ports, "22,80" or "1-1024"
+         * @return ScanJob& - the job
+         */
+        ScanJob& tcpPorts(const std::string &ranges);
+        /**
+         * @brief Method to add TCP ports
+         *
+         * @param ports - the ports
+         * @return ScanJob& - the job
+         */
+        ScanJob& tcpPorts(const std::vector<int> &ports);
+        /**
+         * @brief Method to add UDP ports
+         *
+         * @param ranges - ports, "53,161" or "1-1024"
+         * @return ScanJob& - the job
+         */
+        ScanJob& udpPorts(const std::string &ranges);
+        /**
+         * @brief Method to add UDP ports
+         *
+         * @param ports - the ports
+         * @return ScanJob& - the job
+         */
+        ScanJob& udpPorts(const std::vector<int> &ports);
+        /**
+         * @brief Method to add the most common TCP ports
+         *
+         * @param count - number of the ports
+         * @return ScanJob& - the job
+         */
+        ScanJob& topPorts(int count);
+        /**
+         * @brief Method to add the most common UDP ports
+         *
+         * @param count - number of the ports
+         * @return ScanJob& - the job
+         */
+        ScanJob& topUdpPorts(int count);
+        /**
+         * @brief Method to set the timeout of a probe
+         *
+         * @param ms - the timeout in ms, 5000 by default
+         * @return ScanJob& - the job
+         */
+        ScanJob& timeout(int ms);
+        /**
+         * @brief Method to set the transport of the probes
+         *
+         * @param backend - the transport, raw sockets by default
+         * @return ScanJob& - the job
+         */
+        ScanJob& backend(Backend backend);
+        /**
+         * @brief Method to cap the probes in flight to one host
+         *
+         * @param probes - max probes, 0 for the windows only
+         * @return ScanJob& - the job
+         */
+        ScanJob& hostProbes(int probes);
+        /**
+         * @brief Method to read the banners of the open TCP ports
+         *
+         * @param bytes - max bytes of a banner, 0 for no banners
+         * @return ScanJob& - the job
+         */
+        ScanJob& banner(int bytes);
+        /**
+         * @brief Method to add prefixes, that are never probed
+         *
+         * @param prefixes - comma separated CIDR prefixes of both IP versions
+         * @return ScanJob& - the job
+         */
+        ScanJob& exclude(const std::string &prefixes);
+        /**
+         * @brief Method to use a built exclusion list, it has to outlive the job
+         *
+         * @param exclusions - the list
+         * @return ScanJob& - the job
+         */
+        ScanJob& exclude(const ExcludeList &exclusions);
+        /**
+         * @brief Method to set the callback of the results, instead of the queue of next()
+         *
+         * @param callback - invoked for every finished port
+         * @return ScanJob& - the job
+         */
+        ScanJob& onResult(ResultCallback callback);
+
+        /**
+         * @brief Method to resolve the targets, open the sockets and send the first probes
+         *
+         * @param cache - interfaces and domains of earlier jobs, nullptr to load them
+         * @param shared - global window shared with other jobs, nullptr for a window of its own
+         * @return ScanError - the error, empty on success
+         */
+        ScanError start(ScanCache *cache = nullptr, ScanBudget *shared = nullptr);
+        /**
+         * @brief Method to scan to the end, the results go to the callback or the queue
+         *
+         * @return ScanError - the error, empty on success
+         */
+        ScanError run();
+        /**
+         * @brief Method to get the next result, the scan runs until there is one, a job in a runner only takes the queued ones
+         *
+         * @param result - the finished port
+         * @return bool - false at the end of the scan, on an error, or in a runner, if none is queued
+         */
+        bool next(PortResult &result);
+
+        /**
+         * @brief Method to send the probes, that are due
+         */
+        void sendDue();
+        /**
+         * @brief Method to add the sockets of the job to the poll set of a loop
+         *
+         * @param fds - the poll set
+         * @param timeoutMs - timeout of the poll, -1 for none, shortened to the next event of the job
+         */
+        void addPollFds(std::vector<struct pollfd> &fds, int &timeoutMs);
+        /**
+         * @brief Method to handle the answers and the expired probes after a wake up
+         */
+        void process();
+        /**
+         * @brief Method to check, if the job is over
+         *
+         * @return bool - true, if all the ports are finished or the job failed
+         */
+        bool finished() const;
+
+        /**
+         * @brief Method to get the error of the job
+         *
+         * @return const ScanError& - the error, empty on success
+         */
+        const ScanError& getError() const { return error; };
+        /**
+         * @brief Method to get the scanned addresses, known after start()
+         *
+         * @return const std::vector<NetworkAdress>& - the targets
+         */
+        const std::vector<NetworkAdress>& getTargets() const { return targets; };
+        /**
+         * @brief Method to get the addresses of the targets, that were excluded
+         *
+         * @return const std::vector<NetworkAdress>& - the excluded addresses
+         */
+        const std::vector<NetworkAdress>& getExcluded() const { return excluded; };
+        /**
+         * @brief Method to get the number of the ports of the scan
+         *
+         * @return size_t - targets times ports
+         */
+        size_t getPortCount() const { return targets.size() * (tcp.size() + udp.size()); };
+        /**
+         * @brief Method to get the number of answers, the kernel dropped during the scan
+         *
+         * @return uint64_t - the dropped packets
+         */
+        uint64_t getDrops() const;
+        /**
+         * @brief Method to get the global congestion window at the end of the scan
+         *
+         * @return int - probes in flight over all hosts
+         */
+        int getWindow() const;
+
+    private:
+        friend class ScanRunner;
+
+        /**
+         * @brief Method to check the settings, resolve the targets and build the scan
+         *
+         * @param cache - interfaces and domains of earlier jobs, nullptr to load them
+         * @return ScanError - the error, empty on success
+         */
+        ScanError prepare(ScanCache *cache);
+        /**
+         * @brief Method to drive a started job for one wake up of its own poll
+         */
+        void step();
+        /**
+         * @brief Method to end the job with an error, the scan is closed
+         *
+         * @param message - the error
+         */
+        void fail(const std::string &message);
+
+        std::string interfaceName;                  // interface of the probes
+        std::vector<std::string> names;             // targets to resolve
+        std::vector<NetworkAdress> addresses;       // resolved targets
+        std::vector<int> tcp;                       // TCP ports
+        std::vector<int> udp;                       // UDP ports
+        int probeTimeout = 5000;                    // timeout of a probe in ms
+        Backend transport = Backend::RAW;           // transport of the probes
+        int maxHostProbes = 0;                      // max probes in flight to one host, 0 for the windows only
+        int bannerBytes = 0;                        // max bytes of a banner, 0 for no banners
+        ExcludeList exclusions;                     // prefixes of exclude(prefixes)
+        const ExcludeList *sharedExclusions = nullptr; // list of exclude(list)
+        ResultCallback callback;                    // output of the results, empty for the queue
+
+        ScanError error;                            // first error of the settings or the scan
+        std::vector<NetworkAdress> targets;         // the scanned addresses
+        std::vector<NetworkAdress> excluded;        // the excluded addresses
+        std::unique_ptr<PortScan> scan;             // the scan, from start() to its end
+        std::deque<PortResult> queue;               // results not taken by next() yet
+        std::vector<struct pollfd> fds;             // poll set of step()
+        ScanRunner *runner = nullptr;               // the runner of the job
+        bool started = false;                       // start() was called
+};
+
+/**
+ * @class ScanRunner
+ * @brief Runner of concurrent scan jobs in one event loop
+ *
+ * The jobs added to a runner share its cache of interfaces and domains and
+ * its global window, so the probes in flight over all of them stay within
+ * the window, however many jobs run. The runner takes turns at sending
+ * first, so no job starves the others. It drives its jobs on its own with
+ * run(), or in the loop of the program with sendDue(), addPollFds() and
+ * process(), a finished job leaves the runner by itself.
+ */
+class ScanRunner {
+    public:
+        /**
+         * @brief Constructor for ScanRunner class
+         *
+         * @param initialWindow - global window of the probes in flight at the start
+         * @param maxWindow - largest global window
+         */
+        ScanRunner(int initialWindow = RUNNER_INITIAL_WINDOW, int maxWindow = RUNNER_MAX_WINDOW);
+        ScanRunner(const ScanRunner&) = delete;
+        ScanRunner& operator=(const ScanRunner&) = delete;
+        /**
+         * @brief Destructor for ScanRunner class, the jobs left are cancelled
+         */
+        ~ScanRunner();
+
+        /**
+         * @brief Method to start a job in the runner, it has to stay alive until it finishes or leaves
+         *
+         * @param job - the job
+         * @return ScanError - the error of the start, the job is not added then
+         */
+        ScanError add(ScanJob &job);
+        /**
+         * @brief Method to take a job out of the runner
+         *
+         * @param job - the job
+         */
+        void remove(ScanJob &job);
+        /**
+         * @brief Method to run the jobs to the end
+         */
+        void run();
+        /**
+         * @brief Method to send the probes of the jobs, that are due
+         */
+        void sendDue();
+        /**
+         * @brief Method to add the sockets of the jobs to the poll set of a loop
+         *
+         * @param fds - the poll set
+         * @param timeoutMs - timeout of the poll, -1 for none, shortened to the next event of the jobs
+         */
+        void addPollFds(std::vector<struct pollfd> &fds, int &timeoutMs);
+        /**
+         * @brief Method to handle the answers of the jobs after a wake up, the finished jobs leave
+         */
+        void process();
+        /**
+         * @brief Method to check, if the runner has no jobs
+         *
+         * @return bool - true, if all the jobs are finished
+         */
+        bool finished() const { return jobs.empty(); };
+
+    private:
+        std::vector<ScanJob*> jobs;     // the running jobs, the first one sends first
+        ScanCache cache;                // interfaces and domains of the jobs
+        ScanBudget budget;              // global window of the jobs
+};
+
+#endif // L4SCAN_HPP
@@ -13,26 +13,6 @@
 
 #define DATAGRAM_LEN 4096
 
-struct pseudoHeaderIpv4 {
-    u_int32_t sourceAdress;
-    u_int32_t destAdress;
-    u_int8_t tmp;
-    u_int8_t protocol;
-    u_int16_t tcp_length;
-};
-
-/**
- * @struct pseudoHeaderIpv6
- * @brief Represents the pseudo-header structure used in IPv6 for TCP checksum calculation.
- */
-struct pseudoHeaderIpv6 {
-    struct in6_addr sourceAddress; // 128-bit source IP address
-    struct in6_addr destAddress;   // 128-bit destination IP address
-    uint32_t tcp_length;           // TCP segment length (excluding IPv6 header)
-    uint8_t zero[3];               // Three bytes of zero padding
-    uint8_t nextHeader;            // Next Header (should be IPPROTO_TCP)
-};
-
 /**
  * @class Packet
  * @brief Base class for packet creation
@@ -40,23 +20,34 @@ struct pseudoHeaderIpv6 {
 class Packet {
     public:
         /**
-         * @brief Constructor for Packet class
+         * @brief Constructor for Packet class, building the packet in a buffer owned by the caller
+         * 
+         * @param buffer The buffer to build the packet in
+         * @param size The size of the buffer
          */
-        Packet();
+        Packet(char *buffer, size_t size);
         /**
          * @brief Destructor for Packet class
          */
         virtual ~Packet();
+        Packet(const Packet&) = delete;
+        Packet& operator=(const Packet&) = delete;
         /**
          * @brief Method to get the packet
          * 
          * @return char* The packet
          */
         char *getPacket() const { return datagram; };
+        /**
+         * @brief Method to get the size of the packet to send
+         * 
+         * @return size_t The size of the packet
+         */
+        size_t getSize() const { return datagramSize; };
     protected:
-        struct pseudoHeaderIpv4 psh;                // pseudo header for checksum calculation
-        struct pseudoHeaderIpv6 psh6;               // pseudo header for checksum calculation
-        char *datagram = new char[DATAGRAM_LEN]();  // packet buffer
+        char *datagram = nullptr;                   // packet buffer
+        size_t bufferSize = DATAGRAM_LEN;           // size of the packet buffer
+        size_t datagramSize = 0;                    // size of the packet to send
 };
 
 /**
@@ -66,57 +57,86 @@ class Packet {
 class SynPacket : public Packet {
     public:
         /**
-         * @brief Constructor for SynPacket class
+         * @brief Constructor for SynPacket class, building the packet in a buffer owned by the caller
+         * 
+         * @param buffer The buffer to build the packet in
+         * @param size The size of the buffer
          */
-        SynPacket();
+        SynPacket(char *buffer, size_t size);
         /**
          * @brief Destructor for SynPacket class
          */
         ~SynPacket() override {};
         /**
-         * @brief Method to create the SYN packet for IPv4
+         * @brief Method to create the SYN packet from raw addresses
          * 
-         * @param socket The socket to use
+         * @tparam Family The address family traits
+         * @param sender The sender address (with source port)
+         * @param receiver The receiver address (with destination port)
          */
-        void constructSynPacketIpv4(const SocketIpv4 &socket);
+        template <typename Family>
+        void constructSynPacket(const typename Family::SockAddr &sender, const typename Family::SockAddr &receiver);
+    private:
         /**
-         * @brief Method to create the SYN packet for IPv6
-         * 
-         * @param socket The socket to use
+         * @brief Method to fill in the fixed fields of the SYN header
          */
-        void constructSynPacketIpv6(const SocketIpv6 &socket);
-    private:
+        void setupHeader();
         struct tcphdr *tcph; // TCP header
 };
     
 /**
  * @class UDPpacket
  * @brief Class for creating UDP packets
+ *
+ * The packet carries the payload from the PayloadDatabase for its
+ * destination port, if there is one.
 */
 class UDPpacket : public Packet {
     public:
         /**
-         * @brief Constructor for UDPpacket class
+         * @brief Constructor for UDPpacket class, building the packet in a buffer owned by the caller
+         * 
+         * @param buffer The buffer to build the packet in
+         * @param size The size of the buffer
          */
-        UDPpacket();
+        UDPpacket(char *buffer, size_t size);
         /**
          * @brief Destructor for UDPpacket class
          */
         ~UDPpacket() override {};
         /**
-         * @brief Method to create the UDP packet for IPv4
+         * @brief Method to create the UDP packet from raw addresses
          * 
-         * @param socket The socket to use
+         * @tparam Family The address family traits
+         * @param sender The sender address (with source port)
+         * @param receiver The receiver address (with destination port)
          */
-        void constructUDPpacketIpv4(const SocketIpv4 &socket);
+        template <typename Family>
+        void constructUDPpacket(const typename Family::SockAddr &sender, const typename Family::SockAddr &receiver);
+    private:
         /**
-         * @brief Method to create the UDP packet for IPv6
+         * @brief Method to fill in the fixed fields of the UDP header
+         */
+        void setupHeader();
+        /**
+         * @brief Method to copy the payload for the destination port behind the header
          * 
-         * @param socket The socket to use
+         * @param port The destination port in network byte order
+         * @return size_t The size of the UDP header and the payload
          */
-        void constructUDPpacketIpv6(const SocketIpv6 &socket);
-    private:
+        size_t attachPayload(uint16_t port);
         struct udphdr *udph; // UDP header
 };
 
+/**
+ * @brief Function to write the Ethernet header
+ * 
+ * @param buffer The buffer to write the header to
+ * @param dst The destination MAC address
+ * @param src The source MAC address
+ * @param etherType The type of the payload (host byte order)
+ * @return size_t The size of the header
+ */
+size_t buildEthernetHeader(char *buffer, const unsigned char *dst, const unsigned char *src, uint16_t etherType);
+
 #endif // PACKETS_HPP
\ No newline at end of file
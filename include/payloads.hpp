@@ -0,0 +1,77 @@
+/**
+ * @file payloads.hpp
+ * @brief Header file for the protocol specific UDP probe payloads
+ * @author Martin Mendl <x247581>
+ * @date 2025-24-03
+ */
+
+#ifndef PAYLOADS_HPP
+#define PAYLOADS_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @struct Payload
+ * @brief View of a payload stored in the payload arena
+ */
+struct Payload {
+    const char *data;   // payload bytes, nullptr if there is no payload
+    size_t size;        // payload size
+};
+
+/**
+ * @class PayloadDatabase
+ * @brief Table of UDP payloads, that make the common services answer
+ *
+ * A bare UDP header gets no answer from DNS, NTP, SNMP and most other
+ * services, so an open port could only be told apart by the missing ICMP
+ * message. The table is built once, all the payloads are copied into one
+ * contiguous arena and looked up by the destination port.
+ */
+class PayloadDatabase {
+    public:
+        /**
+         * @brief Method to get the database, built on the first call
+         *
+         * @return const PayloadDatabase& - the database
+         */
+        static const PayloadDatabase& instance();
+
+        /**
+         * @brief Method to get the payload for the port
+         *
+         * @param port - destination port
+         * @return Payload - payload, empty if the port has none
+         */
+        Payload get(int port) const;
+
+        /**
+         * @brief Method to get the number of payloads
+         *
+         * @return size_t - number of payloads
+         */
+        size_t size() const { return entries.size(); };
+
+    private:
+        /**
+         * @brief Constructor for PayloadDatabase class, copies the built in payloads into the arena
+         */
+        PayloadDatabase();
+
+        /**
+         * @struct Entry
+         * @brief Position of a payload in the arena
+         */
+        struct Entry {
+            uint16_t port;      // destination port
+            uint32_t offset;    // offset in the arena
+            uint32_t size;      // payload size
+        };
+
+        std::vector<char> arena;        // all payloads back to back
+        std::vector<Entry> entries;     // entries sorted by port
+};
+
+#endif // PAYLOADS_HPP
@@ -0,0 +1,142 @@
+/**
+ * @file pool.hpp
+ * @brief Header file for the ring queues of the scan loop (no allocation per probe)
+ * @author Martin Mendl <x247581>
+ * @date 2025-10-04
+ */
+
+#ifndef POOL_HPP
+#define POOL_HPP
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class RingQueue
+ * @brief Double ended queue in one power of 2 ring, that only grows
+ *
+ * std::deque frees its blocks, as the front moves on, and allocates new
+ * ones at the back, so a queue with a steady size still calls the heap.
+ * The ring keeps its storage, it is reserved for the expected size up
+ * front and doubled only, if that is exceeded.
+ *
+ * @tparam T - type of the items, default constructible
+ */
+template <typename T>
+class RingQueue {
+    public:
+        /**
+         * @brief Method to make room for the number of items
+         *
+         * @param capacity - number of items
+         */
+        void reserve(size_t capacity) {
+            if (capacity <= items.size()) return;
+            size_t size = 16;
+            while (size < capacity) size *= 2;
+
+            std::vector<T> larger(size);
+            for (size_t i = 0; i < count; i++) larger[i] = (*this)[i];
+            items.swap(larger);
+            head = 0;
+        };
+        /**
+         * @brief Method to replace the items with the range
+         *
+         * @param first - start of the range
+         * @param last - end of the range
+         */
+        template <typename Iterator>
+        void assign(Iterator first, Iterator last) {
+            count = head = 0;
+            reserve(size_t(last - first));
+            for (; first != last; ++first) push_back(*first);
+        }
+        /**
+         * @brief Method to check, if the queue is empty
+         *
+         * @return bool - true, if there are no items
+         */
+        bool empty() const { return count == 0; };
+        /**
+         * @brief Method to get the number of items
+         *
+         * @return size_t - number of items
+         */
+        size_t size() const { return count; };
+        /**
+         * @brief Method to get the item at the position from the front
+         *
+         * @param index - position of the item
+         * @return T& - the item
+         */
+        T& operator[](size_t index) { return items[(head + index) & (items.size() - 1)]; };
+        /**
+         * @brief Method to get the item at the position from the front
+         *
+         * @param index - position of the item
+         * @return const T& - the item
+         */
+        const T& operator[](size_t index) const { return items[(head + index) & (items.size() - 1)]; };
+        /**
+         * @brief Method to get the first item
+         *
+         * @return T& - the item
+         */
+        T& front() { return items[head]; };
+        /**
+         * @brief Method to get the first item
+         *
+         * @return const T& - the item
+         */
+        const T& front() const { return items[head]; };
+        /**
+         * @brief Method to add the item at the back
+         *
+         * @param item - the item
+         */
+        void push_back(const T &item) {
+            if (count == items.size()) reserve(count + 1);
+            items[(head + count) & (items.size() - 1)] = item;
+            count++;
+        };
+        /**
+         * @brief Method to add the item at the front
+         *
+         * @param item - the item
+         */
+        void push_front(const T &item) {
+            if (count == items.size()) reserve(count + 1);
+            head = (head - 1) & (items.size() - 1);
+            items[head] = item;
+            count++;
+        };
+        /**
+         * @brief Method to remove the first item
+         */
+        void pop_front() {
+            head = (head + 1) & (items.size() - 1);
+            count--;
+        };
+        /**
+         * @brief Method to remove the first item equal to the value, the later items move forward
+         *
+         * @param value - the value
+         * @return bool - false, if there is no such item
+         */
+        bool erase(const T &value) {
+            size_t i = 0;
+            while (i < count && !((*this)[i] == value)) i++;
+            if (i == count) return false;
+            for (; i + 1 < count; i++) (*this)[i] = (*this)[i + 1];
+            count--;
+            return true;
+        };
+
+    private:
+        std::vector<T> items;       // the ring, power of 2 or empty
+        size_t head = 0;            // index of the first item
+        size_t count = 0;           // number of items
+};
+
+#endif // POOL_HPP
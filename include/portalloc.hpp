@@ -0,0 +1,86 @@
+/**
+ * @file portalloc.hpp
+ * @brief Header file for the source port allocator (unique ports for the probes in flight)
+ * @author Martin Mendl <x247581>
+ * @date 2025-11-04
+ */
+
+#ifndef PORTALLOC_HPP
+#define PORTALLOC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+
+const uint16_t SOURCE_PORT_BASE = 49152;    // first source port of the probes (IANA dynamic ports)
+const uint32_t SOURCE_PORT_COUNT = 16384;   // number of source ports, power of 2
+
+/**
+ * @class PortAllocator
+ * @brief Hands out source ports, that are not used by another probe in flight
+ *
+ * A port drawn with rand() for every probe collides with another one in
+ * flight after a few hundred probes (birthday bound), the reply is then
+ * taken for the wrong probe. The allocator walks a random permutation of
+ * the range (random start, random odd stride, so every port comes once per
+ * cycle) and skips the ports still set in the bitmap, a released port is
+ * handed out again only after the rest of the range. The bitmap words are
+ * atomic, acquire and release are safe from several threads without a lock.
+ */
+class PortAllocator {
+    public:
+        /**
+         * @brief Constructor for PortAllocator class
+         *
+         * @param base - first port of the range
+         * @param count - number of ports, power of 2, the range has to end at 65535 at the latest
+         */
+        PortAllocator(uint16_t base = SOURCE_PORT_BASE, uint32_t count = SOURCE_PORT_COUNT);
+        PortAllocator(const PortAllocator&) = delete;
+        PortAllocator& operator=(const PortAllocator&) = delete;
+
+        /**
+         * @brief Method to take a free port
+         *
+         * @return uint16_t - the port, 0 if all the ports are in use
+         */
+        uint16_t acquire();
+        /**
+         * @brief Method to give the port back
+         *
+         * @param port - port from acquire
+         */
+        void release(uint16_t port);
+        /**
+         * @brief Method to check, if the port belongs to the range of the allocator
+         *
+         * @param port - the port
+         * @return bool - true, if the port is in the range
+         */
+        bool contains(uint16_t port) const { return port >= base && uint32_t(port - base) < count; };
+        /**
+         * @brief Method to get the number of ports in use
+         *
+         * @return size_t - number of ports handed out and not released
+         */
+        size_t inUse() const { return used.load(std::memory_order_relaxed); };
+
+    private:
+        uint16_t base;                                  // first port of the range
+        uint32_t count;                                 // number of ports
+        uint32_t offset;                                // start of the permutation
+        uint32_t stride;                                // step of the permutation, odd
+        std::atomic<uint32_t> cursor{0};                // position in the permutation
+        std::atomic<size_t> used{0};                    // ports in use
+        std::vector<std::atomic<uint64_t>> words;       // bitmap of the ports in use
+};
+
+/**
+ * @brief Function to get the allocator shared by all the scans of the process
+ *
+ * @return PortAllocator& - the allocator
+ */
+PortAllocator& sourcePorts();
+
+#endif // PORTALLOC_HPP
@@ -0,0 +1,114 @@
+/**
+ * @file portscan.hpp
+ * @brief Header file for a whole port scan (the schedulers of both IP versions, the connect backend and the banner stage)
+ * @author Martin Mendl <x247581>
+ * @date 2025-12-30
+ */
+
+#ifndef PORTSCAN_HPP
+#define PORTSCAN_HPP
+
+#include <vector>
+#include <string>
+#include <optional>
+#include <poll.h>
+#include "scheduler.hpp"
+#include "connect.hpp"
+#include "banner.hpp"
+
+/**
+ * @class PortScan
+ * @brief Scan of the TCP and UDP ports of a target list, driven step by step
+ *
+ * The scan splits the targets by IP version and builds a Scheduler for
+ * each version with targets (or a ConnectScanner for the connect backend),
+ * the open TCP ports go through the banner stage, if it is on. run() drives
+ * it to the end, a loop, that drives several scans at once (the daemon),
+ * calls start(), sendDue(), addPollFds() and process() like the event loop
+ * of a dual stack scan, and the scans share the global window (ScanBudget).
+ */
+class PortScan {
+    public:
+        /**
+         * @brief Constructor for PortScan class
+         *
+         * @param sender4 - sender network interface with its IPv4 address
+         * @param sender6 - sender network interface with its IPv6 address
+         * @param targets - targets to scan, of both IP versions, each needs a sender address of its version (runtime_error otherwise)
+         * @param tcpPorts - TCP ports to scan
+         * @param udpPorts - UDP ports to scan
+         * @param timeout - timeout for a single probe
+         * @param backend - transport for the packets
+         * @param hostProbes - max probes in flight to one host, 0 for the windows only
+         * @param bannerBytes - max bytes of the banner read from the open TCP ports, 0 for no banners
+         * @param onResult - callback invoked for every finished port
+         */
+        PortScan(const NetworkInterface &sender4, const NetworkInterface &sender6, std::vector<NetworkAdress> targets, std::vector<int> tcpPorts, std::vector<int> udpPorts, int timeout, Backend backend, int hostProbes, int bannerBytes, ResultCallback onResult);
+        PortScan(const PortScan&) = delete;
+        PortScan& operator=(const PortScan&) = delete;
+
+        /**
+         * @brief Method to scan all the ports to the end
+         */
+        void run();
+        /**
+         * @brief Method to prepare the scan for a loop, that drives several scans
+         *
+         * @param shared - global window shared with the other scans, nullptr for a window of its own
+         */
+        void start(ScanBudget *shared = nullptr);
+        /**
+         * @brief Method to send the probes, that are due
+         */
+        void sendDue();
+        /**
+         * @brief Method to add the sockets of the scan to the poll set of the loop
+         *
+         * @param fds - the poll set
+         * @param timeoutMs - timeout of the poll, -1 for none, shortened to the next event of the scan
+         */
+        void addPollFds(std::vector<struct pollfd> &fds, int &timeoutMs);
+        /**
+         * @brief Method to handle the answers, the finished connects and banners and the expired probes after a wake up
+         */
+        void process();
+        /**
+         * @brief Method to check, if all the ports are finished
+         *
+         * @return bool - true, if nothing is pending, in flight or waiting for its banner
+         */
+        bool finished() const;
+        /**
+         * @brief Method to get the number of answers, the kernel dropped during the scan
+         *
+         * @return uint64_t - the dropped packets
+         */
+        uint64_t getDrops() const;
+        /**
+         * @brief Method to get the global congestion window at the end of the scan
+         *
+         * @return int - probes in flight over all hosts
+         */
+        int getWindow() const;
+
+    private:
+        ResultCallback onResult;                // the output of the scan
+        ResultCallback report;                  // the output of the schedulers, through the banner stage
+        std::optional<Scheduler<Ipv4>> ipv4;    // scheduler of the IPv4 targets
+        std::optional<Scheduler<Ipv6>> ipv6;    // scheduler of the IPv6 targets
+        std::optional<ConnectScanner> connects; // connect backend, instead of the schedulers
+        std::optional<BannerGrabber> banners;   // banner stage of the open TCP ports
+        ScanBudget budget;                      // global window of a dual stack scan
+        bool ipv4First = true;                  // the version, that sends first in the next pass
+};
+
+/**
+ * @brief Function to format a finished port as a line of the output
+ *
+ * @param result - the finished port
+ * @param showRtt - append the round trip time of an answered port
+ * @return std::string - the line, without the line end
+ */
+std::string formatResult(const PortResult &result, bool showRtt);
+
+#endif // PORTSCAN_HPP
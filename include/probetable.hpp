@@ -0,0 +1,152 @@
+/**
+ * @file probetable.hpp
+ * @brief Header file for the table of the probes in flight (open addressing, keyed by address, port and protocol)
+ * @author Martin Mendl <x247581>
+ * @date 2025-08-04
+ */
+
+#ifndef PROBETABLE_HPP
+#define PROBETABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <netinet/in.h>
+#include "sockets.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @struct Probe
+ * @brief Probe waiting for an answer
+ */
+struct Probe {
+    Protocol protocol;          // protocol of the probe
+    int port;                   // probed port
+    Clock::time_point sentAt;   // time, the probe was sent
+    int intervalMs;             // pacing interval of the host, when the probe was sent
+    uint16_t sourcePort;        // source port of the probe, unique among the probes in flight
+    int64_t sentNs;             // time, the probe was handed to the transport (CLOCK_REALTIME, ns), for the round trip time
+};
+
+/**
+ * @struct ProbeKey
+ * @brief Packed key of a probe, IPv4 addresses are stored IPv4 mapped (::ffff:a.b.c.d)
+ */
+struct ProbeKey {
+    uint64_t addr[2];           // the 128 bit address
+    uint16_t port;              // probed port
+    uint8_t protocol;           // the Protocol of the probe
+    uint8_t pad;                // keeps the key free of uninitialized bytes
+
+    bool operator==(const ProbeKey &other) const {
+        return addr[0] == other.addr[0] && addr[1] == other.addr[1] && port == other.port && protocol == other.protocol;
+    }
+};
+
+/**
+ * @brief Function to build the key of a probe
+ *
+ * @param family - address family (AF_INET or AF_INET6)
+ * @param addr - the target address (in_addr or in6_addr)
+ * @param port - probed port
+ * @param protocol - protocol of the probe
+ * @return ProbeKey - the key
+ */
+ProbeKey makeProbeKey(int family, const void *addr, int port, Protocol protocol);
+
+/**
+ * @struct ProbeEntry
+ * @brief Slot of the table, one cache line
+ */
+struct alignas(64) ProbeEntry {
+    ProbeKey key;               // key of the probe
+    Probe probe;                // the last probe sent to the port
+    uint32_t host;              // index of the host in the scheduler
+    uint16_t attempts;          // number of probes sent to the port
+    bool used;                  // the slot holds a port
+    bool inFlight;              // the probe waits for an answer, false while it waits for the retry
+};
+
+static_assert(sizeof(ProbeEntry) == 64, "ProbeEntry has to stay one cache line");
+
+/**
+ * @class ProbeTable
+ * @brief Flat hash table of the probed ports, linear probing over one array of cache line sized slots
+ *
+ * Every received packet is looked up by the address and port it comes from,
+ * so the lookup has to be cheap and must not allocate. The capacity is
+ * reserved up front from the probe window and kept at most half full, the
+ * table only grows, if the paced UDP probes outnumber the window. Deletion
+ * shifts the following entries of the cluster back, so there are no
+ * tombstones and the lookups do not slow down over a long scan.
+ */
+class ProbeTable {
+    public:
+        /**
+         * @brief Constructor for ProbeTable class
+         *
+         * @param capacity - number of entries to reserve room for
+         */
+        explicit ProbeTable(size_t capacity);
+        /**
+         * @brief Destructor for ProbeTable class
+         */
+        ~ProbeTable();
+        ProbeTable(const ProbeTable&) = delete;
+        ProbeTable& operator=(const ProbeTable&) = delete;
+
+        /**
+         * @brief Method to find the entry of the key
+         *
+         * @param key - key of the probe
+         * @return ProbeEntry* - the entry, nullptr if the key is not in the table
+         */
+        ProbeEntry* find(const ProbeKey &key);
+        /**
+         * @brief Method to find the entry of the key, or add an empty one
+         *
+         * The pointers to the other entries are invalidated, if the table grows.
+         *
+         * @param key - key of the probe
+         * @return ProbeEntry* - the entry
+         */
+        ProbeEntry* insert(const ProbeKey &key);
+        /**
+         * @brief Method to remove the entry, the pointers to the other entries are invalidated
+         *
+         * @param entry - entry from find or insert
+         */
+        void erase(ProbeEntry *entry);
+        /**
+         * @brief Method to get the number of entries
+         *
+         * @return size_t - number of entries
+         */
+        size_t size() const { return count; };
+        /**
+         * @brief Method to get the number of slots
+         *
+         * @return size_t - number of slots
+         */
+        size_t capacity() const { return mask + 1; };
+
+    private:
+        /**
+         * @brief Method to get the home slot of the key
+         *
+         * @param key - key of the probe
+         * @return size_t - index of the slot
+         */
+        size_t home(const ProbeKey &key) const;
+        /**
+         * @brief Method to double the number of slots and insert all the entries again
+         */
+        void grow();
+
+        ProbeEntry *slots = nullptr;    // the slots, power of 2
+        size_t mask = 0;                // number of slots - 1
+        size_t count = 0;               // number of used slots
+};
+
+#endif // PROBETABLE_HPP
@@ -0,0 +1,61 @@
+/**
+ * @file ring.hpp
+ * @brief Header file for the PACKET_MMAP transport (AF_PACKET socket with TPACKET_V3 rings)
+ * @author Martin Mendl <x247581>
+ * @date 2025-28-03
+ */
+
+#ifndef RING_HPP
+#define RING_HPP
+
+#include <cstddef>
+#include <functional>
+#include <linux/if_packet.h>
+#include "transport.hpp"
+
+const unsigned RING_BLOCK_SIZE = 1 << 20;   // size of a ring block
+const unsigned RING_RX_BLOCKS = 8;          // number of blocks in the receive ring
+const unsigned RING_TX_BLOCKS = 4;          // number of blocks in the transmit ring
+const unsigned RING_FRAME_SIZE = 2048;      // size of a transmit frame
+const unsigned RING_RETIRE_MS = 1;          // receive block is handed over after this time, even if not full
+
+/**
+ * @class PacketRing
+ * @brief Class for the AF_PACKET socket with memory mapped receive and transmit rings
+ *
+ * The probes are written straight into the mapped transmit frames and sent
+ * in batches with a single send() call, the replies are parsed in place from
+ * the receive blocks, without copying them out of the ring.
+ */
+class PacketRing : public LinkTransport {
+    public:
+        /**
+         * @brief Constructor for PacketRing class
+         *
+         * @param sender - sender network address
+         * @param link - interface, the ring is bound to
+         */
+        PacketRing(const NetworkAdress &sender, const LinkInfo &link);
+        /**
+         * @brief Destructor for PacketRing class
+         */
+        ~PacketRing() override;
+        void flush() override;
+        std::vector<int> getSockets() const override { return {sockfd}; };
+        void receive(const SegmentCallback &onSegment) override;
+        uint64_t getDrops() override;
+    protected:
+        char* nextFrame(size_t *size) override;
+        void commitFrame(size_t size) override;
+    private:
+        int sockfd = -1;                    // AF_PACKET socket
+        char *map = nullptr;                // mapped receive ring, followed by the transmit ring
+        size_t mapSize = 0;                 // size of the mapping
+        struct tpacket_req3 rxReq;          // receive ring layout
+        struct tpacket_req3 txReq;          // transmit ring layout
+        unsigned rxBlock = 0;               // next receive block to read
+        unsigned txFrame = 0;               // next transmit frame to write
+        unsigned txPending = 0;             // committed, not yet flushed frames
+};
+
+#endif // RING_HPP
@@ -0,0 +1,438 @@
+/**
+ * @file scheduler.hpp
+ * @brief Header file for the scan scheduler (asynchronous TCP and UDP probes over all targets)
+ * @author Martin Mendl <x247581>
+ * @date 2025-22-03
+ */
+
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <functional>
+#include <netinet/in.h>
+#include "scanning.hpp"
+#include "transport.hpp"
+#include "icmp.hpp"
+#include "probetable.hpp"
+#include "pool.hpp"
+#include "portalloc.hpp"
+
+const int PROBE_WINDOW = 64;            // max unpaced probes in flight per host and protocol
+const int INITIAL_PROBE_WINDOW = 8;     // congestion window of a host at the start, grows with the answers
+const int MIN_PROBE_WINDOW = 4;         // smallest window, losses and drops shrink it to
+const int DROP_RETRIES = 1;             // extra probes to a port, whose answer the kernel may have dropped
+const int TCP_MAX_PROBES = 2;           // SYN is sent twice, before the port is filtered
+const int UDP_MAX_PROBES = 3;           // max probes sent to a single UDP port
+const int UDP_DEFAULT_LIMIT_MS = 1000;  // assumed refill interval when it can not be measured (linux icmp_ratelimit)
+const int UDP_METER_SLACK_MS = 10;      // reply spacing above the send spacing, that counts as metering
+const int UDP_REPLY_HISTORY = 8;        // number of replies kept for the interval estimate
+
+/**
+ * @struct PortResult
+ * @brief Result of a finished port
+ */
+struct PortResult {
+    NetworkAdress target;       // scanned target
+    int port;                   // scanned port
+    Protocol protocol;          // protocol of the port (TCP or UDP)
+    ScanResult result;          // scan result
+    int icmpType = -1;          // type of the ICMP error, that decided the result, -1 if there was none
+    int icmpCode = -1;          // code of the ICMP error
+    int64_t rttNs = -1;         // round trip time of the answer, from the kernel timestamp, -1 if there was no answer
+    std::string banner = "";    // first bytes the service sent, filled by the banner stage
+};
+
+/**
+ * @brief Callback invoked for every finished port
+ *
+ * @param result - the finished port
+ */
+using ResultCallback = std::function<void(const PortResult &result)>;
+
+/**
+ * @struct Expiry
+ * @brief Deadline of a probe, the probes expire in the order they were sent
+ */
+struct Expiry {
+    ProbeKey key;               // key of the probe
+    Clock::time_point sentAt;   // time, the probe was sent, tells a retry from the first probe
+};
+
+/**
+ * @struct CongestionWindow
+ * @brief Number of probes allowed in flight, grown on answers and halved on loss (AIMD)
+ *
+ * Below the threshold every answer adds a probe (slow start), above it a
+ * whole window of answers adds one (congestion avoidance). A loss halves
+ * the window and sets the threshold to the result, at most once per probe
+ * timeout, as the losses of one burst show up over that time.
+ */
+struct CongestionWindow {
+    double size;                    // allowed probes in flight
+    double threshold;               // end of the slow start
+    int limit;                      // largest window
+    Clock::time_point lastDecrease; // time of the last halving
+
+    /**
+     * @brief Constructor for CongestionWindow struct
+     *
+     * @param initial - window at the start
+     * @param limit - largest window, also the first threshold
+     */
+    CongestionWindow(int initial = INITIAL_PROBE_WINDOW, int limit = PROBE_WINDOW) : size(initial), threshold(limit), limit(limit) {};
+    /**
+     * @brief Method to grow the window for an answer
+     */
+    void grow();
+    /**
+     * @brief Method to halve the window for a loss
+     *
+     * @param now - the current time
+     * @param timeoutMs - timeout of a probe, the window is halved at most once per timeout
+     * @return bool - false, if the window was halved for this loss already
+     */
+    bool shrink(Clock::time_point now, int timeoutMs);
+    /**
+     * @brief Method to check, if one more probe fits into the window
+     *
+     * @param inFlight - probes in flight
+     * @return bool - true, if the probe can be sent
+     */
+    bool allows(int inFlight) const { return inFlight < int(size); };
+};
+
+/**
+ * @struct ScanBudget
+ * @brief Global congestion window and the probes in flight, shared by the schedulers of one scan
+ */
+struct ScanBudget {
+    CongestionWindow window;    // probes in flight over all hosts
+    int inFlight = 0;           // probes in flight over all hosts
+
+    /**
+     * @brief Constructor for ScanBudget struct
+     *
+     * @param hosts - number of hosts of the scan, the window starts at the sum of their windows
+     */
+    explicit ScanBudget(size_t hosts = 0) : window(hosts * INITIAL_PROBE_WINDOW * 2, hosts * PROBE_WINDOW * 2) {};
+};
+
+/**
+ * @struct Host
+ * @brief Per target state of the scheduler
+ *
+ * @tparam Family - address family traits (Ipv4 or Ipv6)
+ */
+template <typename Family>
+struct Host {
+    NetworkAdress target;                               // target network address
+    typename Family::SockAddr addr;                     // target socket address
+    unsigned char mac[6];                               // MAC address of the next hop (link layer transports)
+    RingQueue<int> tcpPending;                          // TCP ports waiting to be probed
+    RingQueue<int> udpPending;                          // UDP ports waiting to be probed
+    int tcpInFlight = 0;                                // TCP probes waiting for an answer
+    int udpInFlight = 0;                                // UDP probes waiting for an answer
+    CongestionWindow window;                            // probes in flight per protocol, from the answers and losses of the host
+    RingQueue<std::pair<int64_t, int64_t>> replies;     // (sent, received) of the last unreachables, ns, received from the kernel timestamp
+    bool responsive = false;                            // host answered at least one UDP probe with ICMP
+    bool paced = false;                                 // UDP probes to the host are paced
+    int intervalMs = 0;                                 // UDP pacing interval
+    Clock::time_point nextSend;                         // earliest time of the next UDP probe
+};
+
+/**
+ * @class Scheduler
+ * @brief Class scheduling TCP and UDP probes over several targets of one IP version
+ *
+ * The SYN probes are kept in flight in a window per host and sent twice
+ * before the port is reported filtered.
+ *
+ * The windows are congestion windows (AIMD, as nmap does it), one per host
+ * and one over all hosts. They start small, grow with every answer and are
+ * halved, when a retransmitted probe is answered, as its first probe or the
+ * answer to it was lost. The global window takes the losses of every host.
+ * UDP retries to a paced host do not count, their first probe was silenced
+ * by the ICMP rate limit of the host, not by loss.
+ *
+ * All the targets are active at once, every pass sends at most one probe
+ * per host and protocol, so the timeouts of one host overlap with the
+ * answers of the others and N hosts take about as long as one. A cap on
+ * the probes in flight to one host (over both protocols) keeps a single
+ * target from getting the whole global window.
+ *
+ * Linux (and most other stacks) rate limit ICMP port unreachable messages,
+ * so a burst of UDP probes gets only a few answers and the silent rest would
+ * be reported as open. The scheduler watches the spacing of the unreachables,
+ * paces every host, that shows a limit, to the measured interval and probes
+ * the silent ports again. Probes are interleaved over all targets, so the
+ * limit of one host is hidden behind the others. UDP probes carry the payload
+ * for their port and a UDP answer from the service marks the port open.
+ *
+ * Every probe is sent from its own source port (PortAllocator), a reply or
+ * an ICMP error has to come back to the port of the last probe to the
+ * probed port, so an answer is never taken for another probe. The port is
+ * released, when the probe is answered or times out.
+ *
+ * The ICMP errors are matched to the probe by the quoted IP and UDP headers,
+ * a port unreachable closes the port, the other unreachable codes (host,
+ * network, administratively prohibited) mark it filtered. A SYN answered by
+ * any unreachable is filtered right away, without the retransmission and
+ * its timeout. The type and code of the error are kept with the result.
+ *
+ * The answers carry the receive timestamp of the kernel, the round trip
+ * time of a port is taken from it, not from the wake up of the scan, and
+ * the spacing of the unreachables is measured with it as well.
+ *
+ * The receive buffers are sized for the probes in flight. When the kernel
+ * drops received packets anyway (SO_RXQ_OVFL, ring statistics), the global
+ * window is halved and the probes, that time out after the drop, are sent once
+ * more, instead of reporting a dropped answer as filtered or open.
+ *
+ * When the transmit queue is full, the transport parks the probe and sends
+ * it again later (backpressure), the scheduler halves the global window as
+ * well, so a scan at full speed slows down instead of failing.
+ *
+ * The packets go through a Transport (raw IP sockets, PACKET_MMAP rings or
+ * an AF_XDP socket), the segments are built straight into its buffers.
+ *
+ * The scheduler is a template over the address family, it covers the
+ * targets of one IP version, so the version is not tested per packet. A
+ * dual stack scan drives an IPv4 and an IPv6 scheduler from one event loop
+ * (start, sendDue, addPollFds, process), their sockets are polled together
+ * and they share the global window (ScanBudget).
+ *
+ * All the queues are rings reserved in the constructor, so once the probes
+ * are running, the scan loop does not allocate.
+ *
+ * @tparam Family - address family traits (Ipv4 or Ipv6)
+ */
+template <typename Family>
+class Scheduler {
+    public:
+        /**
+         * @brief Constructor for Scheduler class
+         *
+         * @param sender - sender network interface
+         * @param targets - targets to scan, same IP version as the sender
+         * @param tcpPorts - TCP ports to scan on every target
+         * @param udpPorts - UDP ports to scan on every target
+         * @param timeout - timeout for a single probe
+         * @param backend - transport for the packets
+         * @param hostProbes - max probes in flight to one host over both protocols, 0 for the windows only
+         */
+        Scheduler(const NetworkInterface &sender, std::vector<NetworkAdress> targets, std::vector<int> tcpPorts, std::vector<int> udpPorts, int timeout, Backend backend, int hostProbes = 0);
+        /**
+         * @brief Destructor for Scheduler class
+         */
+        ~Scheduler();
+        /**
+         * @brief Method to scan all ports on all targets
+         *
+         * @param onResult - callback invoked for every finished port
+         */
+        void run(const ResultCallback &onResult);
+        /**
+         * @brief Method to prepare the scan for a loop, that drives several schedulers
+         *
+         * @param onResult - callback invoked for every finished port, it has to outlive the scan
+         */
+        void start(const ResultCallback &onResult);
+        /**
+         * @brief Method to send the probes, that are due
+         */
+        void sendDue();
+        /**
+         * @brief Method to compute the poll timeout until the next event
+         *
+         * @return int - timeout in milliseconds
+         */
+        int nextEventMs() const;
+        /**
+         * @brief Method to add the sockets of the transport to a poll set shared with other schedulers
+         *
+         * @param fds - the poll set
+         * @param timeoutMs - timeout of the poll, shortened, if the transport has to act earlier
+         */
+        void addPollFds(std::vector<struct pollfd> &fds, int &timeoutMs) { transport->addPollFds(fds, timeoutMs, txBlocked); };
+        /**
+         * @brief Method to handle the received packets and the expired probes after a wake up
+         *
+         * @param onResult - callback invoked for every finished port
+         */
+        void process(const ResultCallback &onResult);
+        /**
+         * @brief Method to share the global window with other schedulers, before the scan starts
+         *
+         * @param shared - the budget of the whole scan
+         */
+        void shareBudget(ScanBudget &shared) { budget = &shared; };
+        /**
+         * @brief Method to get the number of hosts
+         *
+         * @return size_t - scanned hosts
+         */
+        size_t hostCount() const { return hosts.size(); };
+        /**
+         * @brief Method to check, if all ports are finished
+         *
+         * @return bool - true, if nothing is pending or in flight
+         */
+        bool finished() const;
+        /**
+         * @brief Method to get the number of answers, the kernel dropped during the scan
+         *
+         * @return uint64_t - the dropped packets
+         */
+        uint64_t getDrops() const { return drops; };
+        /**
+         * @brief Method to get the global congestion window
+         *
+         * @return int - probes in flight over all hosts
+         */
+        int getWindow() const { return int(budget->window.size); };
+    private:
+        /**
+         * @brief Method to send a single probe
+         *
+         * @param host - target host
+         * @param protocol - protocol of the probe
+         * @param port - target port
+         * @return bool - false, if the transport can not take the probe now
+         */
+        bool sendProbe(Host<Family> &host, Protocol protocol, int port);
+        /**
+         * @brief Method to check, if the windows allow one more probe to the host
+         *
+         * @param host - target host
+         * @param protocol - protocol of the probe
+         * @return bool - true, if the probe fits into the host cap, the host and the global window
+         */
+        bool windowOpen(const Host<Family> &host, Protocol protocol) const;
+        /**
+         * @brief Method to adjust the congestion windows for an answer
+         *
+         * @param host - host of the answered probe
+         * @param lost - the answer came to a retransmission, an earlier probe or its answer was lost
+         */
+        void onAnswer(Host<Family> &host, bool lost);
+        /**
+         * @brief Method to write the TCP or UDP header (and payload) of the probe
+         *
+         * @param buffer - buffer to write to
+         * @param size - size of the buffer
+         * @param host - target host
+         * @param protocol - protocol of the probe
+         * @param port - target port
+         * @param sourcePort - source port of the probe
+         * @return size_t - size of the written segment
+         */
+        size_t buildSegment(char *buffer, size_t size, const Host<Family> &host, Protocol protocol, int port, uint16_t sourcePort);
+        /**
+         * @brief Method to handle the transport layer of a received packet
+         *
+         * @param source - source address of the packet (in_addr or in6_addr)
+         * @param protocol - protocol of the segment
+         * @param segment - the segment
+         * @param size - size of the segment
+         * @param receivedNs - receive timestamp of the segment
+         * @param onResult - callback invoked for every finished port
+         */
+        void handleSegment(const void *source, int protocol, const char *segment, size_t size, int64_t receivedNs, const ResultCallback &onResult);
+        /**
+         * @brief Method to handle an ICMP error quoting one of the probes
+         *
+         * @param error - parsed error
+         * @param receivedNs - receive timestamp of the error
+         * @param onResult - callback invoked for every finished port
+         */
+        void handleIcmpError(const IcmpError &error, int64_t receivedNs, const ResultCallback &onResult);
+        /**
+         * @brief Method to handle a port unreachable message
+         *
+         * @param entry - entry of the probed port
+         * @param error - the message, quoting the probed port
+         * @param receivedNs - receive timestamp of the message
+         * @param onResult - callback invoked for every finished port
+         */
+        void handleUnreachable(ProbeEntry *entry, const IcmpError &error, int64_t receivedNs, const ResultCallback &onResult);
+        /**
+         * @brief Method to finish the port, report it and remove its entry
+         *
+         * @param entry - entry of the port, in flight or waiting for the retry
+         * @param result - scan result
+         * @param onResult - callback invoked for every finished port
+         * @param error - ICMP error, that decided the result, nullptr if there was none
+         * @param receivedNs - receive timestamp of the answer, 0 if the port was not answered
+         */
+        void finishPort(ProbeEntry *entry, ScanResult result, const ResultCallback &onResult, const IcmpError *error = nullptr, int64_t receivedNs = 0);
+        /**
+         * @brief Method to handle the probes, that timed out
+         *
+         * @param onResult - callback invoked for every finished port
+         */
+        void expireProbes(const ResultCallback &onResult);
+        /**
+         * @brief Method to check the drop counters of the transport, halves the global window on new drops
+         *
+         * @param now - the current time
+         */
+        void checkDrops(Clock::time_point now);
+        /**
+         * @brief Method to check the backpressure of the transport, halves the global window, when the transmit queue was full
+         *
+         * @param now - the current time
+         */
+        void checkBackpressure(Clock::time_point now);
+        /**
+         * @brief Method to build the key of a probe to the host
+         *
+         * @param host - target host
+         * @param protocol - protocol of the probe
+         * @param port - target port
+         * @return ProbeKey - the key
+         */
+        ProbeKey keyOf(const Host<Family> &host, Protocol protocol, int port) const;
+        /**
+         * @brief Method to estimate the ICMP refill interval of the host
+         *
+         * @param host - target host
+         * @return int - interval in milliseconds, 0 if there are not enough replies
+         */
+        int estimateInterval(const Host<Family> &host) const;
+        /**
+         * @brief Method to start pacing the UDP probes to the host
+         *
+         * @param host - target host
+         */
+        void startPacing(Host<Family> &host);
+        /**
+         * @brief Method to give the source port of the probe back, once the port is finished or probed again
+         *
+         * @param entry - entry of the probe
+         */
+        void releasePort(ProbeEntry *entry);
+
+        NetworkInterface sender;                // sender network interface
+        typename Family::SockAddr senderAddr;   // sender socket address, the port is set per probe
+        PortAllocator &ports = sourcePorts();   // source ports of the probes
+        std::vector<Host<Family>> hosts;        // scanned hosts
+        ProbeTable *probes = nullptr;           // probed ports, in flight or waiting for the retry
+        RingQueue<Expiry> expiries;             // deadlines of the probes in flight, oldest first
+        Transport* transport = nullptr;         // transport for the packets
+        bool txBlocked = false;                 // transport can not take more packets
+        bool portsBlocked = false;              // all source ports are in flight
+        ScanBudget ownBudget;                   // global window of a scan of one IP version
+        ScanBudget *budget = &ownBudget;        // global window, shared in a dual stack scan
+        SegmentCallback onSegment;              // handler of the received segments, built in start
+        int hostCap = 2 * PROBE_WINDOW;         // max probes in flight to one host
+        uint64_t drops = 0;                     // answers, the kernel dropped
+        Clock::time_point lastDrop;             // time, the last drop was noticed
+        uint64_t backpressure = 0;              // sends, the transport had no room for
+        size_t nextHost = 0;                    // round robin index of the next host
+        int timeout;                            // timeout for a single probe
+};
+
+#endif // SCHEDULER_HPP
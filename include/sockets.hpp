@@ -11,17 +11,26 @@
 #include <iostream>
 #include <string>
 #include "utils.hpp"
+#include "family.hpp"
+
+const int TX_BACKOFF_MIN_MS = 1;    // first pause after the kernel had no room for a packet
+const int TX_BACKOFF_MAX_MS = 16;   // longest pause between the retries of a packet
 
 /**
- * @enum Protocol
- * @brief Enumeration for different protocols
+ * @brief Function to check, if a failed send only means, that the kernel has no room for the packet now
+ *
+ * @param error - errno of the send
+ * @return bool - true for ENOBUFS (full qdisc or device queue) and EAGAIN (full socket buffer)
  */
-enum class Protocol {
-    TCP,
-    UDP,
-    ICMP,
-    ICMP6
-};
+bool isBackpressure(int error);
+
+/**
+ * @brief Function to get the next pause of the retries, doubled up to TX_BACKOFF_MAX_MS
+ *
+ * @param backoffMs - the last pause, 0 for the first retry
+ * @return int - the pause in milliseconds
+ */
+int nextBackoffMs(int backoffMs);
 
 /**
  * @brief Function to return the protocol
@@ -40,8 +49,11 @@ class Socket {
         /**
          * @class Socket
          * @brief Constructor for Socket class
+         *
+         * @param sender - sender network interface, the socket is bound to it
+         * @param receiver - receiver network address
         */
-        Socket(NetworkAdress sender, NetworkAdress receiver);
+        Socket(const NetworkInterface &sender, const NetworkAdress &receiver);
 
         /**
          * @brief Method to get the socket
@@ -88,7 +100,7 @@ class Socket {
         virtual void setupNetworkAdress() {};
 
         int sockfd;                 // socket   
-        NetworkAdress sender;       // sender network address
+        NetworkInterface sender;    // sender network interface and address
         NetworkAdress receiver;     // receiver network address
         struct timeval timeout;     // timeout
         bool nonBlocking = false;   // non-blocking flag 
@@ -96,38 +108,43 @@ class Socket {
 };
 
 /**
- * @class SocketIpv4
- * @brief Class for creating IPv4 sockets
+ * @class RawSocket
+ * @brief Class for creating raw sockets of the address family
+ *
+ * @tparam Family - address family traits (Ipv4 or Ipv6)
  */
-class SocketIpv4 : public Socket {
+template <typename Family>
+class RawSocket : public Socket {
     public:
+        using SockAddr = typename Family::SockAddr;
+
         /**
-         * @brief Constructor for SocketIpv4 class
+         * @brief Constructor for RawSocket class
          * 
-         * @param sender - sender network address
+         * @param sender - sender network interface
          * @param receiver - receiver network address
          * @param protocol - protocol
          */
-        SocketIpv4(NetworkAdress sender, NetworkAdress receiver, Protocol protocol);
+        RawSocket(const NetworkInterface &sender, const NetworkAdress &receiver, Protocol protocol);
 
         /**
-         * @brief Destructor for SocketIpv4 class
+         * @brief Destructor for RawSocket class
          */
-        ~SocketIpv4() override {};
+        ~RawSocket() override {};
 
         /**
          * @brief Method to get the sender address
          * 
-         * @return struct sockaddr_in The sender address
+         * @return SockAddr The sender address
          */
-        struct sockaddr_in getSender() const { return senderAddr; };
+        const SockAddr& getSender() const { return senderAddr; };
 
         /**
          * @brief Method to get the receiver address
          * 
-         * @return struct sockaddr_in The receiver address
+         * @return SockAddr The receiver address
          */
-        struct sockaddr_in getReceiver() const { return receiverAddr; };
+        const SockAddr& getReceiver() const { return receiverAddr; };
     private:
         void setupNetworkAdress() override {};
         /**
@@ -137,55 +154,13 @@ class SocketIpv4 : public Socket {
          * @param sockAddr The socket address
          * @return void
         */
-        void setupNetworkAdress(NetworkAdress &adress, struct sockaddr_in &sockAddr);
+        void setupNetworkAdress(const NetworkAdress &adress, SockAddr &sockAddr);
 
-        struct sockaddr_in senderAddr;    // sender address
-        struct sockaddr_in receiverAddr;  // receiver address
+        SockAddr senderAddr;    // sender address
+        SockAddr receiverAddr;  // receiver address
 };
 
-/**
- * @class SocketIpv6
- * @brief Class for creating IPv6 sockets
-*/
-class SocketIpv6 : public Socket {
-    public:
-        /**
-         * @brief Constructor for SocketIpv6 class
-         * 
-         * @param sender - sender network address
-         * @param receiver - receiver network address
-         * @param protocol - protocol
-        */
-        SocketIpv6(NetworkAdress sender, NetworkAdress receiver, Protocol protocol);
-
-        /**
-         * @brief Destructor for SocketIpv6 class
-        */
-        ~SocketIpv6() override {};
-
-        /**
-         * @brief Method to get the sender address
-         */
-        struct sockaddr_in6 getSender() const { return senderAddr; };
-
-        /**
-         * @brief Method to get the receiver address
-         */
-        struct sockaddr_in6 getReceiver() const { return receiverAddr; };
-
-    private:
-        void setupNetworkAdress() override {};
-        /**
-         * @brief Method to set the network adress for the socket
-         * 
-         * @param adress The network address
-         * @param sockAddr The socket address
-         * @return void
-        */
-        void setupNetworkAdress(NetworkAdress &adress, struct sockaddr_in6 &sockAddr);
-
-        struct sockaddr_in6 senderAddr;     // sender address
-        struct sockaddr_in6 receiverAddr;   // receiver address
-};
+using SocketIpv4 = RawSocket<Ipv4>;     // raw IPv4 socket
+using SocketIpv6 = RawSocket<Ipv6>;     // raw IPv6 socket
 
 #endif // SOCKETS_HPP
\ No newline at end of file
@@ -0,0 +1,46 @@
+/**
+ * @file topports.hpp
+ * @brief Header file for the built in port profiles (the most common ports, in the order of their hit rate)
+ * @author Martin Mendl <x247581>
+ * @date 2025-12-09
+ */
+
+#ifndef TOPPORTS_HPP
+#define TOPPORTS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "utils.hpp"
+
+/**
+ * @struct PortFrequency
+ * @brief Port of the frequency table with its hit rate
+ */
+struct PortFrequency {
+    uint16_t port;      // the port
+    uint32_t hits;      // hosts per million, the port was found open on
+};
+
+/**
+ * @brief Function to get the number of ports in the profile of the protocol
+ *
+ * @param protocol - Protocol::TCP or Protocol::UDP
+ * @return size_t - number of ports, the largest count topPorts() takes
+ */
+size_t topPortCount(Protocol protocol);
+
+/**
+ * @brief Function to get the most common ports of the protocol, the most common first
+ *
+ * The ports come from a table sorted by hit rate at compile time, so the
+ * scan probes the ports, that are most likely open, first. The table is
+ * generated from nmap-services by genTopPorts.py.
+ *
+ * @param protocol - Protocol::TCP or Protocol::UDP
+ * @param count - number of ports, at most topPortCount()
+ * @return std::vector<int> - the ports in the order of their hit rate
+ */
+std::vector<int> topPorts(Protocol protocol, size_t count);
+
+#endif // TOPPORTS_HPP
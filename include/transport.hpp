@@ -0,0 +1,364 @@
+/**
+ * @file transport.hpp
+ * @brief Header file for the packet transports (raw sockets, link layer rings)
+ * @author Martin Mendl <x247581>
+ * @date 2025-30-03
+ */
+
+#ifndef TRANSPORT_HPP
+#define TRANSPORT_HPP
+
+#include <vector>
+#include <cstddef>
+#include <functional>
+#include <chrono>
+#include <poll.h>
+#include <cstdint>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "packets.hpp"
+#include "sockets.hpp"
+#include "utils.hpp"
+
+/**
+ * @brief Callback invoked for every received transport layer segment
+ *
+ * @param family - address family of the source (AF_INET or AF_INET6)
+ * @param source - source address (in_addr or in6_addr)
+ * @param protocol - IP protocol of the segment
+ * @param segment - the segment, starting with the TCP, UDP or ICMP header
+ * @param size - size of the segment
+ * @param receivedNs - time the packet was received (CLOCK_REALTIME, ns), from the kernel if it stamps the packets
+ */
+using SegmentCallback = std::function<void(int family, const void *source, int protocol, const char *segment, size_t size, int64_t receivedNs)>;
+
+const size_t TIMESTAMP_CONTROL_LEN = 128;   // control buffer of a receive, room for the SCM_TIMESTAMPING and SO_RXQ_OVFL messages
+const size_t RCVBUF_PER_PACKET = 2048;      // receive buffer charged for a small packet (skb truesize)
+const size_t RCVBUF_MAX = 64 << 20;         // largest receive buffer asked for
+
+/**
+ * @brief Function to get the time of the clock, the kernel stamps the packets with
+ *
+ * @return int64_t - CLOCK_REALTIME in nanoseconds
+ */
+int64_t wallClockNs();
+
+/**
+ * @brief Function to ask the kernel for receive timestamps on the socket (SO_TIMESTAMPING)
+ *
+ * Only software timestamps are asked for, they are taken from CLOCK_REALTIME,
+ * when the packet enters the stack, like the send time of the probe. A
+ * hardware timestamp comes from the clock of the NIC (PHC), which is not
+ * synchronized with CLOCK_REALTIME, unless a PTP daemon does so.
+ *
+ * @param sockfd - the socket
+ * @return bool - false, if the kernel does not support it
+ */
+bool enableTimestamps(int sockfd);
+
+/**
+ * @brief Function to ask the kernel for the drop counter of the socket with every packet (SO_RXQ_OVFL)
+ *
+ * @param sockfd - the socket
+ */
+void enableDropCounter(int sockfd);
+
+/**
+ * @brief Function to size the receive buffer of the socket for the packets in flight
+ *
+ * SO_RCVBUFFORCE is tried first, it goes past net.core.rmem_max as root.
+ * The buffer is never made smaller, than it is.
+ *
+ * @param sockfd - the socket
+ * @param packets - number of packets, that can arrive at once
+ */
+void sizeReceiveBuffer(int sockfd, size_t packets);
+
+/**
+ * @brief Function to read the control messages of a received packet
+ *
+ * @param msg - message of the recvmsg, with the control data
+ * @param receivedNs - set to the software timestamp, 0 if the packet has none
+ * @param dropCounter - set to the drop counter of the socket, if the packet carries it (it does, once there were drops)
+ */
+void readControl(const struct msghdr *msg, int64_t &receivedNs, uint32_t &dropCounter);
+
+/**
+ * @class Transport
+ * @brief Base class for the packet transports
+ *
+ * The scheduler builds the TCP or UDP segment straight into the buffer
+ * returned by reserve() and hands it over with commit(), the transport adds
+ * whatever lower layers it has to. The received packets are stripped down to
+ * the transport layer segment, so the scheduler does not care, how the packet
+ * came in.
+ *
+ * A send, that fails for lack of room in the kernel (ENOBUFS, EAGAIN), is
+ * not an error. The transport parks the packet and sends it again, once the
+ * socket reports POLLOUT or after a short pause, reserve() returns nullptr
+ * meanwhile, so the scheduler holds the next probes back. The events are
+ * counted (getBackpressure), the scheduler slows down on them.
+ */
+class Transport {
+    public:
+        /**
+         * @brief Destructor for Transport class
+         */
+        virtual ~Transport() {};
+        /**
+         * @brief Method to resolve the link layer address of the target
+         *
+         * @param target - the target
+         * @param mac - set to the MAC address of the next hop
+         */
+        virtual void resolve(const NetworkAdress &target, unsigned char mac[6]) { (void)target; (void)mac; };
+        /**
+         * @brief Method to get the buffer for the next segment
+         *
+         * @param size - set to the space available for the segment
+         * @return char* - the buffer, nullptr if the transport can not take a packet now
+         */
+        virtual char* reserve(size_t *size) = 0;
+        /**
+         * @brief Method to send the segment written to the reserved buffer
+         *
+         * @param target - target address (sockaddr_in or sockaddr_in6)
+         * @param mac - MAC address of the next hop
+         * @param protocol - IP protocol of the segment
+         * @param size - size of the segment
+         */
+        virtual void commit(const struct sockaddr *target, const unsigned char *mac, int protocol, size_t size) = 0;
+        /**
+         * @brief Method to push the committed packets to the kernel
+         */
+        virtual void flush() {};
+        /**
+         * @brief Method to get the sockets to poll
+         *
+         * @return std::vector<int> - the sockets
+         */
+        virtual std::vector<int> getSockets() const = 0;
+        /**
+         * @brief Method to wait for packets, polls the sockets of the transport
+         *
+         * @param timeoutMs - max time to wait
+         * @param wantSend - wake up also, when the transport can take packets again
+         */
+        virtual void wait(int timeoutMs, bool wantSend);
+        /**
+         * @brief Method to add the sockets of the transport to a poll set shared with other transports
+         *
+         * @param fds - the poll set
+         * @param timeoutMs - timeout of the poll, shortened, if the transport has to act earlier
+         * @param wantSend - wake up also, when the transport can take packets again
+         */
+        virtual void addPollFds(std::vector<struct pollfd> &fds, int &timeoutMs, bool wantSend);
+        /**
+         * @brief Method to read all the waiting packets
+         *
+         * @param onSegment - callback invoked for every segment
+         */
+        virtual void receive(const SegmentCallback &onSegment) = 0;
+        /**
+         * @brief Method to make room for the answers to the probes in flight
+         *
+         * @param packets - number of answers, that can arrive at once
+         */
+        virtual void setReceiveWindow(size_t packets) { (void)packets; };
+        /**
+         * @brief Method to note, that the source port belongs to a probe of the scan, or no longer does
+         *
+         * @param port - source port of the probe
+         * @param inFlight - true, when the probe is sent, false, when its port is given back (the port finished or probed again)
+         */
+        virtual void claimPort(uint16_t port, bool inFlight) { (void)port; (void)inFlight; };
+        /**
+         * @brief Method to get the number of received packets, the kernel dropped so far
+         *
+         * @return uint64_t - the dropped packets
+         */
+        virtual uint64_t getDrops() { return drops; };
+        /**
+         * @brief Method to get the number of sends, the kernel had no room for
+         *
+         * @return uint64_t - the backpressure events
+         */
+        uint64_t getBackpressure() const { return backpressure; };
+    protected:
+        /**
+         * @brief Method to set the events of the sockets for the next poll
+         *
+         * @param timeoutMs - timeout of the poll, shortened to the retry of a parked packet
+         * @param wantSend - wake up also, when the transport can take packets again
+         */
+        void preparePoll(int &timeoutMs, bool wantSend);
+        /**
+         * @brief Method to note, that the kernel had no room for a packet, and to set the time of the retry
+         *
+         * @param error - errno of the send, EAGAIN waits for POLLOUT, ENOBUFS for the growing pause
+         */
+        void holdBack(int error);
+        /**
+         * @brief Method to check, if the parked packets can be sent again
+         *
+         * @return bool - true, if the pause is over
+         */
+        bool retryDue() const { return std::chrono::steady_clock::now() >= retryAt; };
+        /**
+         * @brief Method to shorten the wait to the retry of the parked packets
+         *
+         * @param timeoutMs - the wanted timeout
+         * @return int - the timeout, at most until the retry
+         */
+        int retryTimeoutMs(int timeoutMs) const;
+        /**
+         * @brief Method to add the growth of a cumulative drop counter to the drops
+         *
+         * @param last - the last value of the counter, updated
+         * @param counter - the new value of the counter
+         */
+        void countDrops(uint32_t &last, uint32_t counter) {
+            if (counter == last) return;
+            drops += uint32_t(counter - last);
+            last = counter;
+        };
+
+        std::vector<struct pollfd> pollFds;     // sockets of the wait, filled on the first call
+        uint64_t drops = 0;                     // received packets, the kernel dropped
+        uint64_t backpressure = 0;              // sends, the kernel had no room for
+        size_t parked = 0;                      // packets waiting for the retry
+        int backoffMs = 0;                      // pause before the retry, 0 to wait for POLLOUT
+        std::chrono::steady_clock::time_point retryAt;  // time of the retry
+};
+
+/**
+ * @class RawTransport
+ * @brief Transport over raw IP sockets, the kernel builds the IP header
+ */
+class RawTransport : public Transport {
+    public:
+        /**
+         * @brief Constructor for RawTransport class
+         *
+         * @param sender - sender network interface, the sockets are bound to it
+         * @param tcp - open the TCP socket
+         * @param udp - open the UDP socket, the ICMP socket is always open
+         */
+        RawTransport(const NetworkInterface &sender, bool tcp, bool udp);
+        /**
+         * @brief Destructor for RawTransport class
+         */
+        ~RawTransport() override;
+        char* reserve(size_t *size) override;
+        void commit(const struct sockaddr *target, const unsigned char *mac, int protocol, size_t size) override;
+        std::vector<int> getSockets() const override;
+        void flush() override;
+        void receive(const SegmentCallback &onSegment) override;
+        void setReceiveWindow(size_t packets) override;
+    protected:
+        /**
+         * @brief Method to send the packet in the send buffer, parks it, if the kernel has no room
+         *
+         * @return bool - true, if the packet was sent
+         */
+        bool transmit();
+        /**
+         * @brief Method to pass a packet from a raw socket on as a segment
+         *
+         * @param protocol - protocol of the socket (IPv6 raw sockets do not deliver the IP header)
+         * @param source - source address of the packet
+         * @param packet - the packet
+         * @param size - size of the packet
+         * @param receivedNs - receive timestamp of the packet
+         * @param onSegment - callback invoked for the segment
+         */
+        void deliver(int protocol, const struct sockaddr_storage &source, const char *packet, size_t size, int64_t receivedNs, const SegmentCallback &onSegment) const;
+
+        bool ipv4;                          // IP version of the sockets
+        Socket* tcpSocket = nullptr;        // TCP socket
+        Socket* udpSocket = nullptr;        // UDP socket
+        Socket* icmpSocket = nullptr;       // ICMP socket
+        char sendBuffer[DATAGRAM_LEN];      // buffer for building the packet, holds the parked packet
+        int sendSocket = -1;                // socket of the packet in the send buffer
+        struct sockaddr_storage sendTarget; // target of the packet in the send buffer
+        socklen_t sendTargetLen = 0;        // size of the target
+        size_t sendSize = 0;                // size of the packet in the send buffer
+        char readBuffer[DATAGRAM_LEN];      // buffer for reading the packet
+        char controlBuffer[TIMESTAMP_CONTROL_LEN];  // control data of the read, the timestamp and the drop counter
+        uint32_t dropCounters[3] = {0, 0, 0};       // last drop counter of the TCP, UDP and ICMP socket
+};
+
+/**
+ * @class LinkTransport
+ * @brief Base class for the transports, that send whole Ethernet frames
+ *
+ * The frames are written in place into memory shared with the kernel. The
+ * Ethernet source and type never change, so the derived transports write
+ * them into every transmit frame once (fillTemplate), a probe only patches
+ * the destination MAC and writes the IP header and the segment.
+ */
+class LinkTransport : public Transport {
+    public:
+        /**
+         * @brief Constructor for LinkTransport class
+         *
+         * @param sender - sender network address
+         * @param link - interface, the frames leave through
+         */
+        LinkTransport(const NetworkAdress &sender, const LinkInfo &link);
+        void resolve(const NetworkAdress &target, unsigned char mac[6]) override;
+        char* reserve(size_t *size) override;
+        void commit(const struct sockaddr *target, const unsigned char *mac, int protocol, size_t size) override;
+    protected:
+        /**
+         * @brief Method to get the next free transmit frame
+         *
+         * @param size - set to the space available in the frame
+         * @return char* - start of the frame, nullptr if no frame is free
+         */
+        virtual char* nextFrame(size_t *size) = 0;
+        /**
+         * @brief Method to queue the frame from nextFrame for sending
+         *
+         * @param size - size of the frame
+         */
+        virtual void commitFrame(size_t size) = 0;
+        /**
+         * @brief Method to write the constant part of the Ethernet header
+         *
+         * @param frame - the transmit frame
+         */
+        void fillTemplate(char *frame) const;
+        /**
+         * @brief Method to parse a received frame down to the segment
+         *
+         * @param frame - the frame, starting with the Ethernet header
+         * @param size - size of the frame
+         * @param receivedNs - receive timestamp of the frame
+         * @param onSegment - callback invoked for the segment
+         */
+        void handleFrame(const char *frame, size_t size, int64_t receivedNs, const SegmentCallback &onSegment) const;
+
+        NetworkAdress sender;                   // sender network address
+        LinkInfo link;                          // interface of the transport
+        bool ipv4;                              // IP version of the frames
+        struct sockaddr_in senderAddr4;         // sender address for IPv4
+        struct sockaddr_in6 senderAddr6;        // sender address for IPv6
+        char *reservedFrame = nullptr;          // frame from the last reserve
+};
+
+/**
+ * @brief Function to create the transport for the backend
+ *
+ * The link layer backends can not reach the local stack, the loopback
+ * always gets the raw sockets.
+ *
+ * @param backend - the requested backend
+ * @param sender - sender network interface, the address with the source port of the scan
+ * @param tcp - TCP probes are sent
+ * @param udp - UDP probes are sent
+ * @return Transport* - the transport, owned by the caller
+ */
+Transport* createTransport(Backend backend, const NetworkInterface &sender, bool tcp, bool udp);
+
+#endif // TRANSPORT_HPP
@@ -0,0 +1,159 @@
+/**
+ * @file uring.hpp
+ * @brief Header file for the io_uring transport (raw sockets driven by a submission ring)
+ * @author Martin Mendl <x247581>
+ * @date 2025-01-04
+ */
+
+#ifndef URING_HPP
+#define URING_HPP
+
+#include <cstdint>
+#include <vector>
+#include <sys/socket.h>
+#include <linux/io_uring.h>
+#include "transport.hpp"
+
+const unsigned URING_ENTRIES = 1024;        // submission queue entries
+const unsigned URING_CQ_ENTRIES = 8192;     // completion queue entries
+const unsigned URING_SEND_SLOTS = 512;      // probes in flight between submission and completion
+const unsigned URING_RECV_BUFFERS = 1024;   // provided buffers for the multishot receives, power of 2
+const unsigned URING_RECV_BUFFER_SIZE = 2048; // size of a receive buffer
+const uint16_t URING_BUFFER_GROUP = 0;      // group of the provided buffers
+
+/**
+ * @struct SendSlot
+ * @brief Probe handed to the kernel, kept alive until its completion
+ */
+struct SendSlot {
+    unsigned index;                         // index of the slot, the user data of its SQE
+    int sockfd;                             // socket of the sendmsg
+    struct msghdr msg;                      // message of the sendmsg
+    struct iovec iov;                       // the segment
+    struct sockaddr_storage target;         // target address
+    char buffer[DATAGRAM_LEN];              // the segment
+};
+
+/**
+ * @struct RecvSlot
+ * @brief Receive posted on one of the raw sockets
+ */
+struct RecvSlot {
+    int sockfd;                             // the socket
+    int protocol;                           // protocol of the socket
+    bool armed = false;                     // a receive is posted
+    uint32_t dropCounter = 0;               // last drop counter of the socket
+    struct msghdr msg;                      // message of the recvmsg, only the lengths for multishot
+    struct iovec iov;                       // buffer of the single shot receive
+    struct sockaddr_storage source;         // source of the single shot receive
+    char control[TIMESTAMP_CONTROL_LEN];    // control data of the single shot receive, the timestamp
+    char buffer[URING_RECV_BUFFER_SIZE];    // buffer of the single shot receive
+};
+
+/**
+ * @class UringTransport
+ * @brief Transport over raw IP sockets, driven by io_uring instead of poll
+ *
+ * A pass of the scheduler queues one sendmsg SQE per probe and submits them
+ * all with a single io_uring_enter(). Every socket keeps a multishot recvmsg
+ * posted, that fills the provided buffer ring until it runs dry, so a reply
+ * costs no system call at all. On kernels without multishot receive, a single
+ * recvmsg per socket is posted again after every completion. Waiting is a
+ * timeout SQE, that completes with the first other completion.
+ *
+ * A send, that completes with ENOBUFS or EAGAIN, keeps its slot and is
+ * queued again after the pause, no new probes are taken meanwhile.
+ */
+class UringTransport : public RawTransport {
+    public:
+        /**
+         * @brief Constructor for UringTransport class
+         *
+         * @param sender - sender network interface
+         * @param tcp - open the TCP socket
+         * @param udp - open the UDP socket, the ICMP socket is always open
+         */
+        UringTransport(const NetworkInterface &sender, bool tcp, bool udp);
+        /**
+         * @brief Destructor for UringTransport class
+         */
+        ~UringTransport() override;
+        char* reserve(size_t *size) override;
+        void commit(const struct sockaddr *target, const unsigned char *mac, int protocol, size_t size) override;
+        void flush() override;
+        std::vector<int> getSockets() const override { return {ringfd}; };
+        void wait(int timeoutMs, bool wantSend) override;
+        void addPollFds(std::vector<struct pollfd> &fds, int &timeoutMs, bool wantSend) override;
+        void receive(const SegmentCallback &onSegment) override;
+    private:
+        /**
+         * @brief Method to get a free submission queue entry
+         *
+         * @return struct io_uring_sqe* - the entry, zeroed
+         */
+        struct io_uring_sqe* getSqe();
+        /**
+         * @brief Method to submit the queued entries
+         *
+         * @param waitFor - number of completions to wait for
+         */
+        void submit(unsigned waitFor);
+        /**
+         * @brief Method to queue the sendmsg of the slot
+         *
+         * @param slot - the slot, with the message set up
+         */
+        void queueSend(SendSlot *slot);
+        /**
+         * @brief Method to register the provided buffer ring
+         *
+         * @return bool - false, if the kernel does not support it
+         */
+        bool registerBuffers();
+        /**
+         * @brief Method to post the receive on a socket
+         *
+         * @param index - index of the receive slot
+         */
+        void armReceive(size_t index);
+        /**
+         * @brief Method to give a receive buffer back to the kernel
+         *
+         * @param bid - buffer id
+         */
+        void recycleBuffer(uint16_t bid);
+        /**
+         * @brief Method to close the ring and free the buffers
+         */
+        void release();
+
+        int ringfd = -1;                            // io_uring instance
+        void *sqRing = nullptr;                     // submission ring mapping
+        void *cqRing = nullptr;                     // completion ring mapping (same as sqRing with single mmap)
+        size_t sqRingSize = 0;                      // size of the submission ring mapping
+        size_t cqRingSize = 0;                      // size of the completion ring mapping
+        struct io_uring_sqe *sqes = nullptr;        // submission queue entries
+        size_t sqesSize = 0;                        // size of the entries mapping
+        uint32_t *sqHead = nullptr;                 // submission ring head, moved by the kernel
+        uint32_t *sqTail = nullptr;                 // submission ring tail
+        uint32_t *sqArray = nullptr;                // submission ring, indices into sqes
+        uint32_t sqEntries = 0;                     // size of the submission ring
+        uint32_t *cqHead = nullptr;                 // completion ring head
+        uint32_t *cqTail = nullptr;                 // completion ring tail, moved by the kernel
+        uint32_t cqEntries = 0;                     // size of the completion ring
+        struct io_uring_cqe *cqes = nullptr;        // completion queue entries
+        uint32_t sqLocalTail = 0;                   // tail with the entries, that are not submitted yet
+        unsigned toSubmit = 0;                      // entries queued since the last submit
+        struct io_uring_buf_ring *bufRing = nullptr;    // provided buffer ring
+        size_t bufRingSize = 0;                     // size of the buffer ring mapping
+        char *recvBuffers = nullptr;                // the provided buffers
+        bool multishot = false;                     // receives use the provided buffers
+        std::vector<RecvSlot*> recvSlots;           // receive per socket
+        std::vector<SendSlot*> sendSlots;           // all send slots
+        std::vector<SendSlot*> freeSlots;           // send slots not in the kernel
+        std::vector<SendSlot*> retrySlots;          // sends, the kernel had no room for
+        SendSlot *reservedSlot = nullptr;           // slot from the last reserve
+        struct __kernel_timespec waitTimeout;       // timeout of the wait SQE
+};
+
+#endif // URING_HPP
@@ -10,40 +10,202 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <type_traits>
+#include <netinet/in.h>
 
 /**
- * @struct NetworkAdress
- * @brief Represents the network address
+ * @enum IpVersion
+ * @brief IP version of the network address
  */
-enum class IpVersion {
+enum class IpVersion : uint8_t {
     IPV4,
     IPV6
 };
 
+/**
+ * @enum Protocol
+ * @brief Enumeration for different protocols
+ */
+enum class Protocol {
+    TCP,
+    UDP,
+    ICMP,
+    ICMP6
+};
+
 /**
  * @struct NetworkAdress
  * @brief Represents the network address
+ *
+ * The address is kept in binary, the way it goes on the wire, so it is
+ * copied around with the probes without any allocation and never parsed
+ * again. It is turned into text only for the output (toString).
  */
 struct NetworkAdress {
-    std::string hostName;
-    std::string ip;
-    IpVersion ipVer;
-    int port;
+    unsigned char addr[16];     // address in network byte order, IPv4 in the first 4 bytes
+    uint16_t port;              // port in host byte order, 0 if not used
+    IpVersion ipVer;            // IP version of the address
+    bool valid;                 // false for the empty address (no address of the version)
+};
+
+static_assert(sizeof(NetworkAdress) == 20, "NetworkAdress is expected to be 20 bytes");
+static_assert(std::is_trivially_copyable_v<NetworkAdress>, "NetworkAdress is expected to be trivially copyable");
+
+/**
+ * @struct NetworkInterface
+ * @brief Network interface with one of its addresses
+ */
+struct NetworkInterface {
+    std::string name;           // name of the interface
+    NetworkAdress address;      // address of the interface
 };
 
+/**
+ * @enum Backend
+ * @brief Enumeration for the packet transports
+ */
+enum class Backend {
+    RAW,            // raw IP sockets, the kernel builds the IP header
+    PACKET_MMAP,    // AF_PACKET socket with TPACKET_V3 rings
+    XDP,            // AF_XDP socket in generic (SKB) mode
+    IO_URING,       // raw IP sockets driven by io_uring
+    CONNECT         // non-blocking connect() calls, TCP only, no root needed
+};
+
+/**
+ * @enum TargetType
+ * @brief Enumeration for the kinds of targets
+ */
+enum class TargetType {
+    IP_v4,
+    IP_v6,
+    DOMAIN_NAME,
+    UNKNOWN
+};
+
+const int MAX_PORT_NUMBER = 65535;
+
+/**
+ * @brief Function to parse the ports
+ * 
+ * @param ports The string containing the ports
+ * @return std::vector<int> The vector containing the ports
+*/
+std::vector<int> parsePorts(const std::string &ports);
+
+/**
+ * @brief Function to determine the target type
+ * 
+ * @param target The target string
+ * @return TargetType The target type
+*/
+TargetType determinTargetType(const std::string &target);
+
+/**
+ * @struct LinkInfo
+ * @brief Link layer information of a network interface
+ */
+struct LinkInfo {
+    int ifindex;                // interface index
+    unsigned char mac[6];       // hardware address
+    bool loopback;              // loopback interface (zero MAC addresses)
+};
+
+/**
+ * @brief Function to build the network address from its binary form
+ * 
+ * @param family The address family (AF_INET or AF_INET6)
+ * @param addr The address (in_addr or in6_addr)
+ * @param port The port in host byte order
+ * @return NetworkAdress The network address
+*/
+NetworkAdress makeAddress(int family, const void *addr, uint16_t port);
+
+/**
+ * @brief Function to parse the textual IPv4 or IPv6 address
+ * 
+ * @param text The address
+ * @param address The parsed address
+ * @return bool False, if the text is not an address
+*/
+bool parseAddress(const std::string &text, NetworkAdress &address);
+
+/**
+ * @brief Function to convert the network address to text, used for the output only
+ * 
+ * @param address The network address
+ * @return std::string The address in text form
+*/
+std::string toString(const NetworkAdress &address);
+
+/**
+ * @brief Function to convert the network address to text in the given buffer, without allocating
+ * 
+ * @param address The network address
+ * @param text The buffer, INET6_ADDRSTRLEN bytes are enough for any address
+ * @param size The size of the buffer
+ * @return const char* The text, empty if the address is not valid
+*/
+const char* toString(const NetworkAdress &address, char *text, size_t size);
+
+/**
+ * @brief Function to compare the addresses of two network addresses, the ports are ignored
+ * 
+ * @param a The first address
+ * @param b The second address
+ * @return bool True, if both have the same IP version and address
+*/
+bool sameAddress(const NetworkAdress &a, const NetworkAdress &b);
+
+/**
+ * @brief Function to check, if the address is a loopback address
+ * 
+ * @param address The network address
+ * @return bool True for 127.0.0.0/8 and ::1
+*/
+bool isLoopback(const NetworkAdress &address);
+
+/**
+ * @brief Function to parse a whole number in the range, the text has to be the number and nothing else
+ *
+ * @param text - the text of the number
+ * @param min - smallest valid value
+ * @param max - largest valid value
+ * @param value - set to the number
+ * @return bool - false, if the text is not a number or out of the range
+ */
+bool parseNumber(const std::string &text, int min, int max, int &value);
+
+/**
+ * @brief Function to fill the IPv4 socket address
+ * 
+ * @param address The network address
+ * @param sockAddr The socket address
+*/
+void toSockaddr(const NetworkAdress &address, struct sockaddr_in &sockAddr);
+
+/**
+ * @brief Function to fill the IPv6 socket address
+ * 
+ * @param address The network address
+ * @param sockAddr The socket address
+*/
+void toSockaddr(const NetworkAdress &address, struct sockaddr_in6 &sockAddr);
+
 /**
  * @brief Function returning the available network interfaces
  * 
  * @return std::vector<NetworkInterface> The vector containing the network interfaces
 */
-std::vector<NetworkAdress> getNetworkInterfaces();
+std::vector<NetworkInterface> getNetworkInterfaces();
 
 /**
  * @brief Function to represent the available network interfaces    
  * 
  * @return void
 */
-void representInterfaces(std::vector<NetworkAdress> interfaces);
+void representInterfaces(const std::vector<NetworkInterface> &interfaces);
 
 
 /**
@@ -51,9 +213,29 @@ void representInterfaces(std::vector<NetworkAdress> interfaces);
  * 
  * @param interfaces The vector containing the network interfaces
  * @param interface_name The name of the interface
- * @return NetworkInterface* The pointer to the network interface
+ * @return NetworkInterface The network interface, with an invalid address if it has none of the version
+*/
+NetworkInterface validateInterface(std::vector<NetworkInterface>& interfaces, const std::string& interface_name, bool ipv4);
+
+/**
+ * @brief Function to get the link layer information of the interface
+ * 
+ * @param interfaceName The name of the interface
+ * @return LinkInfo The link layer information
 */
-NetworkAdress validateInterface(std::vector<NetworkAdress>& interfaces, const std::string& interface_name, bool ipv4);
+LinkInfo getLinkInfo(const std::string &interfaceName);
+
+/**
+ * @brief Function to resolve the MAC address of the next hop towards the target
+ * 
+ * Asks the kernel for the route and the neighbour entry over netlink,
+ * triggers the neighbour discovery if there is no entry yet.
+ * 
+ * @param link The interface, the packets leave through
+ * @param target The target address
+ * @param mac The resolved MAC address
+*/
+void resolveNextHopMac(const LinkInfo &link, const NetworkAdress &target, unsigned char mac[6]);
 
 /**
  * @brief Function to calc the checksum
@@ -64,4 +246,15 @@ NetworkAdress validateInterface(std::vector<NetworkAdress>& interfaces, const st
 */
 unsigned short checkSum(const char *buf, unsigned size);
 
+/**
+ * @brief Function to calc the checksum over two buffers, as if they were one (pseudo header and segment)
+ * 
+ * @param head The first buffer, even length
+ * @param headSize The length of the first buffer
+ * @param buf The second buffer
+ * @param size The length of the second buffer
+ * @return unsigned short The checksum
+*/
+unsigned short checkSum(const char *head, unsigned headSize, const char *buf, unsigned size);
+
 #endif // UTILS_HPP
\ No newline at end of file
@@ -0,0 +1,110 @@
+/**
+ * @file watch.hpp
+ * @brief Header file for the watch mode (rounds of scans, that keep the state of the ports and print its changes)
+ * @author Martin Mendl <x247581>
+ * @date 2026-01-13
+ */
+
+#ifndef WATCH_HPP
+#define WATCH_HPP
+
+#include <list>
+#include <string>
+#include <vector>
+#include "l4scan.hpp"
+
+const int WATCH_SLICE_PORTS = 128;      // ports of the lists per slice of the sweep, shorter lists are swept whole every round
+const int WATCH_MAX_SLICES = 16;        // most slices, every port is probed at least every 16 rounds
+
+/**
+ * @struct WatchSettings
+ * @brief Settings of the command line, that every round uses
+ */
+struct WatchSettings {
+    std::string interfaceName;  // interface of the probes
+    Backend backend;            // transport of the probes
+    int timeout;                // timeout of a probe in ms
+    int hostProbes;             // max probes in flight to one host, 0 for the windows only
+    int bannerBytes;            // max bytes of a banner, 0 for no banners
+    bool showRtt;               // print the round trip time of the answered ports
+    int intervalS;              // seconds from the start of a round to the start of the next one
+};
+
+/**
+ * @class PortWatcher
+ * @brief Continuous monitoring of the ports of a target list, printing only the changes of their state
+ *
+ * The first round scans every port and prints the open ones. Then every
+ * round, one interval apart, probes the ports known to be open on every
+ * target again and one slice of the rest: the port lists are split into up
+ * to WATCH_MAX_SLICES slices, so the whole space is swept once in as many
+ * rounds. An open port, that closes, is seen in the next round, a port,
+ * that opens, within a sweep, and a round sends only the open ports and a
+ * slice of the probes of a full scan. The last state of every (target,
+ * port, protocol) is kept in memory, a result is printed only, when it
+ * differs. The rounds are ScanJobs of one ScanRunner, so the window and the
+ * interfaces carry over from round to round.
+ */
+class PortWatcher {
+    public:
+        /**
+         * @brief Constructor for PortWatcher class
+         *
+         * @param settings - settings of the rounds
+         * @param targets - targets to watch, resolved
+         * @param tcpPorts - TCP ports to watch
+         * @param udpPorts - UDP ports to watch
+         */
+        PortWatcher(const WatchSettings &settings, std::vector<NetworkAdress> targets, std::vector<int> tcpPorts, std::vector<int> udpPorts);
+        PortWatcher(const PortWatcher&) = delete;
+        PortWatcher& operator=(const PortWatcher&) = delete;
+
+        /**
+         * @brief Method to watch the ports, until SIGINT or SIGTERM
+         */
+        void run();
+
+    private:
+        /**
+         * @brief Method to scan one round, the open ports and a slice of the rest
+         *
+         * @return bool - false, if the round was stopped by a signal
+         */
+        bool scanRound();
+        /**
+         * @brief Method to add a job of the round
+         *
+         * @param jobTargets - targets of the job
+         * @param tcpPorts - TCP ports of the job
+         * @param udpPorts - UDP ports of the job
+         */
+        void addJob(const std::vector<NetworkAdress> &jobTargets, const std::vector<int> &tcpPorts, const std::vector<int> &udpPorts);
+        /**
+         * @brief Method to keep the new state of a port and print it, if it changed
+         *
+         * @param result - the finished port
+         */
+        void update(const PortResult &result);
+        /**
+         * @brief Method to check, if a port of a list is in the slice of the round
+         *
+         * @param index - position of the port in its list
+         * @return bool - true, if the round sweeps the port
+         */
+        bool inSlice(size_t index) const { return round == 0 || index % slices == round % slices; };
+
+        WatchSettings settings;                 // settings of the rounds
+        std::vector<NetworkAdress> targets;     // the targets, sorted for the lookup of the results
+        std::vector<int> tcp;                   // TCP ports
+        std::vector<int> udp;                   // UDP ports
+        std::vector<int> tcpIndex;              // position of a TCP port in its list, by port number, -1 if not watched
+        std::vector<int> udpIndex;              // position of a UDP port in its list, by port number, -1 if not watched
+        std::vector<ScanResult> states;         // last state of every port, by target, then TCP, then UDP ports
+        size_t slices;                          // rounds of one sweep of the whole space
+        size_t round = 0;                       // number of the round, 0 is the full first scan
+        ScanRunner runner;                      // the jobs of the round
+        std::list<ScanJob> jobs;                // the jobs of the round, a job does not move
+        std::vector<struct pollfd> fds;         // poll set of the rounds
+};
+
+#endif // WATCH_HPP
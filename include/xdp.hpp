@@ -0,0 +1,120 @@
+/**
+ * @file xdp.hpp
+ * @brief Header file for the AF_XDP transport (XDP socket in generic mode)
+ * @author Martin Mendl <x247581>
+ * @date 2025-30-03
+ */
+
+#ifndef XDP_HPP
+#define XDP_HPP
+
+#include <cstdint>
+#include <vector>
+#include <linux/if_xdp.h>
+#include "transport.hpp"
+
+const unsigned XDP_FRAME_SIZE = 2048;      // size of a UMEM frame
+const unsigned XDP_RX_FRAMES = 2048;       // UMEM frames for the receive side (fill ring)
+const unsigned XDP_TX_FRAMES = 2048;       // UMEM frames for the transmit side
+const unsigned XDP_QUEUE = 0;              // interface queue the socket is bound to
+const unsigned XDP_KICK_TRIES = 64;        // max sendto() calls to drain the transmit ring
+
+/**
+ * @struct XdpRing
+ * @brief Producer/consumer ring shared with the kernel
+ */
+struct XdpRing {
+    uint32_t *producer = nullptr;   // producer index, free running
+    uint32_t *consumer = nullptr;   // consumer index, free running
+    void *desc = nullptr;           // descriptors (xdp_desc or UMEM addresses)
+    uint32_t size = 0;              // number of descriptors, power of 2
+    uint32_t cached = 0;            // our side of the ring, published with the release store
+    void *map = nullptr;            // mapping of the ring
+    size_t mapSize = 0;             // size of the mapping
+};
+
+/**
+ * @class XdpSocket
+ * @brief Class for the AF_XDP socket with its UMEM and rings
+ *
+ * A small XDP program, loaded through the bpf() syscall, redirects the
+ * answers to the scan into the socket: TCP and UDP to the source port of a
+ * probe in flight, and the ICMP errors quoting such a probe. Everything else,
+ * also the traffic of the host sockets, whose ephemeral ports overlap the
+ * source port range, goes on to the kernel. The ports in flight are a bitmap
+ * in a BPF array, that is mapped into the scanner and set and cleared with
+ * every probe, so the filter follows the scan without a syscall. The program runs in generic
+ * (SKB) mode and the socket in copy mode, so it works on any interface,
+ * including veth, without driver support.
+ *
+ * The first half of the UMEM is handed to the kernel through the fill ring
+ * for the received frames, the second half are the transmit frames. These
+ * keep the Ethernet header template between the probes and come back through
+ * the completion ring, which is reaped in batches when no frame is free.
+ *
+ * Only the queue XDP_QUEUE is bound, on a multi queue NIC the answers hashed
+ * to the other queues pass the program and go to the kernel.
+ */
+class XdpSocket : public LinkTransport {
+    public:
+        /**
+         * @brief Constructor for XdpSocket class
+         *
+         * @param sender - sender network address
+         * @param link - interface, the socket is bound to
+         */
+        XdpSocket(const NetworkAdress &sender, const LinkInfo &link);
+        /**
+         * @brief Destructor for XdpSocket class, detaches the program
+         */
+        ~XdpSocket() override;
+        void flush() override;
+        std::vector<int> getSockets() const override { return {sockfd}; };
+        void receive(const SegmentCallback &onSegment) override;
+        uint64_t getDrops() override;
+        void claimPort(uint16_t port, bool inFlight) override;
+    protected:
+        char* nextFrame(size_t *size) override;
+        void commitFrame(size_t size) override;
+    private:
+        /**
+         * @brief Method to load the XDP program and attach it to the interface
+         */
+        void attachProgram();
+        /**
+         * @brief Method to close the program, the rings and the socket
+         */
+        void release();
+        /**
+         * @brief Method to map a ring of the socket
+         *
+         * @param ring - the ring
+         * @param offsets - offsets of the ring fields
+         * @param size - number of descriptors
+         * @param descSize - size of a descriptor
+         * @param pgoff - mmap offset of the ring
+         */
+        void mapRing(XdpRing &ring, const struct xdp_ring_offset &offsets, uint32_t size, size_t descSize, uint64_t pgoff);
+        /**
+         * @brief Method to take the sent frames back from the completion ring
+         */
+        void reapCompletions();
+
+        int sockfd = -1;                    // AF_XDP socket
+        int mapfd = -1;                     // XSKMAP, queue to socket
+        int portsfd = -1;                   // BPF array with the bitmap of the source ports in flight
+        uint8_t *portBits = nullptr;        // the bitmap, mapped from the array
+        int progfd = -1;                    // XDP program
+        int linkfd = -1;                    // attachment of the program, detached on close
+        char *umem = nullptr;               // packet buffer shared with the kernel
+        size_t umemSize = 0;                // size of the packet buffer
+        XdpRing fillRing;                   // free frames for the kernel to receive into
+        XdpRing completionRing;             // sent frames given back by the kernel
+        XdpRing rxRing;                     // received frames
+        XdpRing txRing;                     // frames to send
+        std::vector<uint64_t> freeFrames;   // transmit frames, that are not in the kernel
+        uint64_t reservedAddr = 0;          // UMEM address of the frame from the last nextFrame
+        unsigned txPending = 0;             // committed, not yet kicked frames
+};
+
+#endif // XDP_HPP
@@ -9,98 +9,29 @@
  #include <getopt.h>
  #include <cstdlib>
  #include <vector>
- #include <regex>
+ #include <limits>
+ #include <algorithm>
  #include <cstring>
  #include <netdb.h>
  #include <arpa/inet.h>
  #include "arguments.hpp"
+ #include "topports.hpp"
+ #include "banner.hpp"
  
-// Function to parse the ports
-std::vector<int> parsePorts(const std::string &ports) {
-    // look for the - in the string
-    size_t found = ports.find("-"); 
-    // port range
-    if (found != std::string::npos) { 
-        // split the string, with the - index, and find lower and upper bounds
-        std::string lowerBound = ports.substr(0, found);
-        std::string upperBound = ports.substr(found + 1, ports.length()); 
-
-        // if anythin otheer, than numbers are present in lowe and Uppoer, we have to throw an error
-        if (lowerBound.find_first_not_of("0123456789") != std::string::npos || upperBound.find_first_not_of("0123456789") != std::string::npos) {
-            throw std::invalid_argument("Invalid port range: " + ports); 
-        } 
-        // convert the strings to integers
-        int lower = std::stoi(lowerBound);
-        int upper = std::stoi(upperBound); 
-
-        // check if the lower bound is less than the upper bound
-        if (lower > upper) {
-            throw std::invalid_argument("Invalid port range: " + ports);
-        } 
-
-        // create a vector of integers, and add the range to it
-        std::vector<int> portList;
-        for (int i = lower; i <= upper; i++) {
-            portList.push_back(i);
-        } 
-        return portList;
-    }  
-
-    // port selection
-    std::vector<int> portList;
-    bool skip = false;
-    int start_index = 0; 
-
-    // pase the ports, and add them to the list
-    for (size_t i = 0; i < ports.length(); i++) { 
-        // moving end index, to the end of the number
-        if (ports[i] != ' ' && ports[i] != ',' && !skip) continue;         
-        if (!skip) {
-            // if we have a comma, we add the port to the list
-            std::string port = ports.substr(start_index, i - start_index);
-            if (port.find_first_not_of("0123456789") != std::string::npos) {
-                throw std::invalid_argument("Invalid port: " + port);
-            } 
-
-            // save the port to the list
-            portList.push_back(std::stoi(port));
-            skip = true;
-        } 
-
-        if (ports[i] != ' ' && ports[i] != ',') {
-            skip = false;
-            start_index = i;
-        }
-    } 
-    // add the last port to the list
-    std::string port = ports.substr(start_index, ports.length() - start_index);
-    if (port.find_first_not_of("0123456789") != std::string::npos) {
-        throw std::invalid_argument("Invalid port: " + port);
-    }
-    portList.push_back(std::stoi(port)); 
-    return portList;
-} 
-// Function to determine the target type
-TargetType determinTargetType(const std::string &target) { 
-    // Regular expressions for IPv4, IPv6, and domain name
-    std::regex ipv4_regex("^(\\d{1,3}\\.){3}\\d{1,3}$");
-    std::regex ipv6_regex("^[0-9a-fA-F:]+$");
-    std::regex domain_regex("^[a-zA-Z0-9.-]+$"); 
-    if (std::regex_match(target, ipv4_regex)) return TargetType::IP_v4;
-    if (std::regex_match(target, ipv6_regex)) return TargetType::IP_v6;
-    if (std::regex_match(target, domain_regex)) return TargetType::DOMAIN_NAME;
-    return TargetType::UNKNOWN;
-} 
-
 // Function to save the NetworkAdress
 void Settings::addTargetIp(NetworkAdress &addr) {     
+    // an excluded address is never probed, also when a domain resolves to it
+    if (exclusions.contains(addr)) {
+        std::cerr << "Excluded target: " << toString(addr) << std::endl;
+        return;
+    }
     if (addr.ipVer == IpVersion::IPV4) {
-        if (std::find_if(targetIp4.begin(), targetIp4.end(), [&addr](const NetworkAdress &a) { return a.ip == addr.ip; }) == targetIp4.end()) {
+        if (std::find_if(targetIp4.begin(), targetIp4.end(), [&addr](const NetworkAdress &a) { return sameAddress(a, addr); }) == targetIp4.end()) {
             targetIp4.push_back(addr);
             Targetipv4 = true;
         }
     } else if (addr.ipVer == IpVersion::IPV6) {
-        if (std::find_if(targetIp6.begin(), targetIp6.end(), [&addr](const NetworkAdress &a) { return a.ip == addr.ip; }) == targetIp6.end()) {
+        if (std::find_if(targetIp6.begin(), targetIp6.end(), [&addr](const NetworkAdress &a) { return sameAddress(a, addr); }) == targetIp6.end()) {
             targetIp6.push_back(addr);
             Targetipv6 = true;
         }
@@ -109,7 +40,6 @@ void Settings::addTargetIp(NetworkAdress &addr) {
 // Method to save all the dns entries
 void Settings::getTargetIPsFromDomain(const std::string &domain) {
     struct addrinfo hints{}, *res, *p;
-    char ipstr[INET6_ADDRSTRLEN];
     memset(&hints, 0, sizeof(hints));
     hints.ai_family = AF_UNSPEC; // Supports both IPv4 and IPv6
     hints.ai_socktype = SOCK_STREAM; // Typically used for TCP connections 
@@ -123,20 +53,17 @@ void Settings::getTargetIPsFromDomain(const std::string &domain) {
     // Iterate through all results and store every resolved IP address
     for (p = res; p != nullptr; p = p->ai_next) {
         void *addr = nullptr;
-        IpVersion version; 
 
         if (p->ai_family == AF_INET) { 
             addr = &reinterpret_cast<sockaddr_in*>(p->ai_addr)->sin_addr;
-            version = IpVersion::IPV4;
         } else if (p->ai_family == AF_INET6) {
             addr = &reinterpret_cast<sockaddr_in6*>(p->ai_addr)->sin6_addr;
-            version = IpVersion::IPV6;
         } else {
             continue; // Skip unknown address families
         } 
 
-        inet_ntop(p->ai_family, addr, ipstr, sizeof(ipstr));
-        NetworkAdress targetIp = {domain, ipstr, version, -1};
+        // the address stays binary, it is turned into text only for the output
+        NetworkAdress targetIp = makeAddress(p->ai_family, addr, 0);
         addTargetIp(targetIp);
     } 
     freeaddrinfo(res); // Free allocated memory
@@ -151,6 +78,16 @@ Settings::Settings(int argc, char *argv[]) {
         {"pt", required_argument, 0, 't'},
         {"pu", required_argument, 0, 'u'},
         {"wait", required_argument, 0, 'w'},
+        {"backend", required_argument, 0, 'b'},
+        {"rtt", no_argument, 0, 'r'},
+        {"host-probes", required_argument, 0, 'c'},
+        {"top-ports", required_argument, 0, 'T'},
+        {"top-udp-ports", required_argument, 0, 'U'},
+        {"exclude", required_argument, 0, 'x'},
+        {"exclude-file", required_argument, 0, 'X'},
+        {"banner", required_argument, 0, 'B'},
+        {"daemon", required_argument, 0, 'D'},
+        {"watch", required_argument, 0, 'W'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
@@ -159,7 +96,7 @@ Settings::Settings(int argc, char *argv[]) {
     bool timeoutSet = false;
     bool interfaceSet = false;   
 
-    while ((opt = getopt_long(argc, argv, "it:u:w:h", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "it:u:T:U:w:b:rc:x:X:B:D:W:h", long_options, &option_index)) != -1) {
         switch (opt) {
             case 'i':
                 if (optind < argc && argv[optind][0] != '-') {
@@ -170,21 +107,91 @@ Settings::Settings(int argc, char *argv[]) {
                 }
                 break;
             case 't':
-                TCPports = parsePorts(optarg);
+            case 'u':
+                try {
+                    ((opt == 't') ? TCPports : UDPports) = parsePorts(optarg);
+                } catch (const std::exception &) {
+                    std::cerr << "Invalid " << ((opt == 't') ? "TCP" : "UDP") << " ports: " << optarg << std::endl;
+                    exit(1);
+                }
                 portsSet = true;
                 break;
-            case 'u':
-                UDPports = parsePorts(optarg);
+            case 'T':
+            case 'U': {
+                // the profile is compiled in, the most common port comes first
+                Protocol protocol = (opt == 'T') ? Protocol::TCP : Protocol::UDP;
+                int count;
+                if (!parseNumber(optarg, 1, int(topPortCount(protocol)), count)) {
+                    std::cerr << "Top ports must be a number between 1 and " << topPortCount(protocol) << std::endl;
+                    exit(1);
+                }
+                ((opt == 'T') ? TCPports : UDPports) = topPorts(protocol, count);
                 portsSet = true;
                 break;
+            }
             case 'w':
-                timeout = std::stoi(optarg);
-                if (timeout <= 0) {
-                    std::cerr << "Timeout mas be greater than 0" << std::endl;
+                if (!parseNumber(optarg, 1, std::numeric_limits<int>::max(), timeout)) {
+                    std::cerr << "Timeout must be a number greater than 0" << std::endl;
                     exit(1);
                 }
                 timeoutSet = true;
                 break;
+            case 'b':
+                if (std::string(optarg) == "raw") backend = Backend::RAW;
+                else if (std::string(optarg) == "packet-mmap") backend = Backend::PACKET_MMAP;
+                else if (std::string(optarg) == "xdp") backend = Backend::XDP;
+                else if (std::string(optarg) == "io-uring") backend = Backend::IO_URING;
+                else if (std::string(optarg) == "connect") backend = Backend::CONNECT;
+                else {
+                    std::cerr << "Invalid backend: " << optarg << std::endl;
+                    exit(1);
+                }
+                break;
+            case 'r':
+                showRtt = true;
+                break;
+            case 'c':
+                if (!parseNumber(optarg, 1, std::numeric_limits<int>::max(), hostProbes)) {
+                    std::cerr << "Probes per host must be a number greater than 0" << std::endl;
+                    exit(1);
+                }
+                break;
+            case 'x': {
+                // comma separated prefixes of both IP versions
+                std::string list = optarg;
+                for (size_t start = 0, end; start <= list.size(); start = end + 1) {
+                    end = std::min(list.find(',', start), list.size());
+                    if (end == start) continue;
+                    if (!exclusions.add(list.substr(start, end - start))) {
+                        std::cerr << "Invalid exclusion: " << list.substr(start, end - start) << std::endl;
+                        exit(1);
+                    }
+                }
+                break;
+            }
+            case 'X':
+                try {
+                    exclusions.addFile(optarg);
+                } catch (const std::exception &e) {
+                    std::cerr << e.what() << std::endl;
+                    exit(1);
+                }
+                break;
+            case 'B':
+                if (!parseNumber(optarg, 1, BANNER_MAX_BYTES, bannerBytes)) {
+                    std::cerr << "Banner size must be a number between 1 and " << BANNER_MAX_BYTES << std::endl;
+                    exit(1);
+                }
+                break;
+            case 'D':
+                daemonPath = optarg;
+                break;
+            case 'W':
+                if (!parseNumber(optarg, 1, std::numeric_limits<int>::max(), watchInterval)) {
+                    std::cerr << "Watch interval must be a number greater than 0" << std::endl;
+                    exit(1);
+                }
+                break;
             case 'h':
                 printHelp();
                 exit(0);
@@ -195,6 +202,24 @@ Settings::Settings(int argc, char *argv[]) {
     } 
 
     bool targetSet = optind < argc; 
+    // the jobs bring their targets and ports, the options are their defaults
+    if (!daemonPath.empty()) {
+        if (!interfaceSet) {
+            std::cerr << "Missing interface seek -h|--help for help" << std::endl;
+            exit(1);
+        }
+        if (targetSet || portsSet) {
+            std::cerr << "The daemon takes the targets and the ports from its jobs" << std::endl;
+            exit(1);
+        }
+        if (watchInterval > 0) {
+            std::cerr << "The daemon runs its jobs once, it does not watch" << std::endl;
+            exit(1);
+        }
+        exclusions.build();
+        mode = Mode::DAEMON;
+        return;
+    }
     // print interfaces
     if (!interfaceSet) {
         if (!portsSet && !targetSet && !timeoutSet) {
@@ -211,45 +236,38 @@ Settings::Settings(int argc, char *argv[]) {
         exit(1);
     } 
 
-    mode = Mode::SCAN;
-    std::pair<std::string, std::string> adresses; 
-    // get the target
-    switch(determinTargetType(argv[optind])) {
-        case TargetType::IP_v4:
-            targetIp4.push_back({"", argv[optind], IpVersion::IPV4, -1});
-            Targetipv4 = true;
-            break;
-        case TargetType::IP_v6:
-            targetIp6.push_back({"", argv[optind], IpVersion::IPV6, -1});
-            Targetipv6 = true;
-            break;
-        case TargetType::DOMAIN_NAME:
-            getTargetIPsFromDomain(argv[optind]);
-            if (!Targetipv4 && !Targetipv6) {
-                std::cerr << "No valid IP addresses(es) found for domain: " << argv[optind] << std::endl;
+    mode = (watchInterval > 0) ? Mode::WATCH : Mode::SCAN;
+    // the prefixes are all known, the lookup table can be built
+    exclusions.build();
+
+    // get the targets, all of them are scanned at once
+    for (int i = optind; i < argc; i++) {
+        NetworkAdress targetIp;
+        switch(determinTargetType(argv[i])) {
+            case TargetType::IP_v4:
+            case TargetType::IP_v6:
+                if (!parseAddress(argv[i], targetIp)) {
+                    std::cerr << "Invalid target IP address: " << argv[i] << std::endl;
+                    exit(1);
+                }
+                addTargetIp(targetIp);
+                break;
+            case TargetType::DOMAIN_NAME:
+                getTargetIPsFromDomain(argv[i]);
+                if (!Targetipv4 && !Targetipv6) {
+                    std::cerr << "No valid IP addresses(es) found for domain: " << argv[i] << std::endl;
+                    exit(1);
+                }
+                break;
+            default:
+                std::cerr << "Invalid target type" << std::endl;
                 exit(1);
-            }
-            break;
-        default:
-            std::cerr << "Invalid target type" << std::endl;
-            exit(1);
-    }; 
+        };
+    }
 
-    // check if the target is localhost
-    // set the interface to lo, incase the target is localhost
-    if (
-        (   // ipv4
-            targetIp4.size() == 1 && (
-            targetIp4[0].hostName == "localhost" ||
-            targetIp4[0].ip == "127.0.0.1")
-        ) ||
-        (   // ipv6
-            targetIp6.size() == 1 && (
-            targetIp6[0].hostName == "localhost" ||
-            targetIp6[0].ip == "::1")
-        )
-    ) {
-        interfaceName = "lo";
+    if (!Targetipv4 && !Targetipv6) {
+        std::cerr << "All targets are excluded" << std::endl;
+        exit(1);
     }
 } 
 
@@ -266,14 +284,24 @@ NetworkAdress* Settings::getTargetIp6() {
 } 
 
 void Settings::printHelp() const {
-    std::cout << "Usage: ./ipk-l4-scan [OPTIONS] TARGET" << std::endl;
+    std::cout << "Usage: ./ipk-l4-scan [OPTIONS] TARGET..." << std::endl;
     std::cout << "Options:" << std::endl;
     std::cout << "  -i, --interface=INTERFACE  Interface to use for scanning" << std::endl;
     std::cout << "  -t, --pt=PORTS             TCP ports to scan" << std::endl;
     std::cout << "  -u, --pu=PORTS             UDP ports to scan" << std::endl;
+    std::cout << "  -T, --top-ports=N          The N most common TCP ports, the most common first" << std::endl;
+    std::cout << "  -U, --top-udp-ports=N      The N most common UDP ports, the most common first" << std::endl;
     std::cout << "  -w, --wait=TIMEOUT         Timeout for the scan" << std::endl;
+    std::cout << "  -b, --backend=BACKEND      Packet transport [raw | packet-mmap | xdp | io-uring | connect]" << std::endl;
+    std::cout << "  -r, --rtt                  Print the round trip time of the answered ports" << std::endl;
+    std::cout << "  -c, --host-probes=N        Max probes in flight to one host" << std::endl;
+    std::cout << "  -x, --exclude=CIDRS        Prefixes never to probe, comma separated [IPv4 | IPv6]" << std::endl;
+    std::cout << "  -X, --exclude-file=FILE    File with prefixes never to probe, one per line" << std::endl;
+    std::cout << "  -B, --banner=BYTES         Read up to BYTES of the banner of the open TCP ports" << std::endl;
+    std::cout << "  -D, --daemon=SOCKET        Run as a daemon, that takes scan jobs on the Unix domain socket" << std::endl;
+    std::cout << "  -W, --watch=SECONDS        Scan again every SECONDS, print only the ports, whose state changed" << std::endl;
     std::cout << "  --help                     Print this help message" << std::endl;
-    std::cout << "   TARGET                    Target to scan [IPv4 | IPv6 | Domain]" << std::endl;
+    std::cout << "   TARGET                    Targets to scan [IPv4 | IPv6 | Domain], scanned at once" << std::endl;
 }
  
  
\ No newline at end of file
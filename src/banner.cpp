@@ -0,0 +1,220 @@
+/**
+ * @file banner.cpp
+ * @brief File for the banner stage (reads the greeting of the open TCP ports over non-blocking connections)
+ * @author Martin Mendl <x247581>
+ * @date 2025-12-23
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include "banner.hpp"
+#include "connect.hpp"
+
+// Constructor for BannerGrabber class
+BannerGrabber::BannerGrabber(const NetworkInterface &sender4, const NetworkInterface &sender6, int bytes, int timeout, bool avoidProbePorts, ResultCallback onResult) {
+    this->sender4 = sender4;
+    this->sender6 = sender6;
+    this->bytes = std::clamp(bytes, 1, BANNER_MAX_BYTES);
+    this->timeout = timeout;
+    this->avoidProbePorts = avoidProbePorts;
+    this->onResult = onResult;
+    socketLimit = connectSocketLimit();
+
+    epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollfd < 0) {
+        perror("epoll_create1 failed");
+        throw std::runtime_error("Failed to create the epoll set");
+    }
+
+    // the banners are read in place, the connections do not allocate
+    connections.resize(socketLimit);
+    buffers.resize(socketLimit * this->bytes);
+    freeSlots.reserve(socketLimit);
+    for (int slot = socketLimit - 1; slot >= 0; slot--) freeSlots.push_back(slot);
+    expiries.reserve(socketLimit);
+    queued.reserve(socketLimit);
+}
+
+// Destructor for BannerGrabber class
+BannerGrabber::~BannerGrabber() {
+    for (Connection &connection : connections) {
+        if (connection.fd >= 0) close(connection.fd);
+    }
+    if (epollfd >= 0) close(epollfd);
+}
+
+// Method to add the epoll set to the poll set of the scan loop
+void BannerGrabber::addPollFds(std::vector<struct pollfd> &fds, int &timeoutMs) const {
+    if (inFlight > 0) fds.push_back({epollfd, POLLIN, 0});
+
+    // queued ports, that have a free slot, are started in the next pass
+    int wait = (!queued.empty() && inFlight < socketLimit) ? 0 : nextTimeoutMs();
+    if (wait >= 0 && (timeoutMs < 0 || wait < timeoutMs)) timeoutMs = wait;
+}
+
+// Method to start the connects of the queued ports, up to the limits
+void BannerGrabber::startQueued() {
+    for (int started = 0; started < BANNER_STARTS_PER_PASS && !queued.empty() && inFlight < socketLimit; started++) {
+        PortResult &result = queued.front();
+        const NetworkInterface &sender = (result.target.ipVer == IpVersion::IPV4) ? sender4 : sender6;
+
+        int fd;
+        int error = startConnect(sender, result.target, result.port, fd, avoidProbePorts);
+        if (fd < 0 || error == EAGAIN || error == EADDRNOTAVAIL) {
+            // out of descriptors or local ports, the port waits for a connection to finish
+            if (fd >= 0) close(fd);
+            if (inFlight > 0) {
+                socketLimit = inFlight;
+                return;
+            }
+            // nothing to wait for, the port goes on without its banner
+            onResult(result);
+            queued.pop_front();
+            continue;
+        }
+
+        int slot = freeSlots.back();
+        freeSlots.pop_back();
+        Connection &connection = connections[slot];
+        connection.fd = fd;
+        connection.result = result;
+        connection.received = 0;
+        connection.startedAt = Clock::now();
+        queued.pop_front();
+        inFlight++;
+
+        // the greeting is waited for, a failed connect shows up as an error
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.u32 = slot;
+        if ((error != 0 && error != EINPROGRESS) || epoll_ctl(epollfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            finish(slot);
+            continue;
+        }
+        expiries.push_back({slot, connection.startedAt});
+    }
+}
+
+// Method to read from a ready connection
+void BannerGrabber::receive(int slot, uint32_t events) {
+    Connection &connection = connections[slot];
+    char *banner = &buffers[slot * bytes];
+
+    while (connection.received < bytes) {
+        ssize_t received = recv(connection.fd, banner + connection.received, bytes - connection.received, MSG_DONTWAIT);
+        if (received > 0) {
+            connection.received += received;
+            continue;
+        }
+        // the service closed the connection or refused it, the banner is what came
+        if (received == 0 || (errno != EAGAIN && errno != EINTR)) {
+            finish(slot);
+            return;
+        }
+        if (errno == EAGAIN) break;
+    }
+
+    // a full banner, or a greeting, that ends its line, is not waited on
+    bool lineEnded = connection.received > 0 && banner[connection.received - 1] == '\n';
+    if (connection.received == bytes || lineEnded || (events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP))) finish(slot);
+}
+
+// Method to close a connection and pass on the port with its banner
+void BannerGrabber::finish(int slot) {
+    Connection &connection = connections[slot];
+    connection.result.banner.assign(&buffers[slot * bytes], connection.received);
+
+    // reset, not closed, so the scan leaves no TIME_WAIT sockets behind
+    struct linger reset = {1, 0};
+    setsockopt(connection.fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+    close(connection.fd);
+    connection.fd = -1;
+    freeSlots.push_back(slot);
+    inFlight--;
+
+    onResult(connection.result);
+}
+
+// Method to finish the connections, that ran out of time
+void BannerGrabber::expire() {
+    Clock::time_point now = Clock::now();
+    while (!expiries.empty()) {
+        auto [slot, startedAt] = expiries.front();
+        // the connection finished already, the slot may be in use by another one
+        if (connections[slot].fd < 0 || connections[slot].startedAt != startedAt) {
+            expiries.pop_front();
+            continue;
+        }
+        if (now - startedAt < std::chrono::milliseconds(timeout)) break;
+        expiries.pop_front();
+        finish(slot);
+    }
+}
+
+// Method to get the time until the next connection times out
+int BannerGrabber::nextTimeoutMs() const {
+    if (expiries.empty()) return -1;
+    auto left = std::chrono::ceil<std::chrono::milliseconds>(expiries.front().second + std::chrono::milliseconds(timeout) - Clock::now());
+    return std::max(0, int(left.count()));
+}
+
+// Method to start the queued connects, read the ready sockets and expire the late ones, without blocking
+void BannerGrabber::process() {
+    startQueued();
+    if (inFlight == 0) return;
+
+    struct epoll_event events[BANNER_EVENTS];
+    int ready = epoll_wait(epollfd, events, BANNER_EVENTS, 0);
+    if (ready < 0 && errno != EINTR) {
+        perror("epoll_wait failed");
+        throw std::runtime_error("Failed to wait for the banners");
+    }
+    for (int i = 0; i < ready; i++) receive(events[i].data.u32, events[i].events);
+    expire();
+}
+
+// Method to read the banners of all the queued ports
+void BannerGrabber::run() {
+    std::vector<struct pollfd> fds;
+    while (!finished()) {
+        int timeoutMs = -1;
+        fds.clear();
+        addPollFds(fds, timeoutMs);
+        if (poll(fds.data(), fds.size(), timeoutMs) < 0 && errno != EINTR) {
+            perror("poll failed");
+            throw std::runtime_error("Failed to wait for the banners");
+        }
+        process();
+    }
+}
+
+// function to make a banner printable on one line
+std::string quoteBanner(const std::string &banner) {
+    std::string quoted = "\"";
+    for (unsigned char c : banner) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (c == '\r') {
+            quoted += "\\r";
+        } else if (c == '\n') {
+            quoted += "\\n";
+        } else if (c == '\t') {
+            quoted += "\\t";
+        } else if (c < 0x20 || c >= 0x7f) {
+            char escaped[5];
+            snprintf(escaped, sizeof(escaped), "\\x%02x", c);
+            quoted += escaped;
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
@@ -0,0 +1,260 @@
+/**
+ * @file connect.cpp
+ * @brief File for the connect scan (non-blocking TCP connects tracked with epoll, no raw sockets needed)
+ * @author Martin Mendl <x247581>
+ * @date 2025-12-16
+ */
+
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include "connect.hpp"
+#include "portalloc.hpp"
+
+// linux 6.3, not in the headers of older C libraries
+#ifndef IP_LOCAL_PORT_RANGE
+#define IP_LOCAL_PORT_RANGE 51
+#endif
+
+// function to get the number of sockets a connect scan may open
+int connectSocketLimit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) < 0) {
+        perror("getrlimit failed");
+        throw std::runtime_error("Failed to read the open file limit");
+    }
+
+    // the soft limit is often 1024, the hard one is ours to take
+    rlim_t wanted = CONNECT_MAX_SOCKETS + CONNECT_RESERVED_FDS;
+    if (limit.rlim_cur < wanted && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = std::min(wanted, limit.rlim_max);
+        if (setrlimit(RLIMIT_NOFILE, &limit) < 0) getrlimit(RLIMIT_NOFILE, &limit);
+    }
+    return std::clamp(int(std::min<rlim_t>(limit.rlim_cur, wanted)) - CONNECT_RESERVED_FDS, 1, CONNECT_MAX_SOCKETS);
+}
+
+// function to open a non-blocking TCP socket bound to the interface and start its connect
+int startConnect(const NetworkInterface &sender, const NetworkAdress &target, int port, int &fd, bool avoidProbePorts) {
+    fd = socket((target.ipVer == IpVersion::IPV4) ? AF_INET : AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return errno;
+    // without CAP_NET_RAW this needs linux 5.7, an older kernel routes the connect by the target alone
+    if (!sender.name.empty()) setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, sender.name.c_str(), sender.name.length());
+    if (avoidProbePorts) {
+        // the XDP program takes the replies to the source ports of the probes, the kernel picks a local port below them
+        uint32_t range = uint32_t(SOURCE_PORT_BASE - 1) << 16;
+        setsockopt(fd, IPPROTO_IP, IP_LOCAL_PORT_RANGE, &range, sizeof(range));
+    }
+
+    struct sockaddr_storage addr;
+    socklen_t addrLen;
+    memset(&addr, 0, sizeof(addr));
+    if (target.ipVer == IpVersion::IPV4) {
+        toSockaddr(target, *(struct sockaddr_in*)&addr);
+        ((struct sockaddr_in*)&addr)->sin_port = htons(port);
+        addrLen = sizeof(struct sockaddr_in);
+    } else {
+        toSockaddr(target, *(struct sockaddr_in6*)&addr);
+        ((struct sockaddr_in6*)&addr)->sin6_port = htons(port);
+        addrLen = sizeof(struct sockaddr_in6);
+    }
+    return (connect(fd, (struct sockaddr*)&addr, addrLen) < 0) ? errno : 0;
+}
+
+// function to check, if the socket connected to itself, a local port picked equal to the target port (simultaneous open)
+static bool isSelfConnect(int fd) {
+    struct sockaddr_storage local, peer;
+    socklen_t localLen = sizeof(local), peerLen = sizeof(peer);
+    if (getsockname(fd, (struct sockaddr*)&local, &localLen) < 0 || getpeername(fd, (struct sockaddr*)&peer, &peerLen) < 0) return false;
+    return localLen == peerLen && memcmp(&local, &peer, localLen) == 0;
+}
+
+// Constructor for ConnectScanner class
+ConnectScanner::ConnectScanner(const NetworkInterface &sender4, const NetworkInterface &sender6, std::vector<NetworkAdress> targets, std::vector<int> ports, int timeout) {
+    this->sender4 = sender4;
+    this->sender6 = sender6;
+    this->targets = targets;
+    this->ports = ports;
+    this->timeout = timeout;
+    socketLimit = connectSocketLimit();
+
+    epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollfd < 0) {
+        perror("epoll_create1 failed");
+        throw std::runtime_error("Failed to create the epoll set");
+    }
+
+    // every slot gets its socket, when it is free
+    attempts.resize(socketLimit);
+    freeSlots.reserve(socketLimit);
+    for (int slot = socketLimit - 1; slot >= 0; slot--) freeSlots.push_back(slot);
+    expiries.reserve(socketLimit);
+}
+
+// Destructor for ConnectScanner class
+ConnectScanner::~ConnectScanner() {
+    for (Attempt &attempt : attempts) {
+        if (attempt.fd >= 0) close(attempt.fd);
+    }
+    if (epollfd >= 0) close(epollfd);
+}
+
+// Method to start the connect of the next port
+bool ConnectScanner::startNext(const ResultCallback &onResult) {
+    // ports outer, targets inner, the hosts take turns like in the scheduler
+    const NetworkAdress &target = targets[next % targets.size()];
+    int port = ports[next / targets.size()];
+    const NetworkInterface &sender = (target.ipVer == IpVersion::IPV4) ? sender4 : sender6;
+
+    Clock::time_point sentAt = Clock::now();
+    int fd;
+    int error = startConnect(sender, target, port, fd);
+    if (fd < 0) {
+        // out of descriptors or memory, the limit is lowered to what is open and the connects are waited for
+        if ((error == EMFILE || error == ENFILE || error == ENOBUFS || error == ENOMEM) && inFlight > 0) {
+            socketLimit = inFlight;
+            return false;
+        }
+        errno = error;
+        perror("socket failed");
+        throw std::runtime_error("Failed to create the connect socket");
+    }
+    if (error == EAGAIN || error == EADDRNOTAVAIL) {
+        // no local port is free, the connects in flight give theirs back
+        close(fd);
+        if (inFlight == 0) {
+            errno = error;
+            perror("connect failed");
+            throw std::runtime_error("Failed to connect, no local port is free");
+        }
+        socketLimit = inFlight;
+        return false;
+    }
+
+    int slot = freeSlots.back();
+    freeSlots.pop_back();
+    Attempt &attempt = attempts[slot];
+    attempt.fd = fd;
+    attempt.target = next % targets.size();
+    attempt.port = port;
+    attempt.sentAt = sentAt;
+    inFlight++;
+    next++;
+
+    // loopback connects often finish in the call already
+    if (error == 0 && isSelfConnect(fd)) error = ECONNREFUSED;
+    if (error != EINPROGRESS) {
+        finish(slot, error, onResult);
+        return true;
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLOUT;
+    event.data.u32 = slot;
+    if (epoll_ctl(epollfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        perror("epoll_ctl failed");
+        throw std::runtime_error("Failed to add the connect socket to the epoll set");
+    }
+    expiries.push_back({slot, attempt.sentAt});
+    return true;
+}
+
+// Method to finish a connect with its result
+void ConnectScanner::finish(int slot, int error, const ResultCallback &onResult) {
+    Attempt &attempt = attempts[slot];
+
+    PortResult result;
+    result.target = targets[attempt.target];
+    result.port = attempt.port;
+    result.protocol = Protocol::TCP;
+    // a RST refuses the connect, everything else, that is not a handshake, is a filter or the timeout
+    result.result = (error == 0) ? ScanResult::OPEN : (error == ECONNREFUSED) ? ScanResult::CLOSED : ScanResult::FILTERED;
+    if (result.result != ScanResult::FILTERED) {
+        result.rttNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - attempt.sentAt).count();
+    }
+
+    // an open port is reset instead of closed, the scan leaves no TIME_WAIT sockets behind
+    if (error == 0) {
+        struct linger reset = {1, 0};
+        setsockopt(attempt.fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+    }
+    close(attempt.fd);
+    attempt.fd = -1;
+    freeSlots.push_back(slot);
+    inFlight--;
+
+    onResult(result);
+}
+
+// Method to finish the connects, that ran out of time
+void ConnectScanner::expire(const ResultCallback &onResult) {
+    Clock::time_point now = Clock::now();
+    while (!expiries.empty()) {
+        auto [slot, sentAt] = expiries.front();
+        // the connect finished already, the slot may be in use by another one
+        if (attempts[slot].fd < 0 || attempts[slot].sentAt != sentAt) {
+            expiries.pop_front();
+            continue;
+        }
+        if (now - sentAt < std::chrono::milliseconds(timeout)) break;
+        expiries.pop_front();
+        finish(slot, ETIMEDOUT, onResult);
+    }
+}
+
+// Method to get the time until the next connect times out
+int ConnectScanner::nextTimeoutMs() const {
+    if (expiries.empty()) return -1;
+    auto left = std::chrono::ceil<std::chrono::milliseconds>(expiries.front().second + std::chrono::milliseconds(timeout) - Clock::now());
+    return std::max(0, int(left.count()));
+}
+
+// Method to start the connects, that fit, wait for the sockets and finish the ready and the late ones
+void ConnectScanner::step(int timeoutMs, const ResultCallback &onResult) {
+    // open sockets up to the limit
+    while (next < targets.size() * ports.size() && inFlight < socketLimit && startNext(onResult)) {}
+    if (inFlight == 0) return;
+
+    struct epoll_event events[CONNECT_EVENTS];
+    int ready = epoll_wait(epollfd, events, CONNECT_EVENTS, (timeoutMs < 0) ? nextTimeoutMs() : timeoutMs);
+    if (ready < 0 && errno != EINTR) {
+        perror("epoll_wait failed");
+        throw std::runtime_error("Failed to wait for the connects");
+    }
+
+    // the error of the socket is the result of the connect
+    for (int i = 0; i < ready; i++) {
+        int slot = events[i].data.u32;
+        int error = 0;
+        socklen_t errorLen = sizeof(error);
+        if (getsockopt(attempts[slot].fd, SOL_SOCKET, SO_ERROR, &error, &errorLen) < 0) error = errno;
+        if (error == 0 && isSelfConnect(attempts[slot].fd)) error = ECONNREFUSED;
+        finish(slot, error, onResult);
+    }
+    expire(onResult);
+}
+
+// Method to scan all the ports of all the targets
+void ConnectScanner::run(const ResultCallback &onResult) {
+    while (!finished()) step(-1, onResult);
+}
+
+// Method to add the epoll set to the poll set of a loop, that drives several scans
+void ConnectScanner::addPollFds(std::vector<struct pollfd> &fds, int &timeoutMs) const {
+    if (inFlight > 0) fds.push_back({epollfd, POLLIN, 0});
+
+    // a free socket is used in the next pass
+    int wait = (next < targets.size() * ports.size() && inFlight < socketLimit) ? 0 : nextTimeoutMs();
+    if (wait >= 0 && (timeoutMs < 0 || wait < timeoutMs)) timeoutMs = wait;
+}
+
+// Method to start the connects, that fit, and finish the ready and the late ones, without blocking
+void ConnectScanner::process(const ResultCallback &onResult) {
+    step(0, onResult);
+}
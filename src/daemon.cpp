@@ -0,0 +1,304 @@
+/**
+ * @file daemon.cpp
+ * @brief File for the scan daemon (scan jobs over a Unix domain socket, all of them in one event loop)
+ * @author Martin Mendl <x247581>
+ * @date 2025-12-30
+ */
+
+#include <iostream>
+#include <sstream>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include "daemon.hpp"
+
+// set by SIGINT and SIGTERM, the loop stops after the pass
+static volatile sig_atomic_t stopRequested = 0;
+
+// function to note the stop signal
+static void requestStop(int) {
+    stopRequested = 1;
+}
+
+// Constructor for ScanDaemon class
+ScanDaemon::ScanDaemon(const std::string &path, const DaemonDefaults &defaults, const ExcludeList &exclusions) : exclusions(exclusions), runner(DAEMON_INITIAL_WINDOW, DAEMON_MAX_WINDOW) {
+    this->path = path;
+    this->defaults = defaults;
+
+    // the default interface has to exist
+    NetworkInterface sender;
+    ScanError error = ScanCache().findInterface(defaults.interfaceName, true, sender);
+    if (error) throw std::runtime_error(error.message);
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Invalid daemon socket path: " + path);
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size());
+
+    listenfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenfd < 0) {
+        perror("socket failed");
+        throw std::runtime_error("Failed to create the daemon socket");
+    }
+
+    // a socket nobody listens on is left from a daemon, that did not stop cleanly
+    if (connect(listenfd, (struct sockaddr*)&addr, sizeof(addr)) == 0 || errno == EAGAIN) {
+        close(listenfd);
+        throw std::runtime_error("Another daemon listens on " + path);
+    }
+    if (errno == ECONNREFUSED) unlink(path.c_str());
+    close(listenfd);
+
+    listenfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenfd < 0) {
+        perror("socket failed");
+        throw std::runtime_error("Failed to create the daemon socket");
+    }
+    // the jobs send raw packets, only the owner of the daemon may submit them, the socket is created without access for the others
+    mode_t mask = umask(S_IRWXG | S_IRWXO);
+    int bound = bind(listenfd, (struct sockaddr*)&addr, sizeof(addr));
+    umask(mask);
+    if (bound < 0) {
+        perror("bind failed");
+        close(listenfd);
+        throw std::runtime_error("Failed to bind the daemon socket to " + path);
+    }
+    if (chmod(path.c_str(), S_IRUSR | S_IWUSR) < 0) {
+        perror("chmod failed");
+        close(listenfd);
+        unlink(path.c_str());
+        throw std::runtime_error("Failed to restrict the daemon socket " + path);
+    }
+    if (listen(listenfd, DAEMON_MAX_CLIENTS) < 0) {
+        perror("listen failed");
+        close(listenfd);
+        unlink(path.c_str());
+        throw std::runtime_error("Failed to listen on the daemon socket");
+    }
+}
+
+// Destructor for ScanDaemon class
+ScanDaemon::~ScanDaemon() {
+    for (Client &client : clients) {
+        client.job.reset();
+        close(client.fd);
+    }
+    if (listenfd >= 0) {
+        close(listenfd);
+        unlink(path.c_str());
+    }
+}
+
+// Method to accept the waiting clients
+void ScanDaemon::acceptClients() {
+    while (clients.size() < size_t(DAEMON_MAX_CLIENTS)) {
+        int fd = accept4(listenfd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EINTR && errno != ECONNABORTED) perror("accept failed");
+            return;
+        }
+        clients.emplace_back();
+        clients.back().fd = fd;
+    }
+}
+
+// Method to queue a frame for the client, the client is dropped, if its backlog is full
+void ScanDaemon::sendFrame(Client &client, const std::string &payload) {
+    if (client.closing) return;
+    // the socket takes what it can, a client, that still does not read, stops its job and is closed after the pass
+    if (client.output.size() + sizeof(uint32_t) + payload.size() > DAEMON_MAX_OUTPUT) writeClient(client);
+    if (client.output.size() + sizeof(uint32_t) + payload.size() > DAEMON_MAX_OUTPUT) {
+        client.closing = true;
+        return;
+    }
+    uint32_t length = htonl(payload.size());
+    client.output.append((const char*)&length, sizeof(length));
+    client.output += payload;
+}
+
+// Method to send the pending frames of a client
+void ScanDaemon::writeClient(Client &client) {
+    size_t sent = 0;
+    while (sent < client.output.size()) {
+        ssize_t written = send(client.fd, client.output.data() + sent, client.output.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (written > 0) {
+            sent += written;
+            continue;
+        }
+        if (written < 0 && errno == EINTR) continue;
+        // a full socket is tried again after POLLOUT, anything else means the client is gone
+        if (written < 0 && errno != EAGAIN) client.closing = true;
+        break;
+    }
+    client.output.erase(0, sent);
+}
+
+// Method to read from a client and start the job of a whole frame
+void ScanDaemon::readClient(Client &client) {
+    char buffer[4096];
+    while (true) {
+        ssize_t received = recv(client.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (received > 0) {
+            client.input.append(buffer, received);
+            continue;
+        }
+        if (received < 0 && errno == EINTR) continue;
+        // a client, that shut its side down, still gets the answers to its job, an error means, it left, its job is stopped
+        if (received == 0) client.inputClosed = true;
+        else if (errno != EAGAIN) client.closing = true;
+        break;
+    }
+
+    while (!client.closing && client.input.size() >= sizeof(uint32_t)) {
+        uint32_t length;
+        memcpy(&length, client.input.data(), sizeof(length));
+        length = ntohl(length);
+        if (length > DAEMON_MAX_FRAME) {
+            client.closing = true;
+            return;
+        }
+        if (client.input.size() < sizeof(length) + length) return;
+
+        std::string request = client.input.substr(sizeof(length), length);
+        client.input.erase(0, sizeof(length) + length);
+        if (client.job) sendFrame(client, "error a job is running on this connection");
+        else startJob(client, request);
+    }
+}
+
+// Method to parse a job and start it
+void ScanDaemon::startJob(Client &client, const std::string &request) {
+    std::unique_ptr<Job> job = std::make_unique<Job>();
+    ScanJob &scan = job->scan;
+    scan.interface(defaults.interfaceName).backend(defaults.backend).timeout(defaults.timeout).hostProbes(defaults.hostProbes).banner(defaults.bannerBytes).exclude(exclusions);
+
+    // one "key value" pair per line, the job checks the values
+    std::istringstream lines(request);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        size_t space = line.find(' ');
+        std::string key = line.substr(0, space);
+        std::string value = (space == std::string::npos) ? "" : line.substr(space + 1);
+
+        int number = 0;
+        bool numeric = key == "top-ports" || key == "top-udp-ports" || key == "wait" || key == "host-probes" || key == "banner";
+        if (numeric && !parseNumber(value, 0, std::numeric_limits<int>::max(), number)) {
+            sendFrame(client, "error invalid " + key + ": " + value);
+            return;
+        }
+        if (key == "target") scan.target(value);
+        else if (key == "tcp") scan.tcpPorts(value);
+        else if (key == "udp") scan.udpPorts(value);
+        else if (key == "top-ports") scan.topPorts(number);
+        else if (key == "top-udp-ports") scan.topUdpPorts(number);
+        else if (key == "wait") scan.timeout(number);
+        else if (key == "host-probes") scan.hostProbes(number);
+        else if (key == "banner") scan.banner(number);
+        else if (key == "interface") scan.interface(value);
+        else {
+            sendFrame(client, "error unknown key: " + key);
+            return;
+        }
+    }
+
+    job->id = nextJob++;
+    job->startedAt = Clock::now();
+    Client *owner = &client;
+    Job *running = job.get();
+    scan.onResult([this, owner, running](const PortResult &result) {
+        running->results++;
+        sendFrame(*owner, "result " + formatResult(result, true));
+    });
+
+    // the probes of all the jobs count against the window of the runner, a failed start leaves the daemon running
+    ScanError error = runner.add(scan);
+    for (const NetworkAdress &address : scan.getExcluded()) sendFrame(client, "excluded " + toString(address));
+    if (error) {
+        sendFrame(client, "error " + error.message);
+        return;
+    }
+    sendFrame(client, "accepted " + std::to_string(job->id) + " " + std::to_string(scan.getTargets().size()) + " " + std::to_string(scan.getPortCount()));
+    client.job = std::move(job);
+}
+
+// Method to serve the clients, until SIGINT or SIGTERM
+void ScanDaemon::run() {
+    // no SA_RESTART, the signal ends the poll
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    std::vector<struct pollfd> fds;
+    fds.reserve(DAEMON_MAX_CLIENTS + 16);
+    while (!stopRequested) {
+        // the runner moves the job, that sends first, on every pass, so no job starves the others at the shared window
+        runner.sendDue();
+
+        // the listening socket and the clients first, their order is the order of the list
+        int timeoutMs = -1;
+        fds.clear();
+        fds.push_back({listenfd, short((clients.size() < size_t(DAEMON_MAX_CLIENTS)) ? POLLIN : 0), 0});
+        for (Client &client : clients) {
+            fds.push_back({client.fd, short((client.inputClosed ? 0 : POLLIN) | (client.output.empty() ? 0 : POLLOUT)), 0});
+        }
+        runner.addPollFds(fds, timeoutMs);
+        if (poll(fds.data(), fds.size(), timeoutMs) < 0 && errno != EINTR) {
+            perror("poll failed");
+            throw std::runtime_error("Failed to wait for the clients and the jobs");
+        }
+
+        size_t index = 1;
+        for (Client &client : clients) {
+            short events = fds[index++].revents;
+            if (client.inputClosed) {
+                // both sides are shut down, nobody reads the answers any more
+                if (events & (POLLHUP | POLLERR)) client.closing = true;
+            } else if (events & (POLLIN | POLLHUP | POLLERR)) {
+                readClient(client);
+            }
+        }
+        runner.process();
+        for (Client &client : clients) {
+            if (!client.job || client.closing || !client.job->scan.finished()) continue;
+            Job &job = *client.job;
+            if (job.scan.getError()) {
+                // sockets, interfaces or a busy XDP queue, the daemon goes on
+                sendFrame(client, "error " + job.scan.getError().message);
+            } else {
+                long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - job.startedAt).count();
+                sendFrame(client, "done " + std::to_string(job.id) + " " + std::to_string(job.results) + " " + std::to_string(ms) + " ms drops " + std::to_string(job.scan.getDrops()));
+            }
+            client.job.reset();
+        }
+
+        // the results of the pass go out at once, a slow client keeps the rest for POLLOUT
+        for (auto client = clients.begin(); client != clients.end();) {
+            if (!client->output.empty() && !client->closing) writeClient(*client);
+            // a client, that shut its side down, is closed, once the answers to its last job are sent
+            if (client->inputClosed && !client->job && client->output.empty()) client->closing = true;
+            if (client->closing) {
+                client->job.reset();
+                close(client->fd);
+                client = clients.erase(client);
+            } else {
+                ++client;
+            }
+        }
+        if (fds[0].revents & POLLIN) acceptClients();
+    }
+}
@@ -0,0 +1,300 @@
+/**
+ * @file exclude.cpp
+ * @brief File for the exclusion list (CIDR prefixes, that are never probed, in a compressed radix trie)
+ * @author Martin Mendl <x247581>
+ * @date 2025-12-02
+ */
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <tuple>
+#include <endian.h>
+#include <arpa/inet.h>
+#include "exclude.hpp"
+
+// function to get the mask of the first bits of a 64 bit word
+static inline uint64_t maskBits(int bits) {
+    return (bits <= 0) ? 0 : (bits >= 64) ? ~uint64_t(0) : ~uint64_t(0) << (64 - bits);
+}
+
+// function to load the address as a 128 bit key, most significant bit first
+static inline void loadKey(const NetworkAdress &address, uint64_t key[2]) {
+    memcpy(key, address.addr, sizeof(address.addr));
+    key[0] = be64toh(key[0]);
+    key[1] = be64toh(key[1]);
+    // the bytes past an IPv4 address are not part of it
+    if (address.ipVer == IpVersion::IPV4) {
+        key[0] &= maskBits(32);
+        key[1] = 0;
+    }
+}
+
+// function to get the bit of the key at the position
+static inline int bitAt(const uint64_t key[2], int position) {
+    return (position < 64) ? (key[0] >> (63 - position)) & 1 : (key[1] >> (127 - position)) & 1;
+}
+
+// function to get the bits of the key from the position on, left aligned bits past the key are zero
+static inline uint32_t bitsAt(const uint64_t key[2], int position, int count) {
+    if (position >= 128) return 0;
+    uint64_t word = (position == 0) ? key[0] : (position < 64) ? (key[0] << position) | (key[1] >> (64 - position)) : key[1] << (position - 64);
+    return word >> (64 - count);
+}
+
+// function to set the bits of the key from the position on, the bits past the key are dropped
+static inline void setBitsAt(uint64_t key[2], int position, int count, uint32_t value) {
+    uint64_t word = uint64_t(value) << (64 - count);
+    if (position >= 128) return;
+    if (position < 64) {
+        key[0] |= word >> position;
+        if (position > 0) key[1] |= word << (64 - position);
+    } else {
+        key[1] |= word >> (position - 64);
+    }
+}
+
+// function to check, if the key starts with the prefix
+static inline bool matches(const uint64_t key[2], const uint64_t prefix[2], int length) {
+    return ((key[0] ^ prefix[0]) & maskBits(length)) == 0 && ((key[1] ^ prefix[1]) & maskBits(length - 64)) == 0;
+}
+
+// function to get the number of leading bits two keys share, up to the limit
+static inline int commonLength(const uint64_t a[2], const uint64_t b[2], int limit) {
+    uint64_t high = a[0] ^ b[0];
+    int common = high ? std::countl_zero(high) : 64 + std::countl_zero(a[1] ^ b[1]);
+    return std::min(common, limit);
+}
+
+// prefix of a file, parsed and waiting for the sort
+struct ParsedPrefix {
+    uint64_t key[2];            // the address as a key
+    int length;                 // length of the prefix
+    bool ipv6;                  // IP version of the prefix
+};
+
+// Constructor for ExcludeList class
+ExcludeList::ExcludeList() {
+    // the sentinel, so a child index of 0 means none, and the two roots
+    uint64_t zero[2] = {0, 0};
+    addNode(zero, 0, false);
+    addNode(zero, 0, false);
+    addNode(zero, 0, false);
+}
+
+// Method to add a new node
+uint32_t ExcludeList::addNode(const uint64_t prefix[2], int length, bool excluded) {
+    PrefixNode node = {};
+    node.prefix[0] = prefix[0] & maskBits(length);
+    node.prefix[1] = prefix[1] & maskBits(length - 64);
+    node.length = length;
+    node.excluded = excluded;
+    nodes.push_back(node);
+    return nodes.size() - 1;
+}
+
+// Method to parse a prefix
+bool ExcludeList::parse(const char *text, size_t size, NetworkAdress &address, int &length) {
+    // inet_pton needs the address terminated, the text is a line of a file or a part of the argument
+    char buffer[INET6_ADDRSTRLEN];
+    const char *slash = (const char*)memchr(text, '/', size);
+    size_t addressSize = slash ? size_t(slash - text) : size;
+    if (addressSize == 0 || addressSize >= sizeof(buffer)) return false;
+    memcpy(buffer, text, addressSize);
+    buffer[addressSize] = '\0';
+
+    memset(&address, 0, sizeof(address));
+    bool ipv6 = memchr(buffer, ':', addressSize) != nullptr;
+    if (inet_pton(ipv6 ? AF_INET6 : AF_INET, buffer, address.addr) != 1) return false;
+    address.ipVer = ipv6 ? IpVersion::IPV6 : IpVersion::IPV4;
+    address.valid = true;
+
+    int maxLength = ipv6 ? 128 : 32;
+    length = maxLength;
+    if (slash) {
+        const char *bits = slash + 1, *end = text + size;
+        if (bits == end || end - bits > 3) return false;
+        length = 0;
+        for (; bits != end; bits++) {
+            if (*bits < '0' || *bits > '9') return false;
+            length = length * 10 + (*bits - '0');
+        }
+        if (length > maxLength) return false;
+    }
+    return true;
+}
+
+// Method to add a prefix
+bool ExcludeList::add(const std::string &cidr) {
+    NetworkAdress address;
+    int length;
+    if (!parse(cidr.data(), cidr.size(), address, length)) return false;
+    add(address, length);
+    return true;
+}
+
+// Method to add a prefix in binary
+void ExcludeList::add(const NetworkAdress &address, int length) {
+    uint64_t key[2];
+    loadKey(address, key);
+    insert(key, length, address.ipVer == IpVersion::IPV6);
+}
+
+// Method to insert the key of a prefix into the trie
+void ExcludeList::insert(uint64_t key[2], int length, bool ipv6) {
+    length = std::clamp(length, 0, ipv6 ? 128 : 32);
+    key[0] &= maskBits(length);
+    key[1] &= maskBits(length - 64);
+    prefixes++;
+
+    // walk down, every node on the way is a prefix of the key, shorter than it
+    uint32_t n = ipv6 ? 2 : 1;
+    while (true) {
+        if (nodes[n].excluded) return;  // already covered
+        if (nodes[n].length == length) {
+            // the prefix covers the whole subtree, the longer prefixes below are not needed
+            nodes[n].excluded = true;
+            nodes[n].child[0] = nodes[n].child[1] = 0;
+            return;
+        }
+
+        int bit = bitAt(key, nodes[n].length);
+        uint32_t c = nodes[n].child[bit];
+        if (c == 0) {
+            uint32_t leaf = addNode(key, length, true);
+            nodes[n].child[bit] = leaf;
+            return;
+        }
+
+        int common = commonLength(key, nodes[c].prefix, std::min(length, int(nodes[c].length)));
+        if (common == nodes[c].length) {
+            n = c;
+            continue;
+        }
+        if (common == length) {
+            // the new prefix sits on the edge to the child and covers it
+            uint32_t leaf = addNode(key, length, true);
+            nodes[n].child[bit] = leaf;
+            return;
+        }
+
+        // the key and the child part ways on the edge, split it there
+        uint32_t split = addNode(key, common, false);
+        uint32_t leaf = addNode(key, length, true);
+        nodes[split].child[bitAt(nodes[c].prefix, common)] = c;
+        nodes[split].child[bitAt(key, common)] = leaf;
+        nodes[n].child[bit] = split;
+        return;
+    }
+}
+
+// Method to add the prefixes of a file
+void ExcludeList::addFile(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open the exclusion file: " + path);
+    }
+
+    // the file is read at once and split in place, a list of 100k prefixes loads without an allocation per line
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    const std::string content = stream.str();
+    const char *line = content.data(), *end = line + content.size();
+    std::vector<ParsedPrefix> parsed;
+    parsed.reserve(std::count(content.begin(), content.end(), '\n') + 1);
+
+    for (size_t number = 1; line < end; number++) {
+        const char *next = (const char*)memchr(line, '\n', end - line);
+        if (!next) next = end;
+
+        // drop the comment and the white space around the prefix
+        const char *last = (const char*)memchr(line, '#', next - line);
+        if (!last) last = next;
+        const char *first = line;
+        while (first < last && (*first == ' ' || *first == '\t' || *first == '\r')) first++;
+        while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) last--;
+
+        NetworkAdress address;
+        int length;
+        if (first != last) {
+            if (!parse(first, last - first, address, length)) {
+                throw std::runtime_error("Invalid prefix in " + path + " on line " + std::to_string(number) + ": " + std::string(first, last));
+            }
+            ParsedPrefix prefix;
+            loadKey(address, prefix.key);
+            prefix.length = length;
+            prefix.ipv6 = address.ipVer == IpVersion::IPV6;
+            parsed.push_back(prefix);
+        }
+        line = next + 1;
+    }
+
+    // in address order the insertions walk down the path of the last one, which is still in the cache
+    std::sort(parsed.begin(), parsed.end(), [](const ParsedPrefix &a, const ParsedPrefix &b) {
+        return std::tie(a.ipv6, a.key[0], a.key[1], a.length) < std::tie(b.ipv6, b.key[0], b.key[1], b.length);
+    });
+    nodes.reserve(nodes.size() + 2 * parsed.size());
+    for (ParsedPrefix &prefix : parsed) insert(prefix.key, prefix.length, prefix.ipv6);
+}
+
+// Method to fill the slots of the table, that the subtree of the node covers
+void ExcludeList::fillSlots(std::vector<uint32_t> &slots, uint32_t n, int start) const {
+    const PrefixNode &node = nodes[n];
+    int limit = start + EXCLUDE_STRIDE;
+    uint32_t slot = bitsAt(node.prefix, start, EXCLUDE_STRIDE);
+
+    if (node.length >= limit) {
+        slots[slot] = n;    // the rest of the address decides
+    } else if (node.excluded) {
+        std::fill_n(slots.begin() + slot, size_t(1) << (limit - node.length), EXCLUDED);
+    } else {
+        for (uint32_t child : node.child) if (child != 0) fillSlots(slots, child, start);
+    }
+}
+
+// Method to build the direct table
+void ExcludeList::build() {
+    for (int version = 0; version < 2; version++) {
+        table[version].clear();
+
+        // the table starts, where the prefixes of the IP version part ways
+        uint32_t start = 1 + version;
+        while (!nodes[start].excluded && (nodes[start].child[0] == 0) != (nodes[start].child[1] == 0)) {
+            start = nodes[start].child[0] | nodes[start].child[1];
+        }
+        // no prefix, or a single one, the walk is as short as the table
+        if (nodes[start].excluded || nodes[start].child[0] == 0) continue;
+
+        tableStart[version] = start;
+        table[version].assign(size_t(1) << EXCLUDE_STRIDE, NONE);
+        fillSlots(table[version], start, nodes[start].length);
+    }
+}
+
+// Method to check, if the address is excluded
+bool ExcludeList::contains(const NetworkAdress &address) const {
+    uint64_t key[2];
+    loadKey(address, key);
+    int version = (address.ipVer == IpVersion::IPV4) ? 0 : 1;
+
+    uint32_t n = 1 + version;
+    if (!table[version].empty()) {
+        const PrefixNode &start = nodes[tableStart[version]];
+        if (!matches(key, start.prefix, start.length)) return false;
+        n = table[version][bitsAt(key, start.length, EXCLUDE_STRIDE)];
+        if (n == NONE) return false;
+        if (n == EXCLUDED) return true;
+    }
+
+    // the first excluded prefix on the way is the answer, a longer one would not change it
+    while (true) {
+        const PrefixNode &node = nodes[n];
+        if (!matches(key, node.prefix, node.length)) return false;
+        if (node.excluded) return true;
+        n = node.child[bitAt(key, node.length)];
+        if (n == 0) return false;
+    }
+}
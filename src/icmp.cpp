@@ -0,0 +1,94 @@
+/**
+ * @file icmp.cpp
+ * @brief File for the ICMP and ICMPv6 error parser (quoted headers of the probes)
+ * @author Martin Mendl <x247581>
+ * @date 2025-06-04
+ */
+
+#include <cstring>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include <netinet/ip_icmp.h>
+#include <netinet/icmp6.h>
+#include "icmp.hpp"
+
+// Function to read the ports of the quoted TCP or UDP header, both start with them
+static bool quotedPorts(const char *l4, size_t len, int protocol, IcmpError &error) {
+    if (protocol != IPPROTO_TCP && protocol != IPPROTO_UDP) return false;
+    if (len < 4) return false;  // only the first 8 bytes are guaranteed, the ports are in the first 4
+
+    uint16_t ports[2];
+    memcpy(ports, l4, sizeof(ports));
+    error.protocol = protocol;
+    error.sourcePort = ntohs(ports[0]);
+    error.targetPort = ntohs(ports[1]);
+    return true;
+}
+
+// Function to parse an ICMP destination unreachable
+static bool parseIcmpv4(const char *icmp, size_t len, IcmpError &error) {
+    if (len < sizeof(struct icmphdr) + sizeof(struct iphdr)) return false;
+
+    const struct icmphdr *icmpHeader = (const struct icmphdr*)icmp;
+    if (icmpHeader->type != ICMP_DEST_UNREACH) return false;
+    error.type = icmpHeader->type;
+    error.code = icmpHeader->code;
+
+    // the original IP header and the first 8 bytes of its payload follow the ICMP header
+    const char *quoted = icmp + sizeof(struct icmphdr);
+    len -= sizeof(struct icmphdr);
+    const struct iphdr *quotedIp = (const struct iphdr*)quoted;
+    size_t quotedIpLen = quotedIp->ihl * 4;
+    if (quotedIpLen < sizeof(struct iphdr) || len < quotedIpLen) return false;
+
+    memcpy(error.source, &quotedIp->saddr, sizeof(quotedIp->saddr));
+    memcpy(error.target, &quotedIp->daddr, sizeof(quotedIp->daddr));
+    return quotedPorts(quoted + quotedIpLen, len - quotedIpLen, quotedIp->protocol, error);
+}
+
+// Function to parse an ICMPv6 destination unreachable
+static bool parseIcmpv6(const char *icmp, size_t len, IcmpError &error) {
+    if (len < sizeof(struct icmp6_hdr) + sizeof(struct ip6_hdr)) return false;
+
+    const struct icmp6_hdr *icmp6Header = (const struct icmp6_hdr*)icmp;
+    if (icmp6Header->icmp6_type != ICMP6_DST_UNREACH) return false;
+    error.type = icmp6Header->icmp6_type;
+    error.code = icmp6Header->icmp6_code;
+
+    const char *quoted = icmp + sizeof(struct icmp6_hdr);
+    len -= sizeof(struct icmp6_hdr);
+    const struct ip6_hdr *quotedIp = (const struct ip6_hdr*)quoted;
+    memcpy(error.source, &quotedIp->ip6_src, sizeof(quotedIp->ip6_src));
+    memcpy(error.target, &quotedIp->ip6_dst, sizeof(quotedIp->ip6_dst));
+
+    // skip the extension headers, that can sit between the IPv6 header and the probe
+    int next = quotedIp->ip6_nxt;
+    size_t offset = sizeof(struct ip6_hdr);
+    while (next == IPPROTO_HOPOPTS || next == IPPROTO_ROUTING || next == IPPROTO_DSTOPTS) {
+        if (len < offset + sizeof(struct ip6_ext)) return false;
+        const struct ip6_ext *ext = (const struct ip6_ext*)(quoted + offset);
+        next = ext->ip6e_nxt;
+        offset += (ext->ip6e_len + 1) * 8;
+    }
+    if (len < offset) return false;
+
+    return quotedPorts(quoted + offset, len - offset, next, error);
+}
+
+// function to parse an ICMP destination unreachable message down to the quoted probe
+bool parseIcmpError(int family, const char *icmp, size_t len, IcmpError &error) {
+    memset(&error, 0, sizeof(error));
+    error.family = family;
+
+    if (family == AF_INET) return parseIcmpv4(icmp, len, error);
+    if (family == AF_INET6) return parseIcmpv6(icmp, len, error);
+    return false;
+}
+
+// function to check, if the error is a port unreachable
+bool isPortUnreachable(const IcmpError &error) {
+    if (error.family == AF_INET) return error.type == ICMP_DEST_UNREACH && error.code == ICMP_PORT_UNREACH;
+    return error.type == ICMP6_DST_UNREACH && error.code == ICMP6_DST_UNREACH_NOPORT;
+}
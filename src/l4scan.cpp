@@ -0,0 +1,438 @@
+/**
+ * @file l4scan.cpp
+ * @brief File for the library interface of the scanner (scan jobs, their errors and results, and a runner of concurrent jobs)
+ * @author Martin Mendl <x247581>
+ * @date 2026-01-06
+ */
+
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include "l4scan.hpp"
+#include "topports.hpp"
+
+// Method to get the addresses of a target, the domains from the cache
+ScanError ScanCache::resolve(const std::string &target, std::vector<NetworkAdress> &addresses) {
+    TargetType type = determinTargetType(target);
+    if (type == TargetType::IP_v4 || type == TargetType::IP_v6) {
+        NetworkAdress address;
+        if (!parseAddress(target, address)) return {"invalid target IP address: " + target};
+        addresses.push_back(address);
+        return {};
+    }
+    if (type != TargetType::DOMAIN_NAME) return {"invalid target: " + target};
+
+    Clock::time_point now = Clock::now();
+    auto cached = domains.find(target);
+    if (cached == domains.end() || now >= cached->second.expires) {
+        // a miss blocks the caller for the lookup, the same names come again and again
+        struct addrinfo hints, *res;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        int status = getaddrinfo(target.c_str(), nullptr, &hints, &res);
+        if (status != 0) return {"failed to resolve " + target + ": " + gai_strerror(status)};
+
+        Resolved resolved;
+        for (struct addrinfo *p = res; p != nullptr; p = p->ai_next) {
+            if (p->ai_family == AF_INET) resolved.addresses.push_back(makeAddress(AF_INET, &((struct sockaddr_in*)p->ai_addr)->sin_addr, 0));
+            else if (p->ai_family == AF_INET6) resolved.addresses.push_back(makeAddress(AF_INET6, &((struct sockaddr_in6*)p->ai_addr)->sin6_addr, 0));
+        }
+        freeaddrinfo(res);
+        if (resolved.addresses.empty()) return {"no address found for " + target};
+        resolved.expires = now + std::chrono::seconds(SCAN_RESOLVE_TTL_S);
+        cached = domains.insert_or_assign(target, resolved).first;
+    }
+    addresses.insert(addresses.end(), cached->second.addresses.begin(), cached->second.addresses.end());
+    return {};
+}
+
+// Method to get the interface with its address of the IP version, the list from the cache
+ScanError ScanCache::findInterface(const std::string &name, bool ipv4, NetworkInterface &interface) {
+    try {
+        // addresses come and go, an unknown name may be a new interface
+        bool known = std::any_of(interfaces.begin(), interfaces.end(), [&name](const NetworkInterface &i) { return i.name == name; });
+        if (!known || Clock::now() - interfacesLoaded > std::chrono::seconds(SCAN_INTERFACES_TTL_S)) {
+            interfaces = getNetworkInterfaces();
+            interfacesLoaded = Clock::now();
+        }
+        interface = validateInterface(interfaces, name, ipv4);
+    } catch (const std::exception &e) {
+        return {std::string(e.what()) + ": " + name};
+    }
+    return {};
+}
+
+// Destructor for ScanJob class
+ScanJob::~ScanJob() {
+    if (runner != nullptr) runner->remove(*this);
+}
+
+// Method to set the interface, the probes leave through
+ScanJob& ScanJob::interface(const std::string &name) {
+    interfaceName = name;
+    return *this;
+}
+
+// Method to add a target
+ScanJob& ScanJob::target(const std::string &target) {
+    names.push_back(target);
+    return *this;
+}
+
+// Method to add a resolved target
+ScanJob& ScanJob::target(const NetworkAdress &target) {
+    addresses.push_back(target);
+    return *this;
+}
+
+// Method to add TCP ports
+ScanJob& ScanJob::tcpPorts(const std::string &ranges) {
+    try {
+        return tcpPorts(parsePorts(ranges));
+    } catch (const std::exception &) {
+        if (!error) error.message = "invalid TCP ports: " + ranges;
+    }
+    return *this;
+}
+
+// Method to add TCP ports
+ScanJob& ScanJob::tcpPorts(const std::vector<int> &ports) {
+    auto invalid = std::find_if(ports.begin(), ports.end(), [](int port) { return port <= 0 || port > MAX_PORT_NUMBER; });
+    if (invalid != ports.end()) {
+        if (!error) error.message = "invalid TCP port: " + std::to_string(*invalid);
+        return *this;
+    }
+    tcp.insert(tcp.end(), ports.begin(), ports.end());
+    return *this;
+}
+
+// Method to add UDP ports
+ScanJob& ScanJob::udpPorts(const std::string &ranges) {
+    try {
+        return udpPorts(parsePorts(ranges));
+    } catch (const std::exception &) {
+        if (!error) error.message = "invalid UDP ports: " + ranges;
+    }
+    return *this;
+}
+
+// Method to add UDP ports
+ScanJob& ScanJob::udpPorts(const std::vector<int> &ports) {
+    auto invalid = std::find_if(ports.begin(), ports.end(), [](int port) { return port <= 0 || port > MAX_PORT_NUMBER; });
+    if (invalid != ports.end()) {
+        if (!error) error.message = "invalid UDP port: " + std::to_string(*invalid);
+        return *this;
+    }
+    udp.insert(udp.end(), ports.begin(), ports.end());
+    return *this;
+}
+
+// Method to add the most common TCP ports
+ScanJob& ScanJob::topPorts(int count) {
+    if (count < 1 || size_t(count) > topPortCount(Protocol::TCP)) {
+        if (!error) error.message = "top ports must be between 1 and " + std::to_string(topPortCount(Protocol::TCP));
+        return *this;
+    }
+    return tcpPorts(::topPorts(Protocol::TCP, count));
+}
+
+// Method to add the most common UDP ports
+ScanJob& ScanJob::topUdpPorts(int count) {
+    if (count < 1 || size_t(count) > topPortCount(Protocol::UDP)) {
+        if (!error) error.message = "top UDP ports must be between 1 and " + std::to_string(topPortCount(Protocol::UDP));
+        return *this;
+    }
+    return udpPorts(::topPorts(Protocol::UDP, count));
+}
+
+// Method to set the timeout of a probe
+ScanJob& ScanJob::timeout(int ms) {
+    if (ms <= 0) {
+        if (!error) error.message = "timeout must be greater than 0";
+        return *this;
+    }
+    probeTimeout = ms;
+    return *this;
+}
+
+// Method to set the transport of the probes
+ScanJob& ScanJob::backend(Backend backend) {
+    transport = backend;
+    return *this;
+}
+
+// Method to cap the probes in flight to one host
+ScanJob& ScanJob::hostProbes(int probes) {
+    if (probes < 0) {
+        if (!error) error.message = "probes per host must not be negative";
+        return *this;
+    }
+    maxHostProbes = probes;
+    return *this;
+}
+
+// Method to read the banners of the open TCP ports
+ScanJob& ScanJob::banner(int bytes) {
+    if (bytes < 0 || bytes > BANNER_MAX_BYTES) {
+        if (!error) error.message = "banner size must be between 0 and " + std::to_string(BANNER_MAX_BYTES);
+        return *this;
+    }
+    bannerBytes = bytes;
+    return *this;
+}
+
+// Method to add prefixes, that are never probed
+ScanJob& ScanJob::exclude(const std::string &prefixes) {
+    for (size_t start = 0, end; start <= prefixes.size(); start = end + 1) {
+        end = std::min(prefixes.find(',', start), prefixes.size());
+        if (end == start) continue;
+        if (!exclusions.add(prefixes.substr(start, end - start)) && !error) error.message = "invalid exclusion: " + prefixes.substr(start, end - start);
+    }
+    return *this;
+}
+
+// Method to use a built exclusion list
+ScanJob& ScanJob::exclude(const ExcludeList &list) {
+    sharedExclusions = &list;
+    return *this;
+}
+
+// Method to set the callback of the results
+ScanJob& ScanJob::onResult(ResultCallback onResult) {
+    callback = onResult;
+    return *this;
+}
+
+// Method to end the job with an error
+void ScanJob::fail(const std::string &message) {
+    if (!error) error.message = message;
+    // the schedulers give their ports and their share of the window back
+    scan.reset();
+}
+
+// Method to check the settings, resolve the targets and build the scan
+ScanError ScanJob::prepare(ScanCache *cache) {
+    if (started) return {"the job was started already"};
+    started = true;
+    if (error) return error;
+    if (interfaceName.empty()) return error = {"no interface"};
+    if (names.empty() && addresses.empty()) return error = {"no target"};
+    if (tcp.empty() && udp.empty()) return error = {"no ports"};
+
+    ScanCache ownCache;
+    if (cache == nullptr) cache = &ownCache;
+
+    // the targets of all the names, each address once, the excluded ones dropped
+    std::vector<NetworkAdress> resolved = addresses;
+    for (const std::string &name : names) {
+        if ((error = cache->resolve(name, resolved))) return error;
+    }
+    exclusions.build();
+    for (const NetworkAdress &address : resolved) {
+        if (exclusions.contains(address) || (sharedExclusions != nullptr && sharedExclusions->contains(address))) {
+            excluded.push_back(address);
+            continue;
+        }
+        if (std::none_of(targets.begin(), targets.end(), [&address](const NetworkAdress &a) { return sameAddress(a, address); })) targets.push_back(address);
+    }
+    if (targets.empty()) return error = {"all targets are excluded"};
+
+    // the loopback is only reached over lo, the interface is picked for each IP version
+    NetworkInterface sender4, sender6;
+    for (IpVersion version : {IpVersion::IPV4, IpVersion::IPV6}) {
+        size_t count = 0, loopback = 0;
+        for (const NetworkAdress &address : targets) {
+            if (address.ipVer != version) continue;
+            count++;
+            loopback += isLoopback(address);
+        }
+        bool ipv4 = version == IpVersion::IPV4;
+        if (loopback > 0 && loopback < count) return error = {std::string("loopback and other ") + (ipv4 ? "IPv4" : "IPv6") + " targets can not be scanned together"};
+        std::string name = (count > 0 && loopback == count) ? "lo" : interfaceName;
+        if ((error = cache->findInterface(name, ipv4, ipv4 ? sender4 : sender6))) return error;
+    }
+
+    try {
+        scan = std::make_unique<PortScan>(sender4, sender6, targets, tcp, udp, probeTimeout, transport, maxHostProbes, bannerBytes, [this](const PortResult &result) {
+            if (callback) callback(result);
+            else queue.push_back(result);
+        });
+    } catch (const std::exception &e) {
+        // sockets, privileges or a busy XDP queue
+        fail(e.what());
+    }
+    return error;
+}
+
+// Method to resolve the targets, open the sockets and send the first probes
+ScanError ScanJob::start(ScanCache *cache, ScanBudget *shared) {
+    if (prepare(cache)) return error;
+    try {
+        scan->start(shared);
+    } catch (const std::exception &e) {
+        fail(e.what());
+    }
+    return error;
+}
+
+// Method to scan to the end
+ScanError ScanJob::run() {
+    if (runner != nullptr) return {"the job runs in a runner"};
+
+    // a job of its own waits in its transports, like the command line
+    if (!started) {
+        if (prepare(nullptr)) return error;
+        try {
+            scan->run();
+        } catch (const std::exception &e) {
+            fail(e.what());
+        }
+        return error;
+    }
+    while (!finished()) step();
+    return error;
+}
+
+// Method to get the next result
+bool ScanJob::next(PortResult &result) {
+    if (!started && runner == nullptr) start();
+    while (queue.empty() && !finished()) {
+        if (runner != nullptr) return false;
+        step();
+    }
+    if (queue.empty()) return false;
+    result = queue.front();
+    queue.pop_front();
+    return true;
+}
+
+// Method to drive a started job for one wake up of its own poll
+void ScanJob::step() {
+    sendDue();
+    int waitMs = -1;
+    fds.clear();
+    addPollFds(fds, waitMs);
+    if (poll(fds.data(), fds.size(), waitMs) < 0 && errno != EINTR) {
+        fail(std::string("poll failed: ") + strerror(errno));
+        return;
+    }
+    process();
+}
+
+// Method to send the probes, that are due
+void ScanJob::sendDue() {
+    if (!scan) return;
+    try {
+        scan->sendDue();
+    } catch (const std::exception &e) {
+        fail(e.what());
+    }
+}
+
+// Method to add the sockets of the job to the poll set of a loop
+void ScanJob::addPollFds(std::vector<struct pollfd> &pollFds, int &waitMs) {
+    if (scan && !scan->finished()) scan->addPollFds(pollFds, waitMs);
+}
+
+// Method to handle the answers and the expired probes after a wake up
+void ScanJob::process() {
+    if (!scan || scan->finished()) return;
+    try {
+        scan->process();
+    } catch (const std::exception &e) {
+        fail(e.what());
+    }
+}
+
+// Method to check, if the job is over
+bool ScanJob::finished() const {
+    return bool(error) || (started && (!scan || scan->finished()));
+}
+
+// Method to get the number of answers, the kernel dropped during the scan
+uint64_t ScanJob::getDrops() const {
+    return scan ? scan->getDrops() : 0;
+}
+
+// Method to get the global congestion window at the end of the scan
+int ScanJob::getWindow() const {
+    return scan ? scan->getWindow() : 0;
+}
+
+// Constructor for ScanRunner class
+ScanRunner::ScanRunner(int initialWindow, int maxWindow) {
+    budget.window = CongestionWindow(initialWindow, maxWindow);
+}
+
+// Destructor for ScanRunner class
+ScanRunner::~ScanRunner() {
+    // the schedulers of the jobs give their probes back to the window, before it is gone
+    for (ScanJob *job : jobs) {
+        job->runner = nullptr;
+        job->fail("the runner was destroyed");
+    }
+}
+
+// Method to start a job in the runner
+ScanError ScanRunner::add(ScanJob &job) {
+    if (job.runner != nullptr || job.started) return {"the job was started already"};
+    // the probes of all the jobs count against one window
+    if (job.start(&cache, &budget)) return job.error;
+    job.runner = this;
+    jobs.push_back(&job);
+    return {};
+}
+
+// Method to take a job out of the runner
+void ScanRunner::remove(ScanJob &job) {
+    jobs.erase(std::remove(jobs.begin(), jobs.end(), &job), jobs.end());
+    job.runner = nullptr;
+}
+
+// Method to run the jobs to the end
+void ScanRunner::run() {
+    std::vector<struct pollfd> fds;
+    fds.reserve(8);
+    while (!finished()) {
+        sendDue();
+        int timeoutMs = -1;
+        fds.clear();
+        addPollFds(fds, timeoutMs);
+        if (poll(fds.data(), fds.size(), timeoutMs) < 0 && errno != EINTR) {
+            std::string message = std::string("poll failed: ") + strerror(errno);
+            for (ScanJob *job : jobs) job->fail(message);
+        }
+        process();
+    }
+}
+
+// Method to send the probes of the jobs, that are due
+void ScanRunner::sendDue() {
+    // the job, that sends first, moves on every pass, so no job starves the others at the shared window
+    if (jobs.size() > 1) std::rotate(jobs.begin(), jobs.begin() + 1, jobs.end());
+    for (ScanJob *job : jobs) job->sendDue();
+}
+
+// Method to add the sockets of the jobs to the poll set of a loop
+void ScanRunner::addPollFds(std::vector<struct pollfd> &fds, int &timeoutMs) {
+    for (ScanJob *job : jobs) job->addPollFds(fds, timeoutMs);
+}
+
+// Method to handle the answers of the jobs after a wake up
+void ScanRunner::process() {
+    for (ScanJob *job : jobs) job->process();
+    // a finished job leaves, its owner reads the error and the drops
+    for (auto job = jobs.begin(); job != jobs.end();) {
+        if ((*job)->finished()) {
+            (*job)->runner = nullptr;
+            job = jobs.erase(job);
+        } else {
+            ++job;
+        }
+    }
+}
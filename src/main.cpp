@@ -7,7 +7,9 @@
 
 #include <iostream>
 #include "arguments.hpp"
-#include "scanning.hpp"
+#include "l4scan.hpp"
+#include "daemon.hpp"
+#include "watch.hpp"
 #include "utils.hpp"
 
 
@@ -21,7 +23,7 @@ int main(int argc, char *argv[]) {
     }
 
     // Get available network interfaces
-    std::vector<NetworkAdress> interfaces = getNetworkInterfaces();
+    std::vector<NetworkInterface> interfaces = getNetworkInterfaces();
 
     // Print out interfaces, if no target or interface is specified
     if (settings.getMode() == Mode::PRINT_INTERFACES) {
@@ -29,28 +31,50 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
-    NetworkAdress *recv;
-    NetworkAdress sender;
-
-    while (1) {
+    // the interfaces, the resolved domains and the global window are kept for all the jobs
+    if (settings.getMode() == Mode::DAEMON) {
+        DaemonDefaults defaults = {settings.getInterface(), settings.getBackend(), settings.getTimeout(), settings.getHostProbes(), settings.getBannerBytes()};
+        ScanDaemon daemon(settings.getDaemonPath(), defaults, settings.getExclusions());
+        std::cout << "Listening on " << settings.getDaemonPath() << std::endl;
+        daemon.run();
+        return 0;
+    }
 
-        // get the sender
-        recv = settings.getTargetIp4();
-        sender = validateInterface(interfaces, settings.getInterface(), true);
-        if (recv == nullptr) {
-            recv = settings.getTargetIp6();
-            if (recv == nullptr) break;
-            sender = validateInterface(interfaces, settings.getInterface(), false);
-        }
-        // tcp
-        for (auto port : settings.getTCPports()) {
-            scanPortTCP(sender, *recv, port, settings.getTimeout());
+    // the state of every port is kept between the rounds, only its changes are printed
+    if (settings.getMode() == Mode::WATCH) {
+        WatchSettings watch = {settings.getInterface(), settings.getBackend(), settings.getTimeout(), settings.getHostProbes(), settings.getBannerBytes(), settings.isRttShown(), settings.getWatchInterval()};
+        std::vector<NetworkAdress> targets;
+        NetworkAdress *target;
+        while ((target = settings.getTargetIp4()) != nullptr) targets.push_back(*target);
+        while ((target = settings.getTargetIp6()) != nullptr) targets.push_back(*target);
+        PortWatcher watcher(watch, targets, settings.getTCPports(), settings.getUDPports());
+        try {
+            watcher.run();
+        } catch (const std::exception &e) {
+            std::cerr << "Watch failed: " << e.what() << std::endl;
+            return 1;
         }
+        return 0;
+    }
 
-        // udp
-        for (auto port : settings.getUDPports()) {
-            scanPortUDP(sender, *recv, port, settings.getTimeout());
-        }
+    // the command line is a client of the library, the targets and the ports are checked already
+    ScanJob job;
+    job.interface(settings.getInterface()).tcpPorts(settings.getTCPports()).udpPorts(settings.getUDPports()).timeout(settings.getTimeout()).backend(settings.getBackend()).hostProbes(settings.getHostProbes()).banner(settings.getBannerBytes());
+    bool showRtt = settings.isRttShown();
+    job.onResult([showRtt](const PortResult &result) {
+        std::cout << formatResult(result, showRtt) << std::endl;
+    });
+
+    // both protocols and both IP versions are scheduled over all the targets at once
+    NetworkAdress *recv;
+    while ((recv = settings.getTargetIp4()) != nullptr) job.target(*recv);
+    while ((recv = settings.getTargetIp6()) != nullptr) job.target(*recv);
+
+    ScanError error = job.run();
+    if (error) {
+        std::cerr << "Scan failed: " << error.message << std::endl;
+        return 1;
     }
+    // the ports were probed again, but the user should know, that the receive path was overloaded
+    if (job.getDrops() > 0) std::cerr << "Warning: the kernel dropped " << job.getDrops() << " received packets, the probe window was reduced to " << job.getWindow() << std::endl;
 }
-  
\ No newline at end of file
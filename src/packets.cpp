@@ -7,27 +7,42 @@
 
 #include <string.h>
 #include "packets.hpp"
+#include "payloads.hpp"
 #include <netinet/ip.h>
 #include <netinet/ip6.h>
 #include <netinet/tcp.h>
 #include <netinet/udp.h>
+#include <net/ethernet.h>
 
-// Constructor for base Packet class
-Packet::Packet() {
-    memset(&psh, 0, sizeof(psh));
-    memset(&psh6, 0, sizeof(psh6));
-    memset(datagram, 0, DATAGRAM_LEN);
+// Function to compute the TCP or UDP checksum over the pseudo header of the family and the segment
+template <typename Family>
+static uint16_t segmentChecksum(const typename Family::SockAddr &sender, const typename Family::SockAddr &receiver, int protocol, const char *segment, size_t size) {
+    typename Family::PseudoHeader psh;
+    Family::fillPseudoHeader(psh, sender, receiver, protocol, size);
+
+    // summed in place, the pseudo header is not copied in front of the segment
+    return checkSum((const char*)&psh, sizeof(psh), segment, size);
+}
+
+// Constructor for base Packet class, building the packet in a buffer owned by the caller
+Packet::Packet(char *buffer, size_t size) {
+    datagram = buffer;
+    bufferSize = size;
 }
 
 // Destructor for Packet class
-Packet::~Packet() {
-    delete[] datagram;
+Packet::~Packet() {}
+
+// Constructor for SynPacket class, building the packet in a buffer owned by the caller
+SynPacket::SynPacket(char *buffer, size_t size) : Packet(buffer, size) {
+    setupHeader();
 }
 
-// Constructor for SynPacket class
-SynPacket::SynPacket() : Packet() {
+// Method to fill in the fixed fields of the SYN header
+void SynPacket::setupHeader() {
     // Point to TCP header in datagram
     this->tcph = (struct tcphdr*)(datagram);
+    memset(tcph, 0, sizeof(struct tcphdr));  // only the header, not the whole buffer
 
     // basic TCP header setup
     tcph->th_seq = htonl((uint32_t)rand());
@@ -37,120 +52,104 @@ SynPacket::SynPacket() : Packet() {
     tcph->th_win = htons(5840);
     tcph->th_sum = 0;
     tcph->th_urp = 0;
+    datagramSize = sizeof(struct tcphdr);
 }
 
-// Method to create the SYN packet for IPv4
-void SynPacket::constructSynPacketIpv4(const SocketIpv4 &socket) {
+// Method to create the SYN packet from raw addresses
+template <typename Family>
+void SynPacket::constructSynPacket(const typename Family::SockAddr &sender, const typename Family::SockAddr &receiver) {
 
     // TCP header setup
-    tcph->th_sport = socket.getSender().sin_port;
-    tcph->th_dport = socket.getReceiver().sin_port;
-
-    // Prepare pseudo-header
-    memset(&psh, 0, sizeof(struct pseudoHeaderIpv4));
-    psh.sourceAdress = socket.getSender().sin_addr.s_addr;
-    psh.destAdress = socket.getReceiver().sin_addr.s_addr;
-    psh.tmp = 0;
-    psh.protocol = IPPROTO_TCP;
-    psh.tcp_length = htons(sizeof(struct tcphdr));
+    tcph->th_sport = Family::port(sender);
+    tcph->th_dport = Family::port(receiver);
+    tcph->th_sum = 0;
 
     // Calculate checksum
-    int psize = sizeof(struct pseudoHeaderIpv4) + sizeof(struct tcphdr);
-    std::vector<char> psdgram(psize);
-    memcpy(psdgram.data(), &psh, sizeof(struct pseudoHeaderIpv4));
-    memcpy(psdgram.data() + sizeof(struct pseudoHeaderIpv4), tcph, sizeof(struct tcphdr));
-
-    tcph->th_sum = checkSum(psdgram.data(), psize);
-
+    tcph->th_sum = segmentChecksum<Family>(sender, receiver, IPPROTO_TCP, (const char*)tcph, sizeof(struct tcphdr));
 }
 
-// Method to create the SYN packet for IPv6
-void SynPacket::constructSynPacketIpv6(const SocketIpv6 &socket) {
-
-    // Configure TCP header fields
-    tcph->th_sport = socket.getSender().sin6_port; // poroblem here
-    tcph->th_dport = socket.getReceiver().sin6_port; // problem here
-
-    // Prepare IPv6 pseudo header for checksum calculation
-    memset(&psh6, 0, sizeof(psh6));
-    psh6.sourceAddress = socket.getSender().sin6_addr;
-    psh6.destAddress = socket.getReceiver().sin6_addr;
-    psh6.tcp_length = htonl(sizeof(struct tcphdr));
-    psh6.nextHeader = IPPROTO_TCP;
-
-    // Create pseudo packet for checksum calculation
-    int psize = sizeof(struct pseudoHeaderIpv6) + sizeof(struct tcphdr);
-    std::vector<char> psdgram(psize);
-    memcpy(psdgram.data(), &psh6, sizeof(struct pseudoHeaderIpv6));
-    memcpy(psdgram.data() + sizeof(struct pseudoHeaderIpv6), tcph, sizeof(struct tcphdr));
+template void SynPacket::constructSynPacket<Ipv4>(const Ipv4::SockAddr &sender, const Ipv4::SockAddr &receiver);
+template void SynPacket::constructSynPacket<Ipv6>(const Ipv6::SockAddr &sender, const Ipv6::SockAddr &receiver);
 
-    // Calculate checksum
-    tcph->th_sum = checkSum(psdgram.data(), psize);
+// Constructor for UDPpacket class, building the packet in a buffer owned by the caller
+UDPpacket::UDPpacket(char *buffer, size_t size) : Packet(buffer, size) {
+    setupHeader();
 }
 
-
-// Constructor for UDPpacket class
-UDPpacket::UDPpacket() : Packet() {
-
-    memset(&psh, 0, sizeof(psh));
-    memset(&psh6, 0, sizeof(psh6));
-    memset(datagram, 0, DATAGRAM_LEN);
-
+// Method to fill in the fixed fields of the UDP header
+void UDPpacket::setupHeader() {
     // Point to the correct offset for UDP header
     this->udph = (struct udphdr*)(datagram);
+    memset(udph, 0, sizeof(struct udphdr));  // only the header, the payload is copied behind it
 
     udph->uh_ulen = htons(sizeof(struct udphdr));
     udph->uh_sum = 0;
+    datagramSize = sizeof(struct udphdr);
 }
 
-// Method to create the UDP packet for IPv4
-void UDPpacket::constructUDPpacketIpv4(const SocketIpv4 &socket) {
+// Method to copy the payload for the destination port behind the header
+size_t UDPpacket::attachPayload(uint16_t port) {
+    Payload payload = PayloadDatabase::instance().get(ntohs(port));
+    if (sizeof(struct udphdr) + payload.size > bufferSize) payload.size = 0;  // does not fit the buffer
+    if (payload.size > 0) memcpy(datagram + sizeof(struct udphdr), payload.data, payload.size);
 
-    // Configure UDP header fields
-    udph->uh_sport = socket.getSender().sin_port;
-    udph->uh_dport = socket.getReceiver().sin_port;
+    datagramSize = sizeof(struct udphdr) + payload.size;
+    udph->uh_ulen = htons(datagramSize);
+    return datagramSize;
+}
 
-    // Prepare pseudo-header for checksum calculation
-    memset(&psh, 0, sizeof(struct pseudoHeaderIpv4));
-    psh.sourceAdress = socket.getSender().sin_addr.s_addr;
-    psh.destAdress = socket.getReceiver().sin_addr.s_addr;
-    psh.tmp = 0;
-    psh.protocol = IPPROTO_UDP;
-    psh.tcp_length = htons(sizeof(struct udphdr));
+// Method to create the UDP packet from raw addresses
+template <typename Family>
+void UDPpacket::constructUDPpacket(const typename Family::SockAddr &sender, const typename Family::SockAddr &receiver) {
 
-    // Calculate checksum
-    int psize = sizeof(struct pseudoHeaderIpv4) + sizeof(struct udphdr);
-    std::vector<char> psdgram(psize);
-    memcpy(psdgram.data(), &psh, sizeof(struct pseudoHeaderIpv4));
-    memcpy(psdgram.data() + sizeof(struct pseudoHeaderIpv4), udph, sizeof(struct udphdr));
-
-    udph->uh_sum = checkSum(psdgram.data(), psize);
+    // Configure UDP header fields
+    udph->uh_sport = Family::port(sender);
+    udph->uh_dport = Family::port(receiver);
+    udph->uh_sum = 0;
+    size_t udpSize = attachPayload(Family::port(receiver));
 
+    // Calculate checksum over the header and the payload
+    udph->uh_sum = segmentChecksum<Family>(sender, receiver, IPPROTO_UDP, (const char*)udph, udpSize);
+    if (udph->uh_sum == 0) udph->uh_sum = 0xffff;  // zero means no checksum for UDP
 }
 
-// Method to create the UDP packet for IPv6
-void UDPpacket::constructUDPpacketIpv6(const SocketIpv6 &socket) {
+template void UDPpacket::constructUDPpacket<Ipv4>(const Ipv4::SockAddr &sender, const Ipv4::SockAddr &receiver);
+template void UDPpacket::constructUDPpacket<Ipv6>(const Ipv6::SockAddr &sender, const Ipv6::SockAddr &receiver);
 
-    // Point to the correct offset for UDP header
-    this->udph = (struct udphdr*)(datagram);
+// Function to write the Ethernet header
+size_t buildEthernetHeader(char *buffer, const unsigned char *dst, const unsigned char *src, uint16_t etherType) {
+    struct ether_header *eth = (struct ether_header*)buffer;
+    memcpy(eth->ether_dhost, dst, ETH_ALEN);
+    memcpy(eth->ether_shost, src, ETH_ALEN);
+    eth->ether_type = htons(etherType);
+    return sizeof(struct ether_header);
+}
 
-    // Configure UDP header fields
-    udph->uh_sport = socket.getSender().sin6_port;
-    udph->uh_dport = socket.getReceiver().sin6_port;
-
-    // Prepare pseudo-header for checksum calculation
-    memset(&psh6, 0, sizeof(psh6));
-    psh6.sourceAddress = socket.getSender().sin6_addr;
-    psh6.destAddress = socket.getReceiver().sin6_addr;
-    psh6.tcp_length = htons(sizeof(struct udphdr));
-    psh6.nextHeader = IPPROTO_UDP;
-
-    // Create pseudo packet for checksum calculation
-    int psize = sizeof(struct pseudoHeaderIpv6) + sizeof(struct udphdr);
-    std::vector<char> psdgram(psize);
-    memcpy(psdgram.data(), &psh6, sizeof(struct pseudoHeaderIpv6));
-    memcpy(psdgram.data() + sizeof(struct pseudoHeaderIpv6), udph, sizeof(struct udphdr));
+// Method to write the IPv4 header, for transports without the kernel IP layer
+size_t Ipv4::buildIpHeader(char *buffer, const SockAddr &sender, const SockAddr &receiver, int protocol, size_t payloadSize) {
+    struct iphdr *ip = (struct iphdr*)buffer;
+    memset(ip, 0, sizeof(struct iphdr));
+    ip->version = 4;
+    ip->ihl = 5;
+    ip->tot_len = htons(sizeof(struct iphdr) + payloadSize);
+    ip->id = htons((uint16_t)rand());
+    ip->ttl = 64;
+    ip->protocol = protocol;
+    ip->saddr = sender.sin_addr.s_addr;
+    ip->daddr = receiver.sin_addr.s_addr;
+    ip->check = checkSum(buffer, sizeof(struct iphdr));
+    return sizeof(struct iphdr);
+}
 
-    // Calculate checksum
-    udph->uh_sum = checkSum(psdgram.data(), psize);
-}
\ No newline at end of file
+// Method to write the IPv6 header, for transports without the kernel IP layer
+size_t Ipv6::buildIpHeader(char *buffer, const SockAddr &sender, const SockAddr &receiver, int protocol, size_t payloadSize) {
+    struct ip6_hdr *ip6 = (struct ip6_hdr*)buffer;
+    memset(ip6, 0, sizeof(struct ip6_hdr));
+    ip6->ip6_flow = htonl(6 << 28);
+    ip6->ip6_plen = htons(payloadSize);
+    ip6->ip6_nxt = protocol;
+    ip6->ip6_hlim = 64;
+    ip6->ip6_src = sender.sin6_addr;
+    ip6->ip6_dst = receiver.sin6_addr;
+    return sizeof(struct ip6_hdr);
+}
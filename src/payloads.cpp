@@ -0,0 +1,88 @@
+/**
+ * @file payloads.cpp
+ * @brief File for the protocol specific UDP probe payloads
+ * @author Martin Mendl <x247581>
+ * @date 2025-24-03
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "payloads.hpp"
+
+/**
+ * @struct BuiltinPayload
+ * @brief Payload compiled into the binary
+ */
+struct BuiltinPayload {
+    int port;
+    const char *data;
+    size_t size;
+};
+
+#define PAYLOAD(port, bytes) {port, bytes, sizeof(bytes) - 1}
+
+// DNS query for the NS records of the root zone
+#define DNS_QUERY "\x12\x34\x01\x00\x00\x01\x00\x00\x00\x00\x00\x00\x00\x00\x02\x00\x01"
+
+static const BuiltinPayload BUILTIN_PAYLOADS[] = {
+    // echo
+    PAYLOAD(7, "\x0d\x0a\x0d\x0a"),
+    // DNS
+    PAYLOAD(53, DNS_QUERY),
+    // TFTP read request
+    PAYLOAD(69, "\x00\x01" "r7tftp.txt" "\x00" "octet" "\x00"),
+    // RPC portmapper NULL call
+    PAYLOAD(111, "\x72\xfe\x1d\x13\x00\x00\x00\x00\x00\x00\x00\x02\x00\x01\x86\xa0"
+                 "\x00\x00\x00\x02\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+                 "\x00\x00\x00\x00\x00\x00\x00\x00"),
+    // NTP version 4 client request
+    PAYLOAD(123, "\xe3\x00\x04\xfa\x00\x01\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00"
+                 "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+                 "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"),
+    // NetBIOS name service node status request
+    PAYLOAD(137, "\x80\xf0\x00\x10\x00\x01\x00\x00\x00\x00\x00\x00\x20" "CKAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA"
+                 "\x00\x00\x21\x00\x01"),
+    // SNMPv1 get-request for sysDescr with the community public
+    PAYLOAD(161, "\x30\x29\x02\x01\x00\x04\x06" "public" "\xa0\x1c\x02\x04\x12\x34\x56\x78\x02\x01\x00"
+                 "\x02\x01\x00\x30\x0e\x30\x0c\x06\x08\x2b\x06\x01\x02\x01\x01\x01\x00\x05\x00"),
+    // SSDP discovery
+    PAYLOAD(1900, "M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: \"ssdp:discover\"\r\nMX: 1\r\nST: ssdp:all\r\n\r\n"),
+    // STUN binding request
+    PAYLOAD(3478, "\x00\x01\x00\x00\x21\x12\xa4\x42\x6e\x6d\x61\x70\x2d\x73\x74\x75\x6e\x2d\x69\x64"),
+    // mDNS service discovery
+    PAYLOAD(5353, "\x00\x00\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00\x09" "_services" "\x07" "_dns-sd" "\x04" "_udp"
+                  "\x05" "local" "\x00\x00\x0c\x00\x01"),
+    // memcached stats over the UDP frame header
+    PAYLOAD(11211, "\x00\x01\x00\x00\x00\x01\x00\x00" "stats\r\n"),
+};
+
+// Method to get the database, built on the first call
+const PayloadDatabase& PayloadDatabase::instance() {
+    static const PayloadDatabase database;
+    return database;
+}
+
+// Constructor for PayloadDatabase class, copies the built in payloads into the arena
+PayloadDatabase::PayloadDatabase() {
+    size_t total = 0;
+    for (const BuiltinPayload &payload : BUILTIN_PAYLOADS) total += payload.size;
+    arena.reserve(total);
+
+    for (const BuiltinPayload &payload : BUILTIN_PAYLOADS) {
+        entries.push_back({uint16_t(payload.port), uint32_t(arena.size()), uint32_t(payload.size)});
+        arena.insert(arena.end(), payload.data, payload.data + payload.size);
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.port < b.port;
+    });
+}
+
+// Method to get the payload for the port
+Payload PayloadDatabase::get(int port) const {
+    auto entry = std::lower_bound(entries.begin(), entries.end(), port, [](const Entry &e, int p) {
+        return e.port < p;
+    });
+    if (entry == entries.end() || entry->port != port) return {nullptr, 0};
+    return {arena.data() + entry->offset, entry->size};
+}
@@ -0,0 +1,53 @@
+/**
+ * @file portalloc.cpp
+ * @brief File for the source port allocator (unique ports for the probes in flight)
+ * @author Martin Mendl <x247581>
+ * @date 2025-11-04
+ */
+
+#include <random>
+#include <stdexcept>
+#include "portalloc.hpp"
+
+// Constructor for PortAllocator class
+PortAllocator::PortAllocator(uint16_t base, uint32_t count) : words((count + 63) / 64) {
+    if (count == 0 || (count & (count - 1)) != 0 || uint32_t(base) + count > 65536) {
+        throw std::runtime_error("Invalid source port range");
+    }
+    this->base = base;
+    this->count = count;
+
+    // any odd stride is coprime to the power of 2, so the walk visits every port once per cycle
+    std::random_device random;
+    offset = random() & (count - 1);
+    stride = (random() & (count - 1)) | 1;
+}
+
+// Method to take a free port
+uint16_t PortAllocator::acquire() {
+    for (uint32_t tries = 0; tries < count; tries++) {
+        uint32_t index = (offset + cursor.fetch_add(1, std::memory_order_relaxed) * stride) & (count - 1);
+        uint64_t bit = uint64_t(1) << (index % 64);
+
+        // the port is ours, if the bit was clear before
+        if ((words[index / 64].fetch_or(bit, std::memory_order_acq_rel) & bit) == 0) {
+            used.fetch_add(1, std::memory_order_relaxed);
+            return base + index;
+        }
+    }
+    return 0;  // all in use
+}
+
+// Method to give the port back
+void PortAllocator::release(uint16_t port) {
+    if (!contains(port)) return;
+    uint32_t index = port - base;
+    uint64_t bit = uint64_t(1) << (index % 64);
+    if (words[index / 64].fetch_and(~bit, std::memory_order_acq_rel) & bit) used.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// function to get the allocator shared by all the scans of the process
+PortAllocator& sourcePorts() {
+    static PortAllocator allocator;
+    return allocator;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file portscan.cpp
+ * @brief File for a whole port scan (the schedulers of both IP versions, the connect backend and the banner stage)
+ * @author Martin Mendl <x247581>
+ * @date 2025-12-30
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cerrno>
+#include <algorithm>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include "portscan.hpp"
+
+// function to shorten the poll timeout to the next event, -1 is no timeout
+static inline void earlier(int &timeoutMs, int eventMs) {
+    if (eventMs >= 0 && (timeoutMs < 0 || eventMs < timeoutMs)) timeoutMs = eventMs;
+}
+
+// Constructor for PortScan class
+PortScan::PortScan(const NetworkInterface &sender4, const NetworkInterface &sender6, std::vector<NetworkAdress> targets, std::vector<int> tcpPorts, std::vector<int> udpPorts, int timeout, Backend backend, int hostProbes, int bannerBytes, ResultCallback onResult) {
+    this->onResult = onResult;
+
+    // a target needs an address of its IP version on the interface, the probes have no source otherwise
+    std::vector<NetworkAdress> targets4, targets6;
+    for (const NetworkAdress &target : targets) {
+        if (!target.valid) continue;
+        bool isIpv4 = target.ipVer == IpVersion::IPV4;
+        const NetworkInterface &sender = isIpv4 ? sender4 : sender6;
+        if (!sender.address.valid) {
+            throw std::runtime_error("No " + std::string(isIpv4 ? "IPv4" : "IPv6") + " address on interface " + sender.name + " for target " + toString(target));
+        }
+        (isIpv4 ? targets4 : targets6).push_back(target);
+    }
+
+    // the open TCP ports go through the banner stage on their way to the output
+    report = this->onResult;
+    if (bannerBytes > 0 && !tcpPorts.empty()) {
+        banners.emplace(sender4, sender6, bannerBytes, timeout, backend == Backend::XDP, this->onResult);
+        report = [this](const PortResult &result) {
+            if (result.protocol == Protocol::TCP && result.result == ScanResult::OPEN) banners->add(result);
+            else this->onResult(result);
+        };
+    }
+
+    // the kernel does the handshakes, no raw socket is opened and no root needed
+    if (backend == Backend::CONNECT) {
+        if (!udpPorts.empty()) std::cerr << "Warning: UDP ports need raw sockets, the connect backend scans the TCP ports only" << std::endl;
+        targets4.insert(targets4.end(), targets6.begin(), targets6.end());
+        if (!tcpPorts.empty() && !targets4.empty()) connects.emplace(sender4, sender6, targets4, tcpPorts, timeout);
+        return;
+    }
+
+    // the schedulers are specialized for their IP version, a dual stack scan runs both in one loop
+    if (!targets4.empty()) ipv4.emplace(sender4, targets4, tcpPorts, udpPorts, timeout, backend, hostProbes);
+    if (!targets6.empty()) {
+        // an AF_XDP socket owns the queue of the interface, the IPv6 probes go over the raw sockets then
+        Backend backend6 = backend;
+        if (ipv4 && backend == Backend::XDP) {
+            std::cerr << "Warning: an XDP socket can not share the queue of the interface, the IPv6 targets are scanned with the raw backend" << std::endl;
+            backend6 = Backend::RAW;
+        }
+        ipv6.emplace(sender6, targets6, tcpPorts, udpPorts, timeout, backend6, hostProbes);
+    }
+    budget = ScanBudget(targets4.size() + targets6.size());
+}
+
+// Method to scan all the ports to the end
+void PortScan::run() {
+    // a single scheduler waits in its transport, that knows its own wake ups best
+    if (!banners && !(ipv4 && ipv6)) {
+        if (ipv4) ipv4->run(report);
+        if (ipv6) ipv6->run(report);
+        if (connects) connects->run(report);
+        return;
+    }
+
+    start();
+    std::vector<struct pollfd> fds;
+    fds.reserve(8);
+    while (!finished()) {
+        sendDue();
+
+        int timeoutMs = -1;
+        fds.clear();
+        addPollFds(fds, timeoutMs);
+        if (poll(fds.data(), fds.size(), timeoutMs) < 0 && errno != EINTR) {
+            perror("poll failed");
+            throw std::runtime_error("Failed to wait for the replies");
+        }
+        process();
+    }
+}
+
+// Method to prepare the scan for a loop, that drives several scans
+void PortScan::start(ScanBudget *shared) {
+    // one global window, the sockets of both versions share the link
+    if (shared == nullptr && ipv4 && ipv6) shared = &budget;
+    if (shared != nullptr) {
+        if (ipv4) ipv4->shareBudget(*shared);
+        if (ipv6) ipv6->shareBudget(*shared);
+    }
+    if (ipv4) ipv4->start(report);
+    if (ipv6) ipv6->start(report);
+}
+
+// Method to send the probes, that are due
+void PortScan::sendDue() {
+    // the versions take turns to be first at the shared window
+    bool run4 = ipv4 && !ipv4->finished();
+    bool run6 = ipv6 && !ipv6->finished();
+    if (ipv4First && run4) ipv4->sendDue();
+    if (run6) ipv6->sendDue();
+    if (!ipv4First && run4) ipv4->sendDue();
+    ipv4First = !ipv4First;
+}
+
+// Method to add the sockets of the scan to the poll set of the loop
+void PortScan::addPollFds(std::vector<struct pollfd> &fds, int &timeoutMs) {
+    // a finished scheduler is left alone
+    if (ipv4 && !ipv4->finished()) {
+        earlier(timeoutMs, ipv4->nextEventMs());
+        ipv4->addPollFds(fds, timeoutMs);
+    }
+    if (ipv6 && !ipv6->finished()) {
+        earlier(timeoutMs, ipv6->nextEventMs());
+        ipv6->addPollFds(fds, timeoutMs);
+    }
+    if (connects) connects->addPollFds(fds, timeoutMs);
+    if (banners) banners->addPollFds(fds, timeoutMs);
+}
+
+// Method to handle the answers, the finished connects and banners and the expired probes after a wake up
+void PortScan::process() {
+    // the replies to the probes first, the banners take what is left of the pass
+    if (ipv4 && !ipv4->finished()) ipv4->process(report);
+    if (ipv6 && !ipv6->finished()) ipv6->process(report);
+    if (connects && !connects->finished()) connects->process(report);
+    if (banners) banners->process();
+}
+
+// Method to check, if all the ports are finished
+bool PortScan::finished() const {
+    return (!ipv4 || ipv4->finished()) && (!ipv6 || ipv6->finished()) && (!connects || connects->finished()) && (!banners || banners->finished());
+}
+
+// Method to get the number of answers, the kernel dropped during the scan
+uint64_t PortScan::getDrops() const {
+    return (ipv4 ? ipv4->getDrops() : 0) + (ipv6 ? ipv6->getDrops() : 0);
+}
+
+// Method to get the global congestion window at the end of the scan
+int PortScan::getWindow() const {
+    return ipv4 ? ipv4->getWindow() : ipv6 ? ipv6->getWindow() : 0;
+}
+
+// function to format a finished port as a line of the output
+std::string formatResult(const PortResult &result, bool showRtt) {
+    char address[INET6_ADDRSTRLEN];
+    std::string line = toString(result.target, address, sizeof(address));
+    line += " " + std::to_string(result.port) + (result.protocol == Protocol::TCP ? " tcp " : " udp ") + toString(result.result);
+    // the ICMP error, that filtered the port
+    if (result.result == ScanResult::FILTERED && result.icmpType >= 0) line += " (icmp " + std::to_string(result.icmpType) + "/" + std::to_string(result.icmpCode) + ")";
+    // round trip time in ms, from the kernel timestamp of the answer
+    if (showRtt && result.rttNs >= 0) {
+        char rtt[32];
+        snprintf(rtt, sizeof(rtt), " rtt %.3f ms", result.rttNs / 1e6);
+        line += rtt;
+    }
+    if (!result.banner.empty()) line += " banner " + quoteBanner(result.banner);
+    return line;
+}
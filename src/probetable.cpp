@@ -0,0 +1,112 @@
+/**
+ * @file probetable.cpp
+ * @brief File for the table of the probes in flight (open addressing, keyed by address, port and protocol)
+ * @author Martin Mendl <x247581>
+ * @date 2025-08-04
+ */
+
+#include <cstring>
+#include <sys/socket.h>
+#include "probetable.hpp"
+
+// function to build the key of a probe
+ProbeKey makeProbeKey(int family, const void *addr, int port, Protocol protocol) {
+    ProbeKey key;
+    memset(&key, 0, sizeof(key));
+
+    if (family == AF_INET) {
+        // IPv4 mapped, so both families share one key layout
+        unsigned char *bytes = (unsigned char*)key.addr;
+        bytes[10] = bytes[11] = 0xff;
+        memcpy(bytes + 12, addr, 4);
+    } else {
+        memcpy(key.addr, addr, sizeof(key.addr));
+    }
+    key.port = port;
+    key.protocol = uint8_t(protocol);
+    return key;
+}
+
+// Constructor for ProbeTable class
+ProbeTable::ProbeTable(size_t capacity) {
+    // at most half full, so the clusters stay short
+    size_t size = 16;
+    while (size < capacity * 2) size *= 2;
+
+    slots = new ProbeEntry[size]();
+    mask = size - 1;
+}
+
+// Destructor for ProbeTable class
+ProbeTable::~ProbeTable() {
+    delete[] slots;
+}
+
+// Method to get the home slot of the key
+size_t ProbeTable::home(const ProbeKey &key) const {
+    // the low half of the address varies the most, the mapped prefix of IPv4 does not
+    uint64_t h = key.addr[1] ^ (key.addr[0] * 0x9e3779b97f4a7c15ULL) ^ (uint64_t(key.port) << 8 | key.protocol);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h & mask;
+}
+
+// Method to find the entry of the key
+ProbeEntry* ProbeTable::find(const ProbeKey &key) {
+    for (size_t i = home(key); slots[i].used; i = (i + 1) & mask) {
+        if (slots[i].key == key) return &slots[i];
+    }
+    return nullptr;
+}
+
+// Method to find the entry of the key, or add an empty one
+ProbeEntry* ProbeTable::insert(const ProbeKey &key) {
+    if ((count + 1) * 2 > capacity()) grow();
+
+    size_t i = home(key);
+    for (; slots[i].used; i = (i + 1) & mask) {
+        if (slots[i].key == key) return &slots[i];
+    }
+
+    slots[i] = ProbeEntry();
+    slots[i].key = key;
+    slots[i].used = true;
+    count++;
+    return &slots[i];
+}
+
+// Method to remove the entry
+void ProbeTable::erase(ProbeEntry *entry) {
+    size_t hole = entry - slots;
+    count--;
+
+    // move back every entry of the cluster, whose home slot is not between the hole and itself
+    for (size_t i = (hole + 1) & mask; slots[i].used; i = (i + 1) & mask) {
+        size_t wanted = home(slots[i].key);
+        bool reachable = (hole <= i) ? (hole < wanted && wanted <= i) : (hole < wanted || wanted <= i);
+        if (reachable) continue;
+
+        slots[hole] = slots[i];
+        hole = i;
+    }
+    slots[hole].used = false;
+}
+
+// Method to double the number of slots and insert all the entries again
+void ProbeTable::grow() {
+    ProbeEntry *old = slots;
+    size_t oldSize = capacity();
+
+    slots = new ProbeEntry[oldSize * 2]();
+    mask = oldSize * 2 - 1;
+    for (size_t i = 0; i < oldSize; i++) {
+        if (!old[i].used) continue;
+        size_t j = home(old[i].key);
+        while (slots[j].used) j = (j + 1) & mask;
+        slots[j] = old[i];
+    }
+    delete[] old;
+}
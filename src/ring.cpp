@@ -0,0 +1,173 @@
+/**
+ * @file ring.cpp
+ * @brief File for the PACKET_MMAP transport (AF_PACKET socket with TPACKET_V3 rings)
+ * @author Martin Mendl <x247581>
+ * @date 2025-28-03
+ */
+
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/ethernet.h>
+#include <linux/net_tstamp.h>
+#include "ring.hpp"
+
+// Constructor for PacketRing class
+PacketRing::PacketRing(const NetworkAdress &sender, const LinkInfo &link) : LinkTransport(sender, link) {
+
+    // protocol 0, nothing is queued before the rings are set up
+    sockfd = socket(AF_PACKET, SOCK_RAW, 0);
+    if (sockfd < 0) {
+        throw std::runtime_error("Failed to create packet socket");
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(sockfd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        close(sockfd);
+        throw std::runtime_error("Failed to set TPACKET_V3");
+    }
+
+    // our own frames would come back on the receive ring otherwise
+    int ignore = 1;
+    setsockopt(sockfd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &ignore, sizeof(ignore));
+
+    // the frames carry the software timestamp, the same clock as the send time of the probes
+    int stamps = SOF_TIMESTAMPING_SOFTWARE;
+    setsockopt(sockfd, SOL_PACKET, PACKET_TIMESTAMP, &stamps, sizeof(stamps));
+
+    // receive ring, blocks are handed over when full or after the retire timeout
+    memset(&rxReq, 0, sizeof(rxReq));
+    rxReq.tp_block_size = RING_BLOCK_SIZE;
+    rxReq.tp_block_nr = RING_RX_BLOCKS;
+    rxReq.tp_frame_size = RING_FRAME_SIZE;
+    rxReq.tp_frame_nr = (RING_BLOCK_SIZE / RING_FRAME_SIZE) * RING_RX_BLOCKS;
+    rxReq.tp_retire_blk_tov = RING_RETIRE_MS;
+    if (setsockopt(sockfd, SOL_PACKET, PACKET_RX_RING, &rxReq, sizeof(rxReq)) < 0) {
+        close(sockfd);
+        throw std::runtime_error("Failed to set up the receive ring");
+    }
+
+    // transmit ring, the kernel uses fixed size frames for TPACKET_V3
+    memset(&txReq, 0, sizeof(txReq));
+    txReq.tp_block_size = RING_BLOCK_SIZE;
+    txReq.tp_block_nr = RING_TX_BLOCKS;
+    txReq.tp_frame_size = RING_FRAME_SIZE;
+    txReq.tp_frame_nr = (RING_BLOCK_SIZE / RING_FRAME_SIZE) * RING_TX_BLOCKS;
+    if (setsockopt(sockfd, SOL_PACKET, PACKET_TX_RING, &txReq, sizeof(txReq)) < 0) {
+        close(sockfd);
+        throw std::runtime_error("Failed to set up the transmit ring");
+    }
+
+    mapSize = size_t(rxReq.tp_block_size) * rxReq.tp_block_nr + size_t(txReq.tp_block_size) * txReq.tp_block_nr;
+    void *mapping = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, sockfd, 0);
+    if (mapping == MAP_FAILED) mapping = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, sockfd, 0);
+    if (mapping == MAP_FAILED) {
+        close(sockfd);
+        throw std::runtime_error("Failed to map the packet rings");
+    }
+    map = (char*)mapping;
+
+    // the transmit frames keep the Ethernet source and type between the probes
+    char *txRing = map + size_t(rxReq.tp_block_size) * rxReq.tp_block_nr;
+    for (unsigned i = 0; i < txReq.tp_frame_nr; i++) {
+        fillTemplate(txRing + size_t(i) * txReq.tp_frame_size + TPACKET3_HDRLEN - sizeof(struct sockaddr_ll));
+    }
+
+    // bind to the interface, from now on the frames are queued
+    struct sockaddr_ll addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_ALL);
+    addr.sll_ifindex = link.ifindex;
+    if (bind(sockfd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        munmap(map, mapSize);
+        close(sockfd);
+        throw std::runtime_error("Failed to bind the packet socket to the interface");
+    }
+}
+
+// Destructor for PacketRing class
+PacketRing::~PacketRing() {
+    if (map != nullptr) munmap(map, mapSize);
+    if (sockfd >= 0) close(sockfd);
+}
+
+// Method to get the next free transmit frame
+char* PacketRing::nextFrame(size_t *size) {
+    char *txRing = map + size_t(rxReq.tp_block_size) * rxReq.tp_block_nr;
+    struct tpacket3_hdr *header = (struct tpacket3_hdr*)(txRing + size_t(txFrame) * txReq.tp_frame_size);
+
+    // the kernel still owns the frame, the ring is full
+    if (header->tp_status & (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING)) return nullptr;
+    if (header->tp_status & TP_STATUS_WRONG_FORMAT) {
+        throw std::runtime_error("Kernel rejected a frame from the transmit ring");
+    }
+
+    // the frame data starts right behind the header, no sockaddr_ll for transmit
+    size_t offset = TPACKET3_HDRLEN - sizeof(struct sockaddr_ll);
+    *size = txReq.tp_frame_size - offset;
+    return (char*)header + offset;
+}
+
+// Method to hand the frame from nextFrame over to the kernel
+void PacketRing::commitFrame(size_t size) {
+    char *txRing = map + size_t(rxReq.tp_block_size) * rxReq.tp_block_nr;
+    struct tpacket3_hdr *header = (struct tpacket3_hdr*)(txRing + size_t(txFrame) * txReq.tp_frame_size);
+
+    header->tp_len = size;
+    header->tp_snaplen = size;
+    header->tp_next_offset = 0;
+    __atomic_store_n(&header->tp_status, TP_STATUS_SEND_REQUEST, __ATOMIC_RELEASE);
+
+    txFrame = (txFrame + 1) % txReq.tp_frame_nr;
+    txPending++;
+}
+
+// Method to send all the committed frames
+void PacketRing::flush() {
+    if (txPending == 0) return;
+    if (send(sockfd, nullptr, 0, MSG_DONTWAIT) < 0) {
+        if (!isBackpressure(errno)) {
+            perror("send failed");
+            throw std::runtime_error("Failed to send the transmit ring");
+        }
+        backpressure++;  // the frames stay in the ring, the next flush sends them again
+        return;
+    }
+    txPending = 0;
+}
+
+// Method to get the number of received packets, the kernel dropped so far
+uint64_t PacketRing::getDrops() {
+    // reading the statistics resets them
+    struct tpacket_stats_v3 stats;
+    socklen_t len = sizeof(stats);
+    if (getsockopt(sockfd, SOL_PACKET, PACKET_STATISTICS, &stats, &len) == 0) drops += stats.tp_drops;
+    return drops;
+}
+
+// Method to read all the waiting packets
+void PacketRing::receive(const SegmentCallback &onSegment) {
+    while (true) {
+        struct tpacket_block_desc *block = (struct tpacket_block_desc*)(map + size_t(rxBlock) * rxReq.tp_block_size);
+        if (!(__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER)) return;
+
+        // the frames are parsed in place, the block goes back to the kernel afterwards
+        struct tpacket3_hdr *frame = (struct tpacket3_hdr*)((char*)block + block->hdr.bh1.offset_to_first_pkt);
+        for (unsigned i = 0; i < block->hdr.bh1.num_pkts; i++) {
+            // the kernel flags the frames, while the ring drops packets
+            if (frame->tp_status & TP_STATUS_LOSING) getDrops();
+            // the frame is stamped, when it enters the ring, not when the block is retired
+            int64_t receivedNs = int64_t(frame->tp_sec) * 1000000000 + frame->tp_nsec;
+            handleFrame((const char*)frame + frame->tp_mac, frame->tp_snaplen, receivedNs, onSegment);
+            frame = (struct tpacket3_hdr*)((char*)frame + frame->tp_next_offset);
+        }
+
+        __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        rxBlock = (rxBlock + 1) % rxReq.tp_block_nr;
+    }
+}
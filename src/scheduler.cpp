@@ -0,0 +1,538 @@
+/**
+ * @file scheduler.cpp
+ * @brief File for the scan scheduler (asynchronous TCP and UDP probes over all targets)
+ * @author Martin Mendl <x247581>
+ * @date 2025-22-03
+*/
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include <netinet/tcp.h>
+#include <netinet/udp.h>
+#include <netinet/ip_icmp.h>
+#include <netinet/icmp6.h>
+#include "scheduler.hpp"
+#include "icmp.hpp"
+
+// Method to grow the window for an answer
+void CongestionWindow::grow() {
+    size += (size < threshold) ? 1.0 : 1.0 / size;
+    size = std::min(size, double(limit));
+}
+
+// Method to halve the window for a loss
+bool CongestionWindow::shrink(Clock::time_point now, int timeoutMs) {
+    // the losses of one burst show up within a timeout, they halve the window once
+    if (lastDecrease.time_since_epoch().count() != 0 && now - lastDecrease < std::chrono::milliseconds(timeoutMs)) return false;
+    lastDecrease = now;
+    size = std::max(size / 2, double(MIN_PROBE_WINDOW));
+    threshold = size;
+    return true;
+}
+
+// Constructor for Scheduler class
+template <typename Family>
+Scheduler<Family>::Scheduler(const NetworkInterface &sender, std::vector<NetworkAdress> targets, std::vector<int> tcpPorts, std::vector<int> udpPorts, int timeout, Backend backend, int hostProbes) {
+    this->sender = sender;
+    this->timeout = timeout;
+    if (hostProbes > 0) hostCap = hostProbes;
+    if (targets.empty()) return;
+
+    if (!sender.address.valid || sender.address.ipVer != Family::version) {
+        throw std::runtime_error("Invalid sender IP address");
+    }
+    toSockaddr(this->sender.address, senderAddr);
+
+    transport = createTransport(backend, this->sender, !tcpPorts.empty(), !udpPorts.empty());
+
+    for (const NetworkAdress &target : targets) {
+        if (target.ipVer != Family::version) {
+            throw std::runtime_error("Sender and receiver IP versions do not match");
+        }
+
+        Host<Family> host;
+        host.target = target;
+        toSockaddr(target, host.addr);
+
+        // the Ethernet header is resolved once per target, not per probe
+        transport->resolve(target, host.mac);
+
+        host.tcpPending.assign(tcpPorts.begin(), tcpPorts.end());
+        host.udpPending.assign(udpPorts.begin(), udpPorts.end());
+        host.replies.reserve(UDP_REPLY_HISTORY + 1);
+        host.nextSend = Clock::now();
+        // the window of a protocol does not grow past the cap of the host
+        int limit = std::min(PROBE_WINDOW, hostCap);
+        host.window = CongestionWindow(std::min(INITIAL_PROBE_WINDOW, limit), limit);
+        hosts.push_back(host);
+    }
+
+    // the global window starts at the sum of the host windows, it can take all of them at the most
+    ownBudget = ScanBudget(hosts.size());
+
+    // a window of probes per host and protocol, paced UDP probes grow the table if needed
+    probes = new ProbeTable(hosts.size() * PROBE_WINDOW * 2);
+    // a deadline per probe in the window, the stale deadlines of the retries stay until they expire
+    expiries.reserve(hosts.size() * PROBE_WINDOW * 2 * UDP_MAX_PROBES);
+    // the answers to a full window can arrive at once
+    transport->setReceiveWindow(hosts.size() * PROBE_WINDOW * 2);
+}
+
+// Destructor for Scheduler class
+template <typename Family>
+Scheduler<Family>::~Scheduler() {
+    // a scan stopped early gives its source ports and its probes in the shared window back
+    while (probes != nullptr && !expiries.empty()) {
+        ProbeEntry *entry = probes->find(expiries.front().key);
+        if (entry != nullptr && entry->inFlight && entry->probe.sentAt == expiries.front().sentAt) {
+            entry->inFlight = false;
+            budget->inFlight--;
+            releasePort(entry);
+        }
+        expiries.pop_front();
+    }
+    // the ports waiting for a retry still hold the port of their last probe
+    for (Host<Family> &host : hosts) {
+        for (size_t i = 0; probes != nullptr && i < host.tcpPending.size(); i++) {
+            ProbeEntry *entry = probes->find(keyOf(host, Protocol::TCP, host.tcpPending[i]));
+            if (entry != nullptr) releasePort(entry);
+        }
+        for (size_t i = 0; probes != nullptr && i < host.udpPending.size(); i++) {
+            ProbeEntry *entry = probes->find(keyOf(host, Protocol::UDP, host.udpPending[i]));
+            if (entry != nullptr) releasePort(entry);
+        }
+    }
+    if (transport != nullptr) delete transport;
+    if (probes != nullptr) delete probes;
+}
+
+// Method to scan all ports on all targets
+template <typename Family>
+void Scheduler<Family>::run(const ResultCallback &onResult) {
+    if (hosts.empty()) return;
+    start(onResult);
+
+    while (!finished()) {
+        sendDue();
+
+        // a blocked transport is tried again after every wake up
+        transport->wait(nextEventMs(), txBlocked);
+        process(onResult);
+    }
+    checkDrops(Clock::now());  // the total for the report
+}
+
+// Method to prepare the scan for a loop, that drives several schedulers
+template <typename Family>
+void Scheduler<Family>::start(const ResultCallback &onResult) {
+    // built once, not per wake up
+    onSegment = [this, &onResult](int, const void *source, int protocol, const char *segment, size_t size, int64_t receivedNs) {
+        handleSegment(source, protocol, segment, size, receivedNs, onResult);
+    };
+}
+
+// Method to handle the received packets and the expired probes after a wake up
+template <typename Family>
+void Scheduler<Family>::process(const ResultCallback &onResult) {
+    txBlocked = false;
+
+    // the transport delivers only the family of its sockets
+    transport->receive(onSegment);
+    checkBackpressure(Clock::now());
+    expireProbes(onResult);
+
+    // the total for the report
+    if (finished()) checkDrops(Clock::now());
+}
+
+// Method to send the probes, that are due
+template <typename Family>
+void Scheduler<Family>::sendDue() {
+    Clock::time_point now = Clock::now();
+    size_t count = hosts.size();
+    bool sent = true;
+
+    // one probe per host, protocol and pass, so the hosts are interleaved
+    while (sent && !txBlocked && !portsBlocked) {
+        sent = false;
+        for (size_t i = 0; i < count && !txBlocked && !portsBlocked; i++) {
+            Host<Family> &host = hosts[(nextHost + i) % count];
+
+            if (!host.tcpPending.empty() && windowOpen(host, Protocol::TCP)) {
+                int port = host.tcpPending.front();
+                if (!sendProbe(host, Protocol::TCP, port)) break;
+                host.tcpPending.pop_front();
+                sent = true;
+            }
+
+            bool udpDue = !host.udpPending.empty() && now >= host.nextSend;
+            if (udpDue && windowOpen(host, Protocol::UDP)) {
+                int port = host.udpPending.front();
+                if (!sendProbe(host, Protocol::UDP, port)) break;
+                host.udpPending.pop_front();
+                host.nextSend = now + std::chrono::milliseconds(host.intervalMs);
+                sent = true;
+            }
+        }
+        nextHost = (nextHost + 1) % count;
+    }
+
+    transport->flush();
+}
+
+// Method to send a single probe
+template <typename Family>
+bool Scheduler<Family>::sendProbe(Host<Family> &host, Protocol protocol, int port) {
+    // a retry gives the port of the timed out probe back first, so the ports waiting for a retry can not block their own retries
+    ProbeEntry *previous = probes->find(keyOf(host, protocol, port));
+    if (previous != nullptr) releasePort(previous);
+
+    // every probe in flight has its own source port, the scan waits for one to come back
+    uint16_t sourcePort = ports.acquire();
+    if (sourcePort == 0) {
+        portsBlocked = true;
+        return false;
+    }
+
+    size_t space;
+    char *segment = transport->reserve(&space);
+    if (segment == nullptr) {
+        ports.release(sourcePort);
+        txBlocked = true;
+        return false;
+    }
+
+    size_t segmentLen = buildSegment(segment, space, host, protocol, port, sourcePort);
+    transport->claimPort(sourcePort, true);
+    int64_t sentNs = wallClockNs();  // same clock as the receive timestamps of the kernel
+    transport->commit((const struct sockaddr*)&host.addr, host.mac, (protocol == Protocol::TCP) ? IPPROTO_TCP : IPPROTO_UDP, segmentLen);
+
+    // a retry finds the entry of the first probe
+    ProbeEntry *entry = probes->insert(keyOf(host, protocol, port));
+    entry->probe = {protocol, port, Clock::now(), host.intervalMs, sourcePort, sentNs};
+    entry->host = &host - hosts.data();
+    entry->attempts++;
+    entry->inFlight = true;
+    expiries.push_back({entry->key, entry->probe.sentAt});
+
+    if (protocol == Protocol::TCP) host.tcpInFlight++;
+    else host.udpInFlight++;
+    budget->inFlight++;
+    return true;
+}
+
+// Method to check, if the windows allow one more probe to the host
+template <typename Family>
+bool Scheduler<Family>::windowOpen(const Host<Family> &host, Protocol protocol) const {
+    if (!budget->window.allows(budget->inFlight) || host.tcpInFlight + host.udpInFlight >= hostCap) return false;
+    if (protocol == Protocol::TCP) return host.window.allows(host.tcpInFlight);
+    return host.paced || host.window.allows(host.udpInFlight);  // a paced host is limited by its interval
+}
+
+// Method to adjust the congestion windows for an answer
+template <typename Family>
+void Scheduler<Family>::onAnswer(Host<Family> &host, bool lost) {
+    if (!lost) {
+        host.window.grow();
+        budget->window.grow();
+        return;
+    }
+    Clock::time_point now = Clock::now();
+    host.window.shrink(now, timeout);
+    budget->window.shrink(now, timeout);
+}
+
+// Method to write the TCP or UDP header (and payload) of the probe
+template <typename Family>
+size_t Scheduler<Family>::buildSegment(char *buffer, size_t size, const Host<Family> &host, Protocol protocol, int port, uint16_t sourcePort) {
+    typename Family::SockAddr recv = host.addr;
+    typename Family::SockAddr send = senderAddr;
+    Family::port(recv) = htons(port);
+    Family::port(send) = htons(sourcePort);
+
+    if (protocol == Protocol::TCP) {
+        SynPacket synPacket(buffer, size);
+        synPacket.constructSynPacket<Family>(send, recv);
+        return synPacket.getSize();
+    }
+
+    UDPpacket udpPacket(buffer, size);
+    udpPacket.constructUDPpacket<Family>(send, recv);
+    return udpPacket.getSize();
+}
+
+// Method to handle the transport layer of a received packet
+template <typename Family>
+void Scheduler<Family>::handleSegment(const void *source, int protocol, const char *segment, size_t size, int64_t receivedNs, const ResultCallback &onResult) {
+    // ICMP errors are matched by the quoted probe, they can come from a router
+    if (protocol == IPPROTO_ICMP || protocol == IPPROTO_ICMPV6) {
+        IcmpError error;
+        if (parseIcmpError(Family::family, segment, size, error)) handleIcmpError(error, receivedNs, onResult);
+        return;
+    }
+
+    if (protocol == IPPROTO_TCP) {
+        if (size < sizeof(struct tcphdr)) return;
+        const struct tcphdr *tcpHeader = (const struct tcphdr*)segment;
+
+        // the answer comes from the probed port to the source port of its last probe
+        if (!ports.contains(ntohs(tcpHeader->th_dport))) return;
+        ProbeEntry *entry = probes->find(makeProbeKey(Family::family, source, ntohs(tcpHeader->th_sport), Protocol::TCP));
+        if (entry == nullptr) return;  // not scanned, or already finished
+        if (entry->probe.sourcePort != ntohs(tcpHeader->th_dport)) return;  // answer to an earlier probe
+        if (tcpHeader->th_flags & TH_RST) finishPort(entry, ScanResult::CLOSED, onResult, nullptr, receivedNs);
+        else if ((tcpHeader->th_flags & TH_SYN) && (tcpHeader->th_flags & TH_ACK)) finishPort(entry, ScanResult::OPEN, onResult, nullptr, receivedNs);
+    } else if (protocol == IPPROTO_UDP) {
+        if (size < sizeof(struct udphdr)) return;
+        const struct udphdr *udpHeader = (const struct udphdr*)segment;
+        if (!ports.contains(ntohs(udpHeader->uh_dport))) return;
+        ProbeEntry *entry = probes->find(makeProbeKey(Family::family, source, ntohs(udpHeader->uh_sport), Protocol::UDP));
+        if (entry != nullptr && entry->probe.sourcePort == ntohs(udpHeader->uh_dport)) finishPort(entry, ScanResult::OPEN, onResult, nullptr, receivedNs);
+    }
+}
+
+// Method to handle an ICMP error quoting one of the probes
+template <typename Family>
+void Scheduler<Family>::handleIcmpError(const IcmpError &error, int64_t receivedNs, const ResultCallback &onResult) {
+    // the quoted packet has to be one of ours
+    if (!ports.contains(error.sourcePort)) return;
+    if (memcmp(error.source, &Family::address(senderAddr), sizeof(typename Family::Addr)) != 0) return;
+    Protocol protocol = (error.protocol == IPPROTO_TCP) ? Protocol::TCP : Protocol::UDP;
+    ProbeEntry *entry = probes->find(makeProbeKey(error.family, error.target, error.targetPort, protocol));
+    if (entry == nullptr || entry->probe.sourcePort != error.sourcePort) return;
+
+    // a SYN answered by an unreachable (mostly admin prohibited) is filtered, no need to send it again
+    if (protocol == Protocol::TCP) {
+        finishPort(entry, ScanResult::FILTERED, onResult, &error, receivedNs);
+        return;
+    }
+
+    // port unreachable closes the port, the other codes (host, net, admin prohibited) mean a filter
+    if (isPortUnreachable(error)) handleUnreachable(entry, error, receivedNs, onResult);
+    else finishPort(entry, ScanResult::FILTERED, onResult, &error, receivedNs);
+}
+
+// Method to handle a port unreachable message
+template <typename Family>
+void Scheduler<Family>::handleUnreachable(ProbeEntry *entry, const IcmpError &error, int64_t receivedNs, const ResultCallback &onResult) {
+    Host<Family> &host = hosts[entry->host];
+
+    // remember the spacing for the interval estimate, the kernel timestamps are not bunched by the wake ups
+    if (entry->inFlight) {
+        host.replies.push_back({entry->probe.sentNs, receivedNs});
+        if (host.replies.size() > size_t(UDP_REPLY_HISTORY)) host.replies.pop_front();
+        host.responsive = true;
+    }
+    finishPort(entry, ScanResult::CLOSED, onResult, &error, receivedNs);
+
+    // replies spaced wider than the probes, the host meters its ICMP messages
+    int estimate = estimateInterval(host);
+    if (estimate <= host.intervalMs) return;
+    if (!host.paced) {
+        startPacing(host);
+        return;
+    }
+    host.intervalMs = estimate;
+}
+
+// Method to finish the port, report it and remove its entry
+template <typename Family>
+void Scheduler<Family>::finishPort(ProbeEntry *entry, ScanResult result, const ResultCallback &onResult, const IcmpError *error, int64_t receivedNs) {
+    Host<Family> &host = hosts[entry->host];
+    Protocol protocol = entry->probe.protocol;
+    int port = entry->probe.port;
+
+    if (entry->inFlight) {
+        if (protocol == Protocol::TCP) host.tcpInFlight--;
+        else host.udpInFlight--;
+        budget->inFlight--;
+
+        // an answer to a retransmission means, that an earlier probe or its answer was lost,
+        // the retries to a paced host were silenced by its ICMP rate limit, not by loss
+        if (receivedNs > 0) onAnswer(host, entry->attempts > 1 && (protocol == Protocol::TCP || !host.paced));
+    } else {
+        // late answer to a probe, that already timed out and waits for a retry
+        RingQueue<int> &pending = (protocol == Protocol::TCP) ? host.tcpPending : host.udpPending;
+        pending.erase(port);
+    }
+    releasePort(entry);
+
+    PortResult finished = {host.target, port, protocol, result};
+    if (error != nullptr) {
+        finished.icmpType = error->type;
+        finished.icmpCode = error->code;
+    }
+    // the answer matched the source port of the last probe, so it answers that one
+    if (receivedNs > 0 && receivedNs >= entry->probe.sentNs) finished.rttNs = receivedNs - entry->probe.sentNs;
+    probes->erase(entry);
+    onResult(finished);
+}
+
+// Method to handle the probes, that timed out
+template <typename Family>
+void Scheduler<Family>::expireProbes(const ResultCallback &onResult) {
+    Clock::time_point now = Clock::now();
+    std::chrono::milliseconds limit(timeout);
+
+    // a timeout might be a dropped answer, the counters are checked before the probes expire
+    if (!expiries.empty() && now - expiries.front().sentAt >= limit) checkDrops(now);
+
+    // every probe has the same timeout, so they expire in the order they were sent
+    while (!expiries.empty()) {
+        Expiry expiry = expiries.front();
+
+        // the answered probes and the deadlines of the earlier attempts are dropped right away,
+        // the answers come mostly in order, so the ring stays about the size of the window
+        ProbeEntry *entry = probes->find(expiry.key);
+        bool stale = entry == nullptr || !entry->inFlight || entry->probe.sentAt != expiry.sentAt;
+        if (!stale && now - expiry.sentAt < limit) break;
+        expiries.pop_front();
+        if (stale) continue;
+
+        Probe probe = entry->probe;
+        Host<Family> &host = hosts[entry->host];
+        int attempts = entry->attempts;
+        entry->inFlight = false;
+        budget->inFlight--;
+
+        // the kernel dropped answers since the probe was sent, its answer might be one of them
+        bool dropped = lastDrop >= probe.sentAt;
+
+        // no SYN/ACK or RST, send once more, then the port is filtered
+        if (probe.protocol == Protocol::TCP) {
+            host.tcpInFlight--;
+            if (attempts < TCP_MAX_PROBES || (dropped && attempts < TCP_MAX_PROBES + DROP_RETRIES)) {
+                host.tcpPending.push_front(probe.port);
+                continue;
+            }
+            releasePort(entry);
+            probes->erase(entry);
+            onResult({host.target, probe.port, Protocol::TCP, ScanResult::FILTERED});
+            continue;
+        }
+
+        host.udpInFlight--;
+
+        // the host answers, the silence might be a dropped unreachable
+        if (host.responsive && !host.paced) startPacing(host);
+
+        // probe again, if it was sent faster than the host answers
+        bool fasterThanHost = host.responsive && probe.intervalMs < host.intervalMs && attempts < UDP_MAX_PROBES;
+        if (fasterThanHost || (dropped && attempts < UDP_MAX_PROBES + DROP_RETRIES)) {
+            host.udpPending.push_back(probe.port);
+            continue;
+        }
+
+        releasePort(entry);
+        probes->erase(entry);
+        onResult({host.target, probe.port, Protocol::UDP, ScanResult::OPEN});  // No response = Open
+    }
+}
+
+// Method to check the drop counters of the transport, halves the global window on new drops
+template <typename Family>
+void Scheduler<Family>::checkDrops(Clock::time_point now) {
+    uint64_t total = transport->getDrops();
+    if (total == drops) return;
+
+    drops = total;
+    lastDrop = now;
+    budget->window.shrink(now, timeout);
+}
+
+// Method to check the backpressure of the transport, halves the global window, when the transmit queue was full
+template <typename Family>
+void Scheduler<Family>::checkBackpressure(Clock::time_point now) {
+    uint64_t total = transport->getBackpressure();
+    if (total == backpressure) return;
+    backpressure = total;
+
+    // the parked probes are sent later, not lost, a full queue slows the scan down like a loss
+    budget->window.shrink(now, timeout);
+}
+
+// Method to compute the poll timeout until the next event
+template <typename Family>
+int Scheduler<Family>::nextEventMs() const {
+    Clock::time_point now = Clock::now();
+    Clock::time_point next = now + std::chrono::milliseconds(timeout);
+
+    for (const Host<Family> &host : hosts) {
+        if (!txBlocked && !portsBlocked) {
+            if (!host.tcpPending.empty() && windowOpen(host, Protocol::TCP)) next = now;
+            if (!host.udpPending.empty() && windowOpen(host, Protocol::UDP)) next = std::min(next, host.nextSend);
+        }
+    }
+    if (!expiries.empty()) next = std::min(next, expiries.front().sentAt + std::chrono::milliseconds(timeout));
+
+    if (next <= now) return 0;
+    return std::chrono::ceil<std::chrono::milliseconds>(next - now).count();
+}
+
+// Method to build the key of a probe to the host
+template <typename Family>
+ProbeKey Scheduler<Family>::keyOf(const Host<Family> &host, Protocol protocol, int port) const {
+    return makeProbeKey(Family::family, &Family::address(host.addr), port, protocol);
+}
+
+// Method to estimate the ICMP refill interval of the host
+template <typename Family>
+int Scheduler<Family>::estimateInterval(const Host<Family> &host) const {
+    std::array<int, UDP_REPLY_HISTORY> gaps;
+    size_t count = 0;
+
+    // a gap counts, if the replies are further apart, than the probes they answer
+    for (size_t i = 1; i < host.replies.size(); i++) {
+        int64_t sendGap = host.replies[i].first - host.replies[i - 1].first;
+        int64_t recvGap = host.replies[i].second - host.replies[i - 1].second;
+        int sendMs = std::abs(sendGap) / 1000000;
+        int recvMs = recvGap / 1000000;
+        if (recvMs - sendMs > UDP_METER_SLACK_MS) gaps[count++] = recvMs;
+    }
+
+    if (count < 2) return 0;
+    std::sort(gaps.begin(), gaps.begin() + count);
+    return gaps[count / 2];
+}
+
+// Method to start pacing the UDP probes to the host
+template <typename Family>
+void Scheduler<Family>::startPacing(Host<Family> &host) {
+    int estimate = estimateInterval(host);
+    host.paced = true;
+    host.intervalMs = (estimate > 0) ? estimate : UDP_DEFAULT_LIMIT_MS;
+}
+
+// Method to give the source port of the probe back, once the port is finished or probed again
+template <typename Family>
+void Scheduler<Family>::releasePort(ProbeEntry *entry) {
+    // a timed out probe keeps its port until then, so a late answer still reaches the scan and finishes the port
+    if (entry->probe.sourcePort == 0) return;
+    ports.release(entry->probe.sourcePort);
+    transport->claimPort(entry->probe.sourcePort, false);
+    entry->probe.sourcePort = 0;
+    portsBlocked = false;
+}
+
+// Method to check, if all ports are finished
+template <typename Family>
+bool Scheduler<Family>::finished() const {
+    if (probes == nullptr) return true;  // no targets
+    for (const Host<Family> &host : hosts) {
+        if (!host.tcpPending.empty() || !host.udpPending.empty()) return false;
+    }
+    return probes->size() == 0;
+}
+
+template class Scheduler<Ipv4>;
+template class Scheduler<Ipv6>;
@@ -8,6 +8,8 @@
 #include <iostream>
 #include <string>
 #include <string.h>
+#include <cerrno>
+#include <algorithm>
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <netinet/ip.h>
@@ -33,8 +35,18 @@ int returnProtocol(Protocol protocol) {
     return -1;
 }
 
+// Function to check, if a failed send only means, that the kernel has no room for the packet now
+bool isBackpressure(int error) {
+    return error == ENOBUFS || error == EAGAIN || error == EWOULDBLOCK;
+}
+
+// Function to get the next pause of the retries
+int nextBackoffMs(int backoffMs) {
+    return (backoffMs == 0) ? TX_BACKOFF_MIN_MS : std::min(backoffMs * 2, TX_BACKOFF_MAX_MS);
+}
+
 // Base Socket class constructor
-Socket::Socket(NetworkAdress sender, NetworkAdress receiver) {
+Socket::Socket(const NetworkInterface &sender, const NetworkAdress &receiver) {
     this->sender = sender;
     this->receiver = receiver;
 }
@@ -84,44 +96,17 @@ void Socket::setTimeout(int timeout) {
 // Method to bind the socket to the sender interface
 void Socket::bindToInterface() {
     // bind the socket to the sender interface 
-    if (setsockopt(sockfd, SOL_SOCKET, SO_BINDTODEVICE, sender.hostName.c_str(), sender.hostName.length()) < 0) {
+    if (setsockopt(sockfd, SOL_SOCKET, SO_BINDTODEVICE, sender.name.c_str(), sender.name.length()) < 0) {
         throw std::runtime_error("Failed to bind socket to interface");
     }
 }
 
-// Constructor for the SocketIpv4 class
-SocketIpv4::SocketIpv4(NetworkAdress sender, NetworkAdress receiver, Protocol protocol) : Socket(sender, receiver) {
+// Constructor for the RawSocket class
+template <typename Family>
+RawSocket<Family>::RawSocket(const NetworkInterface &sender, const NetworkAdress &receiver, Protocol protocol) : Socket(sender, receiver) {
     
     // Create socket
-    sockfd = socket(AF_INET, SOCK_RAW, returnProtocol(protocol));
-    if (sockfd < 0) {
-        throw std::runtime_error("Failed to create socket");
-    }
-
-    // bind the socket to the sender interface
-    bindToInterface();
-
-    // set the sender adress
-    setupNetworkAdress(sender, senderAddr);
-
-    // set the receiver adress
-    setupNetworkAdress(receiver, receiverAddr);
-}
-
-// Method to set the network adress for the socket
-void SocketIpv4::setupNetworkAdress(NetworkAdress &adress, struct sockaddr_in &sockAddr) {
-    memset(&sockAddr, 0, sizeof(sockAddr));
-    sockAddr.sin_family = AF_INET;
-    sockAddr.sin_port = htons(adress.port);
-    if (inet_pton(AF_INET, adress.ip.c_str(), &sockAddr.sin_addr) <= 0) {
-        throw std::runtime_error("Invalid sender IP4 address");
-    }
-}
-
-// Constructor for the SocketIpv6 class
-SocketIpv6::SocketIpv6(NetworkAdress sender, NetworkAdress receiver, Protocol protocol) : Socket(sender, receiver) {
-    // Create socket
-    sockfd = socket(AF_INET6, SOCK_RAW, returnProtocol(protocol));
+    sockfd = socket(Family::family, SOCK_RAW, returnProtocol(protocol));
     if (sockfd < 0) {
         throw std::runtime_error("Failed to create socket");
     }
@@ -130,19 +115,20 @@ SocketIpv6::SocketIpv6(NetworkAdress sender, NetworkAdress receiver, Protocol pr
     bindToInterface();
 
     // set the sender adress
-    setupNetworkAdress(sender, senderAddr);
+    setupNetworkAdress(sender.address, senderAddr);
 
     // set the receiver adress
     setupNetworkAdress(receiver, receiverAddr);
 }
 
 // Method to set the network adress for the socket
-void SocketIpv6::setupNetworkAdress(NetworkAdress &adress, struct sockaddr_in6 &sockAddr) {
-    memset(&sockAddr, 0, sizeof(sockAddr));
-    sockAddr.sin6_family = AF_INET6;
-    sockAddr.sin6_port = htons(adress.port);
-    if (inet_pton(AF_INET6, adress.ip.c_str(), &sockAddr.sin6_addr) <= 0) {
-        throw std::runtime_error("Invalid sender IP6 address");
+template <typename Family>
+void RawSocket<Family>::setupNetworkAdress(const NetworkAdress &adress, SockAddr &sockAddr) {
+    if (!adress.valid || adress.ipVer != Family::version) {
+        throw std::runtime_error("Invalid IP address for the socket family");
     }
+    toSockaddr(adress, sockAddr);
 }
 
+template class RawSocket<Ipv4>;
+template class RawSocket<Ipv6>;
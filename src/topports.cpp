@@ -0,0 +1,135 @@
+/**
+ * @file topports.cpp
+ * @brief File for the built in port profiles (the most common ports, in the order of their hit rate)
+ * @author Martin Mendl <x247581>
+ * @date 2025-12-09
+ */
+
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+#include "topports.hpp"
+
+// BEGIN GENERATED TABLES (genTopPorts.py)
+// TCP ports with the hosts per million, they were found open on (after the open frequencies of nmap-services), in port order
+static constexpr PortFrequency TCP_FREQUENCIES[] = {
+    {1, 3748}, {3, 2185}, {7, 10624}, {9, 8554}, {13, 8804}, {17, 4937},
+    {19, 5959}, {20, 1515}, {21, 197667}, {22, 182286}, {23, 221265}, {24, 1654},
+    {25, 131314}, {26, 17102}, {33, 1346}, {37, 7296}, {42, 875}, {49, 354},
+    {53, 48463}, {79, 13384}, {80, 484143}, {81, 20333}, {82, 6886}, {85, 421},
+    {88, 13579}, {90, 348}, {100, 4461}, {106, 13003}, {110, 77142}, {111, 30034},
+    {113, 20628}, {119, 7402}, {135, 47798}, {139, 50809}, {143, 50420}, {144, 10779},
+    {179, 18918}, {199, 21852}, {222, 1214}, {254, 3385}, {255, 5706}, {264, 1366},
+    {280, 3435}, {311, 3485}, {340, 323}, {366, 442}, {389, 10472}, {407, 1560},
+    {427, 11586}, {443, 208669}, {444, 10028}, {445, 56944}, {464, 1806}, {465, 21231},
+    {497, 1780}, {500, 1537}, {512, 957}, {513, 12098}, {514, 19472}, {515, 16144},
+    {543, 11256}, {544, 11095}, {548, 20927}, {554, 17350}, {563, 1144}, {587, 22491},
+    {593, 2153}, {625, 3536}, {631, 14385}, {636, 3915}, {646, 15021}, {787, 2605},
+    {808, 4866}, {873, 7957}, {888, 1178}, {902, 2643}, {990, 11925}, {992, 1110},
+    {993, 27199}, {995, 29921}, {999, 1269}, {1000, 7191}, {1002, 414}, {1022, 2031},
+    {1023, 1232}, {1024, 6406}, {1025, 22817}, {1026, 18647}, {1027, 15460}, {1028, 8073},
+    {1029, 8678}, {1030, 6690}, {1031, 4727}, {1032, 3058}, {1033, 2421}, {1034, 1471},
+    {1035, 1972}, {1036, 1943}, {1037, 1915}, {1038, 3859}, {1039, 4334}, {1040, 2386},
+    {1041, 5789}, {1042, 1307}, {1043, 971}, {1044, 4659}, {1045, 278}, {1046, 274},
+    {1047, 776}, {1048, 5624}, {1049, 5543}, {1050, 3014}, {1051, 764}, {1052, 753},
+    {1053, 5463}, {1054, 5384}, {1055, 742}, {1056, 5307}, {1057, 270}, {1058, 2530},
+    {1059, 2351}, {1060, 731}, {1061, 266}, {1062, 720}, {1064, 5231}, {1065, 5156},
+    {1066, 3641}, {1067, 456}, {1068, 1196}, {1069, 3588}, {1071, 4592}, {1074, 1887},
+    {1080, 2802}, {1110, 12633}, {1111, 1583}, {1218, 1449}, {1234, 2001}, {1311, 709},
+    {1352, 1630}, {1433, 16857}, {1494, 2217}, {1500, 318}, {1501, 293}, {1503, 338},
+    {1521, 2885}, {1717, 1127}, {1720, 21539}, {1723, 31699}, {1755, 7843}, {1761, 3288},
+    {1801, 6134}, {1863, 402}, {1864, 396}, {1900, 9062}, {1935, 1754}, {1998, 3148},
+    {2000, 18380}, {2001, 16378}, {2002, 3194}, {2003, 1728}, {2004, 1326}, {2005, 3103},
+    {2006, 1493}, {2007, 1046}, {2008, 1094}, {2009, 1001}, {2049, 13776}, {2065, 888},
+    {2103, 6314}, {2105, 3972}, {2107, 6499}, {2121, 12817}, {2161, 2843}, {2222, 308},
+    {2301, 2122}, {2383, 2493}, {2401, 2721}, {2601, 3803}, {2602, 862}, {2604, 812},
+    {2701, 943}, {2717, 7730}, {2869, 4272}, {2967, 5082}, {3000, 9328}, {3001, 7088},
+    {3052, 1250}, {3128, 10174}, {3260, 1428}, {3268, 2091}, {3269, 1606}, {3283, 698},
+    {3306, 45390}, {3333, 849}, {3389, 87173}, {3689, 4796}, {3690, 2927}, {3703, 5009},
+    {3986, 8932}, {4000, 3336}, {4001, 4210}, {4002, 800}, {4045, 2682}, {4443, 688},
+    {4444, 1386}, {4662, 901}, {4899, 7619}, {5000, 14806}, {5001, 6986}, {5002, 788},
+    {5003, 3241}, {5009, 9742}, {5050, 6046}, {5051, 8431}, {5060, 19193}, {5100, 824},
+    {5101, 10936}, {5120, 4149}, {5190, 9464}, {5225, 678}, {5226, 668}, {5357, 11754},
+    {5431, 390}, {5432, 9194}, {5500, 408}, {5550, 1016}, {5555, 2283}, {5631, 14594},
+    {5666, 15239}, {5678, 288}, {5800, 13192}, {5801, 986}, {5900, 23148}, {5901, 4526},
+    {5902, 435}, {6000, 12274}, {6001, 20042}, {6002, 2761}, {6004, 6223}, {6059, 658},
+    {6112, 2970}, {6543, 1678}, {6646, 8310}, {6666, 1703}, {6667, 343}, {6789, 648},
+    {6881, 333}, {7000, 3694}, {7001, 1062}, {7019, 929}, {7070, 9602}, {7100, 1161},
+    {7937, 2567}, {7938, 2061}, {8000, 17858}, {8002, 1860}, {8008, 15913}, {8009, 10322},
+    {8010, 4089}, {8021, 313}, {8031, 5873}, {8080, 42052}, {8081, 13976}, {8082, 1031},
+    {8085, 384}, {8088, 303}, {8089, 638}, {8443, 18117}, {8651, 628}, {8652, 619},
+    {8701, 610}, {8888, 22169}, {8899, 298}, {9000, 4030}, {9001, 1833}, {9050, 428},
+    {9071, 283}, {9090, 6594}, {9100, 7510}, {9102, 4397}, {9415, 601}, {9535, 836},
+    {9593, 592}, {9594, 583}, {9595, 574}, {9999, 9884}, {10000, 19755}, {10001, 2250},
+    {10010, 6787}, {10243, 378}, {13782, 449}, {15000, 1407}, {16992, 565}, {16993, 556},
+    {20828, 548}, {23502, 540}, {27000, 328}, {32768, 17602}, {32769, 532}, {32770, 1078},
+    {32771, 2457}, {33354, 524}, {35500, 516}, {42510, 1288}, {45100, 372}, {49152, 16616},
+    {49153, 14179}, {49154, 15685}, {49155, 12452}, {49156, 11420}, {49157, 8191}, {49999, 366},
+    {50000, 2317}, {50001, 915}, {51103, 360}, {52869, 508}, {55555, 500}, {55600, 492},
+    {64623, 484}, {64680, 477}, {65000, 470}, {65389, 463},
+};
+
+// UDP ports with the hosts per million, they were found open on (after the open frequencies of nmap-services), in port order
+static constexpr PortFrequency UDP_FREQUENCIES[] = {
+    {7, 15413}, {9, 3382}, {19, 3719}, {21, 1081}, {49, 2545}, {53, 213496},
+    {67, 228010}, {68, 140796}, {69, 102741}, {80, 20478}, {88, 2315}, {111, 94067},
+    {123, 330879}, {135, 244452}, {136, 43689}, {137, 365163}, {138, 297830}, {139, 182522},
+    {161, 433467}, {162, 103338}, {177, 7222}, {427, 5975}, {445, 253118}, {497, 5435},
+    {500, 163742}, {514, 119999}, {518, 10551}, {520, 139376}, {593, 11600}, {626, 8729},
+    {631, 450281}, {996, 55542}, {997, 54871}, {998, 60103}, {999, 53828}, {1022, 894},
+    {1023, 4496}, {1025, 27209}, {1026, 16944}, {1027, 7940}, {1028, 2105}, {1029, 2798},
+    {1433, 24750}, {1434, 293184}, {1645, 12753}, {1646, 14020}, {1701, 67349}, {1718, 1741},
+    {1719, 6569}, {1812, 48029}, {1900, 136722}, {2000, 1439}, {2048, 9597}, {2049, 36150},
+    {2222, 39741}, {3283, 53456}, {3456, 22513}, {4444, 4943}, {4500, 124713}, {5060, 29912},
+    {5353, 100294}, {10000, 983}, {17185, 1914}, {20031, 18627}, {31337, 1308}, {32768, 32883},
+    {34555, 1189}, {49152, 113384}, {49153, 52800}, {49154, 88730}, {49186, 1583}, {49193, 3076},
+    {65024, 4089},
+};
+// END GENERATED TABLES
+
+// function to sort the frequency table by the hit rate at compile time, equal rates in port order
+template <size_t N>
+static constexpr std::array<uint16_t, N> sortByFrequency(const PortFrequency (&table)[N]) {
+    std::array<PortFrequency, N> sorted = {};
+    std::copy(table, table + N, sorted.begin());
+    std::sort(sorted.begin(), sorted.end(), [](const PortFrequency &a, const PortFrequency &b) {
+        return a.hits > b.hits || (a.hits == b.hits && a.port < b.port);
+    });
+
+    std::array<uint16_t, N> ports = {};
+    for (size_t i = 0; i < N; i++) ports[i] = sorted[i].port;
+    return ports;
+}
+
+// function to check, that the table lists every port once and no port 0
+template <size_t N>
+static constexpr bool isValidTable(const PortFrequency (&table)[N]) {
+    for (size_t i = 0; i < N; i++) {
+        if (table[i].port == 0 || table[i].hits == 0) return false;
+        if (i > 0 && table[i - 1].port >= table[i].port) return false;
+    }
+    return true;
+}
+
+static_assert(isValidTable(TCP_FREQUENCIES), "The TCP frequency table has to be in port order without duplicates");
+static_assert(isValidTable(UDP_FREQUENCIES), "The UDP frequency table has to be in port order without duplicates");
+
+// the profiles, nothing is sorted or parsed at run time
+static constexpr auto TOP_TCP_PORTS = sortByFrequency(TCP_FREQUENCIES);
+static constexpr auto TOP_UDP_PORTS = sortByFrequency(UDP_FREQUENCIES);
+
+static_assert(TOP_TCP_PORTS[0] == 80 && TOP_UDP_PORTS[0] == 631, "The profiles start with the most common port");
+
+// function to get the number of ports in the profile of the protocol
+size_t topPortCount(Protocol protocol) {
+    return (protocol == Protocol::UDP) ? TOP_UDP_PORTS.size() : TOP_TCP_PORTS.size();
+}
+
+// function to get the most common ports of the protocol
+std::vector<int> topPorts(Protocol protocol, size_t count) {
+    if (count > topPortCount(protocol)) {
+        throw std::invalid_argument("Only " + std::to_string(topPortCount(protocol)) + " top ports are known");
+    }
+    const uint16_t *ports = (protocol == Protocol::UDP) ? TOP_UDP_PORTS.data() : TOP_TCP_PORTS.data();
+    return std::vector<int>(ports, ports + count);
+}
@@ -0,0 +1,338 @@
+/**
+ * @file transport.cpp
+ * @brief File for the packet transports (raw sockets, link layer rings)
+ * @author Martin Mendl <x247581>
+ * @date 2025-30-03
+ */
+
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <stdexcept>
+#include <ctime>
+#include <sys/socket.h>
+#include <poll.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#include <arpa/inet.h>
+#include <net/ethernet.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include "transport.hpp"
+#include "ring.hpp"
+#include "xdp.hpp"
+#include "uring.hpp"
+
+// Method to wait for packets, polls the sockets of the transport
+void Transport::wait(int timeoutMs, bool wantSend) {
+    preparePoll(timeoutMs, wantSend);
+    if (poll(pollFds.data(), pollFds.size(), timeoutMs) < 0 && errno != EINTR) {
+        perror("poll failed");
+        throw std::runtime_error("Failed to wait for the replies");
+    }
+}
+
+// Method to add the sockets of the transport to a poll set shared with other transports
+void Transport::addPollFds(std::vector<struct pollfd> &fds, int &timeoutMs, bool wantSend) {
+    preparePoll(timeoutMs, wantSend);
+    fds.insert(fds.end(), pollFds.begin(), pollFds.end());
+}
+
+// Method to set the events of the sockets for the next poll
+void Transport::preparePoll(int &timeoutMs, bool wantSend) {
+    // the sockets do not change during the scan, only the events are set per call
+    if (pollFds.empty()) {
+        for (int sockfd : getSockets()) pollFds.push_back({sockfd, 0, 0});
+    }
+    // a parked packet waits for POLLOUT, or for the pause, if the socket can not tell (ENOBUFS)
+    if (parked > 0) {
+        wantSend = backoffMs == 0;
+        timeoutMs = retryTimeoutMs(timeoutMs);
+    }
+    for (struct pollfd &pfd : pollFds) pfd.events = wantSend ? (POLLIN | POLLOUT) : POLLIN;
+}
+
+// Method to note, that the kernel had no room for a packet, and to set the time of the retry
+void Transport::holdBack(int error) {
+    backpressure++;
+    // a full socket buffer reports POLLOUT, once it drains, a full qdisc or device queue does not
+    backoffMs = (error == ENOBUFS) ? nextBackoffMs(backoffMs) : 0;
+    retryAt = std::chrono::steady_clock::now() + std::chrono::milliseconds(backoffMs);
+}
+
+// Method to shorten the wait to the retry of the parked packets
+int Transport::retryTimeoutMs(int timeoutMs) const {
+    if (parked == 0 || backoffMs == 0) return timeoutMs;
+    auto left = std::chrono::ceil<std::chrono::milliseconds>(retryAt - std::chrono::steady_clock::now()).count();
+    return int(std::max<int64_t>(0, std::min<int64_t>(timeoutMs, left)));
+}
+
+// function to get the time of the clock, the kernel stamps the packets with
+int64_t wallClockNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return int64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+// function to ask the kernel for receive timestamps on the socket
+bool enableTimestamps(int sockfd) {
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    return setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0;
+}
+
+// function to ask the kernel for the drop counter of the socket with every packet
+void enableDropCounter(int sockfd) {
+    int on = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on));
+}
+
+// function to size the receive buffer of the socket for the packets in flight
+void sizeReceiveBuffer(int sockfd, size_t packets) {
+    int size = int(std::min(packets * RCVBUF_PER_PACKET, RCVBUF_MAX));
+    int current = 0;
+    socklen_t len = sizeof(current);
+    // the kernel reports the doubled value, it adds the bookkeeping overhead to the requested one
+    if (getsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &current, &len) == 0 && current / 2 >= size) return;
+
+    if (setsockopt(sockfd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) < 0) {
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));  // capped by net.core.rmem_max
+    }
+}
+
+// function to read the control messages of a received packet
+void readControl(const struct msghdr *msg, int64_t &receivedNs, uint32_t &dropCounter) {
+    receivedNs = 0;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg != nullptr; cmsg = CMSG_NXTHDR((struct msghdr*)msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) continue;
+
+        if (cmsg->cmsg_type == SO_RXQ_OVFL && cmsg->cmsg_len >= CMSG_LEN(sizeof(uint32_t))) {
+            memcpy(&dropCounter, CMSG_DATA(cmsg), sizeof(dropCounter));
+        } else if (cmsg->cmsg_type == SO_TIMESTAMPING && cmsg->cmsg_len >= CMSG_LEN(sizeof(struct scm_timestamping))) {
+            // ts[0] software, in the clock of wallClockNs(), the raw hardware ts[2] is in the clock of the NIC
+            struct scm_timestamping stamps;
+            memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+            receivedNs = int64_t(stamps.ts[0].tv_sec) * 1000000000 + stamps.ts[0].tv_nsec;
+        }
+    }
+}
+
+// Constructor for RawTransport class
+RawTransport::RawTransport(const NetworkInterface &sender, bool tcp, bool udp) {
+    ipv4 = sender.address.ipVer == IpVersion::IPV4;
+
+    // the sockets are not connected, the sender stands in for the receiver
+    if (ipv4) {
+        if (tcp) tcpSocket = new SocketIpv4(sender, sender.address, Protocol::TCP);
+        if (udp) udpSocket = new SocketIpv4(sender, sender.address, Protocol::UDP);
+        icmpSocket = new SocketIpv4(sender, sender.address, Protocol::ICMP);  // errors for both protocols
+    } else {
+        if (tcp) tcpSocket = new SocketIpv6(sender, sender.address, Protocol::TCP);
+        if (udp) udpSocket = new SocketIpv6(sender, sender.address, Protocol::UDP);
+        icmpSocket = new SocketIpv6(sender, sender.address, Protocol::ICMP6);
+    }
+
+    // the kernel stamps the answers, so the round trip time does not include the wake up of the scan
+    for (Socket *socket : {tcpSocket, udpSocket, icmpSocket}) {
+        if (socket == nullptr) continue;
+        socket->setNonBlocking();
+        enableTimestamps(socket->getSocket());
+        enableDropCounter(socket->getSocket());
+    }
+}
+
+// Method to make room for the answers to the probes in flight
+void RawTransport::setReceiveWindow(size_t packets) {
+    for (Socket *socket : {tcpSocket, udpSocket, icmpSocket}) {
+        if (socket != nullptr) sizeReceiveBuffer(socket->getSocket(), packets);
+    }
+}
+
+// Destructor for RawTransport class
+RawTransport::~RawTransport() {
+    if (tcpSocket != nullptr) delete tcpSocket;
+    if (udpSocket != nullptr) delete udpSocket;
+    if (icmpSocket != nullptr) delete icmpSocket;
+}
+
+// Method to get the buffer for the next segment
+char* RawTransport::reserve(size_t *size) {
+    // the send buffer holds the parked packet, until it is out
+    if (parked > 0 && (!retryDue() || !transmit())) return nullptr;
+    *size = sizeof(sendBuffer);
+    return sendBuffer;
+}
+
+// Method to send the segment written to the reserved buffer
+void RawTransport::commit(const struct sockaddr *target, const unsigned char *mac, int protocol, size_t size) {
+    (void)mac;
+    Socket *socket = (protocol == IPPROTO_TCP) ? tcpSocket : udpSocket;
+
+    // the raw IPv6 socket takes the port as the protocol, it has to be 0
+    sendTargetLen = ipv4 ? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6);
+    memcpy(&sendTarget, target, sendTargetLen);
+    if (!ipv4) ((struct sockaddr_in6*)&sendTarget)->sin6_port = 0;
+    sendSocket = socket->getSocket();
+    sendSize = size;
+    transmit();
+}
+
+// Method to send the parked packet, once the pause is over
+void RawTransport::flush() {
+    if (parked > 0 && retryDue()) transmit();
+}
+
+// Method to send the packet in the send buffer, parks it, if the kernel has no room
+bool RawTransport::transmit() {
+    if (sendto(sendSocket, sendBuffer, sendSize, 0, (const struct sockaddr*)&sendTarget, sendTargetLen) >= 0) {
+        parked = 0;
+        backoffMs = 0;
+        return true;
+    }
+    if (!isBackpressure(errno)) {
+        perror("sendto failed");
+        throw std::runtime_error("Failed to send probe");
+    }
+    parked = 1;
+    holdBack(errno);
+    return false;
+}
+
+// Method to get the sockets to poll
+std::vector<int> RawTransport::getSockets() const {
+    std::vector<int> sockets;
+    for (Socket *socket : {tcpSocket, udpSocket, icmpSocket}) {
+        if (socket != nullptr) sockets.push_back(socket->getSocket());
+    }
+    return sockets;
+}
+
+// Method to read all the waiting packets
+void RawTransport::receive(const SegmentCallback &onSegment) {
+    int icmpProtocol = ipv4 ? int(IPPROTO_ICMP) : int(IPPROTO_ICMPV6);
+    std::pair<Socket*, int> sockets[] = {{tcpSocket, IPPROTO_TCP}, {udpSocket, IPPROTO_UDP}, {icmpSocket, icmpProtocol}};
+
+    for (size_t i = 0; i < 3; i++) {
+        auto [socket, protocol] = sockets[i];
+        if (socket == nullptr) continue;
+
+        while (true) {
+            // recvmsg instead of recvfrom, the kernel timestamp and the drop counter come with the packet
+            struct sockaddr_storage from;
+            struct iovec iov = {readBuffer, sizeof(readBuffer)};
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_name = &from;
+            msg.msg_namelen = sizeof(from);
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = controlBuffer;
+            msg.msg_controllen = sizeof(controlBuffer);
+            ssize_t recvLen = recvmsg(socket->getSocket(), &msg, 0);
+            if (recvLen <= 0) break;  // socket drained
+
+            int64_t receivedNs;
+            uint32_t dropCounter = dropCounters[i];
+            readControl(&msg, receivedNs, dropCounter);
+            countDrops(dropCounters[i], dropCounter);
+            deliver(protocol, from, readBuffer, recvLen, receivedNs ? receivedNs : wallClockNs(), onSegment);
+        }
+    }
+}
+
+// Method to pass a packet from a raw socket on as a segment
+void RawTransport::deliver(int protocol, const struct sockaddr_storage &source, const char *packet, size_t size, int64_t receivedNs, const SegmentCallback &onSegment) const {
+    // raw IPv6 sockets deliver only the payload
+    if (!ipv4) {
+        onSegment(AF_INET6, &((const struct sockaddr_in6*)&source)->sin6_addr, protocol, packet, size, receivedNs);
+        return;
+    }
+
+    // raw IPv4 sockets deliver the IP header
+    const struct iphdr *ipHeader = (const struct iphdr*)packet;
+    size_t headerLen = ipHeader->ihl * 4;
+    if (size < sizeof(struct iphdr) || size < headerLen) return;
+    onSegment(AF_INET, &ipHeader->saddr, ipHeader->protocol, packet + headerLen, size - headerLen, receivedNs);
+}
+
+// Constructor for LinkTransport class
+LinkTransport::LinkTransport(const NetworkAdress &sender, const LinkInfo &link) {
+    this->sender = sender;
+    this->link = link;
+    ipv4 = sender.ipVer == IpVersion::IPV4;
+
+    if (!sender.valid) {
+        throw std::runtime_error("Invalid sender IP address");
+    }
+    toSockaddr(sender, senderAddr4);
+    toSockaddr(sender, senderAddr6);
+}
+
+// Method to resolve the link layer address of the target
+void LinkTransport::resolve(const NetworkAdress &target, unsigned char mac[6]) {
+    resolveNextHopMac(link, target, mac);
+}
+
+// Method to get the buffer for the next segment
+char* LinkTransport::reserve(size_t *size) {
+    size_t frameSize;
+    reservedFrame = nextFrame(&frameSize);
+    if (reservedFrame == nullptr) return nullptr;
+
+    // the segment goes behind the Ethernet and IP headers
+    size_t headers = sizeof(struct ether_header) + (ipv4 ? sizeof(struct iphdr) : sizeof(struct ip6_hdr));
+    *size = frameSize - headers;
+    return reservedFrame + headers;
+}
+
+// Method to send the segment written to the reserved buffer
+void LinkTransport::commit(const struct sockaddr *target, const unsigned char *mac, int protocol, size_t size) {
+    struct ether_header *eth = (struct ether_header*)reservedFrame;
+    memcpy(eth->ether_dhost, mac, ETH_ALEN);
+
+    char *ipHeader = reservedFrame + sizeof(struct ether_header);
+    size_t ipLen = ipv4 ?
+        Ipv4::buildIpHeader(ipHeader, senderAddr4, *(const struct sockaddr_in*)target, protocol, size) :
+        Ipv6::buildIpHeader(ipHeader, senderAddr6, *(const struct sockaddr_in6*)target, protocol, size);
+    commitFrame(sizeof(struct ether_header) + ipLen + size);
+}
+
+// Method to write the constant part of the Ethernet header
+void LinkTransport::fillTemplate(char *frame) const {
+    static const unsigned char unknown[ETH_ALEN] = {0};
+    buildEthernetHeader(frame, unknown, link.mac, ipv4 ? ETHERTYPE_IP : ETHERTYPE_IPV6);
+}
+
+// Method to parse a received frame down to the segment
+void LinkTransport::handleFrame(const char *frame, size_t size, int64_t receivedNs, const SegmentCallback &onSegment) const {
+    if (size < sizeof(struct ether_header)) return;
+    const struct ether_header *eth = (const struct ether_header*)frame;
+    const char *packet = frame + sizeof(struct ether_header);
+    size -= sizeof(struct ether_header);
+
+    if (ntohs(eth->ether_type) == ETHERTYPE_IP && ipv4) {
+        if (size < sizeof(struct iphdr)) return;
+        const struct iphdr *ipHeader = (const struct iphdr*)packet;
+        size_t headerLen = ipHeader->ihl * 4;
+        size_t totalLen = std::min(size_t(ntohs(ipHeader->tot_len)), size);
+        if (totalLen < headerLen) return;
+        onSegment(AF_INET, &ipHeader->saddr, ipHeader->protocol, packet + headerLen, totalLen - headerLen, receivedNs);
+    } else if (ntohs(eth->ether_type) == ETHERTYPE_IPV6 && !ipv4) {
+        if (size < sizeof(struct ip6_hdr)) return;
+        const struct ip6_hdr *ipHeader = (const struct ip6_hdr*)packet;
+        size_t payloadLen = std::min(size_t(ntohs(ipHeader->ip6_plen)), size - sizeof(struct ip6_hdr));
+        onSegment(AF_INET6, &ipHeader->ip6_src, ipHeader->ip6_nxt, packet + sizeof(struct ip6_hdr), payloadLen, receivedNs);
+    }
+}
+
+// Function to create the transport for the backend
+Transport* createTransport(Backend backend, const NetworkInterface &sender, bool tcp, bool udp) {
+    if (backend == Backend::RAW) return new RawTransport(sender, tcp, udp);
+    if (backend == Backend::IO_URING) return new UringTransport(sender, tcp, udp);
+
+    // frames injected into the loopback do not reach the local stack
+    LinkInfo link = getLinkInfo(sender.name);
+    if (link.loopback) return new RawTransport(sender, tcp, udp);
+
+    if (backend == Backend::XDP) return new XdpSocket(sender.address, link);
+    return new PacketRing(sender.address, link);
+}
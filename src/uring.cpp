@@ -0,0 +1,398 @@
+/**
+ * @file uring.cpp
+ * @brief File for the io_uring transport (raw sockets driven by a submission ring)
+ * @author Martin Mendl <x247581>
+ * @date 2025-01-04
+ */
+
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include "uring.hpp"
+
+// the kind of the completion is kept in the upper half of the user data
+const uint64_t URING_TAG_SEND = 1ULL << 32;
+const uint64_t URING_TAG_RECV = 2ULL << 32;
+const uint64_t URING_TAG_WAIT = 3ULL << 32;
+const uint64_t URING_TAG_MASK = 0xffffffffULL << 32;
+
+// Constructor for UringTransport class
+UringTransport::UringTransport(const NetworkInterface &sender, bool tcp, bool udp) : RawTransport(sender, tcp, udp) {
+    try {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = URING_CQ_ENTRIES;
+        ringfd = syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+        if (ringfd < 0) {
+            perror("io_uring_setup failed");
+            throw std::runtime_error("Failed to set up io_uring");
+        }
+
+        // the rings, newer kernels map both with a single mmap
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringfd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            sqRing = nullptr;
+            throw std::runtime_error("Failed to map the io_uring submission ring");
+        }
+        cqRing = sqRing;
+        if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+            cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringfd, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) {
+                cqRing = nullptr;
+                throw std::runtime_error("Failed to map the io_uring completion ring");
+            }
+        }
+
+        sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+        void *mapping = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringfd, IORING_OFF_SQES);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("Failed to map the io_uring submission entries");
+        }
+        sqes = (struct io_uring_sqe*)mapping;
+
+        sqHead = (uint32_t*)((char*)sqRing + params.sq_off.head);
+        sqTail = (uint32_t*)((char*)sqRing + params.sq_off.tail);
+        sqArray = (uint32_t*)((char*)sqRing + params.sq_off.array);
+        sqEntries = params.sq_entries;
+        sqLocalTail = *sqTail;
+        cqHead = (uint32_t*)((char*)cqRing + params.cq_off.head);
+        cqTail = (uint32_t*)((char*)cqRing + params.cq_off.tail);
+        cqes = (struct io_uring_cqe*)((char*)cqRing + params.cq_off.cqes);
+        cqEntries = params.cq_entries;
+
+        for (unsigned i = 0; i < URING_SEND_SLOTS; i++) {
+            SendSlot *slot = new SendSlot;
+            slot->index = i;
+            sendSlots.push_back(slot);
+            freeSlots.push_back(slot);
+        }
+        retrySlots.reserve(URING_SEND_SLOTS);
+
+        // a receive is posted on every socket, blocking sockets let io_uring wait for the data
+        multishot = registerBuffers();
+        int icmpProtocol = ipv4 ? int(IPPROTO_ICMP) : int(IPPROTO_ICMPV6);
+        std::pair<Socket*, int> sockets[] = {{tcpSocket, IPPROTO_TCP}, {udpSocket, IPPROTO_UDP}, {icmpSocket, icmpProtocol}};
+        for (auto [socket, protocol] : sockets) {
+            if (socket == nullptr) continue;
+            int flags = fcntl(socket->getSocket(), F_GETFL, 0);
+            fcntl(socket->getSocket(), F_SETFL, flags & ~O_NONBLOCK);
+
+            RecvSlot *slot = new RecvSlot;
+            slot->sockfd = socket->getSocket();
+            slot->protocol = protocol;
+            recvSlots.push_back(slot);
+            armReceive(recvSlots.size() - 1);
+        }
+        submit(0);
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+// Destructor for UringTransport class
+UringTransport::~UringTransport() {
+    release();
+}
+
+// Method to close the ring and free the buffers
+void UringTransport::release() {
+    // closing the ring cancels the posted receives
+    if (sqes != nullptr) munmap(sqes, sqesSize);
+    if (cqRing != nullptr && cqRing != sqRing) munmap(cqRing, cqRingSize);
+    if (sqRing != nullptr) munmap(sqRing, sqRingSize);
+    if (ringfd >= 0) close(ringfd);
+    sqes = nullptr;
+    sqRing = cqRing = nullptr;
+    ringfd = -1;
+
+    if (bufRing != nullptr) munmap(bufRing, bufRingSize);
+    bufRing = nullptr;
+    delete[] recvBuffers;
+    recvBuffers = nullptr;
+
+    for (SendSlot *slot : sendSlots) delete slot;
+    for (RecvSlot *slot : recvSlots) delete slot;
+    sendSlots.clear();
+    freeSlots.clear();
+    retrySlots.clear();
+    recvSlots.clear();
+}
+
+// Method to register the provided buffer ring
+bool UringTransport::registerBuffers() {
+    bufRingSize = URING_RECV_BUFFERS * sizeof(struct io_uring_buf);
+    void *mapping = mmap(nullptr, bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) return false;
+    bufRing = (struct io_uring_buf_ring*)mapping;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)bufRing;
+    reg.ring_entries = URING_RECV_BUFFERS;
+    reg.bgid = URING_BUFFER_GROUP;
+    if (syscall(__NR_io_uring_register, ringfd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        munmap(bufRing, bufRingSize);
+        bufRing = nullptr;
+        return false;
+    }
+
+    recvBuffers = new char[size_t(URING_RECV_BUFFERS) * URING_RECV_BUFFER_SIZE];
+    for (unsigned bid = 0; bid < URING_RECV_BUFFERS; bid++) recycleBuffer(bid);
+    return true;
+}
+
+// Method to give a receive buffer back to the kernel
+void UringTransport::recycleBuffer(uint16_t bid) {
+    // the flexible array of the header is shifted in C++, the entries start at the ring itself
+    uint16_t tail = bufRing->tail;
+    struct io_uring_buf *buf = (struct io_uring_buf*)bufRing + (tail & (URING_RECV_BUFFERS - 1));
+    buf->addr = (uint64_t)(recvBuffers + size_t(bid) * URING_RECV_BUFFER_SIZE);
+    buf->len = URING_RECV_BUFFER_SIZE;
+    buf->bid = bid;
+    __atomic_store_n(&bufRing->tail, uint16_t(tail + 1), __ATOMIC_RELEASE);
+}
+
+// Method to get a free submission queue entry
+struct io_uring_sqe* UringTransport::getSqe() {
+    if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) submit(0);
+    if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+        throw std::runtime_error("io_uring submission queue is full");
+    }
+
+    uint32_t index = sqLocalTail & (sqEntries - 1);
+    struct io_uring_sqe *sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqArray[index] = index;
+    sqLocalTail++;
+    toSubmit++;
+    return sqe;
+}
+
+// Method to submit the queued entries
+void UringTransport::submit(unsigned waitFor) {
+    __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+    if (toSubmit == 0 && waitFor == 0) return;
+
+    int ret = syscall(__NR_io_uring_enter, ringfd, toSubmit, waitFor, waitFor ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+    if (ret < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN) {
+        perror("io_uring_enter failed");
+        throw std::runtime_error("Failed to submit to io_uring");
+    }
+    if (ret > 0) toSubmit -= std::min(unsigned(ret), toSubmit);
+}
+
+// Method to post the receive on a socket
+void UringTransport::armReceive(size_t index) {
+    RecvSlot *slot = recvSlots[index];
+    struct io_uring_sqe *sqe = getSqe();
+    memset(&slot->msg, 0, sizeof(slot->msg));
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = slot->sockfd;
+    sqe->addr = (uint64_t)&slot->msg;
+    sqe->len = 1;
+    sqe->user_data = URING_TAG_RECV | index;
+
+    if (multishot) {
+        // the kernel lays the address, the timestamp and the payload out in the provided buffer
+        slot->msg.msg_namelen = sizeof(struct sockaddr_storage);
+        slot->msg.msg_controllen = TIMESTAMP_CONTROL_LEN;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = URING_BUFFER_GROUP;
+    } else {
+        slot->iov.iov_base = slot->buffer;
+        slot->iov.iov_len = sizeof(slot->buffer);
+        slot->msg.msg_name = &slot->source;
+        slot->msg.msg_namelen = sizeof(slot->source);
+        slot->msg.msg_iov = &slot->iov;
+        slot->msg.msg_iovlen = 1;
+        memset(slot->control, 0, sizeof(slot->control));
+        slot->msg.msg_control = slot->control;
+        slot->msg.msg_controllen = sizeof(slot->control);
+    }
+    slot->armed = true;
+}
+
+// Method to get the buffer for the next segment
+char* UringTransport::reserve(size_t *size) {
+    if (freeSlots.empty() || parked > 0) return nullptr;  // all slots wait for their completion, or the kernel has no room
+
+    reservedSlot = freeSlots.back();
+    freeSlots.pop_back();
+    *size = sizeof(reservedSlot->buffer);
+    return reservedSlot->buffer;
+}
+
+// Method to queue the segment written to the reserved buffer
+void UringTransport::commit(const struct sockaddr *target, const unsigned char *mac, int protocol, size_t size) {
+    (void)mac;
+    SendSlot *slot = reservedSlot;
+    Socket *socket = (protocol == IPPROTO_TCP) ? tcpSocket : udpSocket;
+
+    // the raw IPv6 socket takes the port as the protocol, it has to be 0
+    socklen_t targetLen = ipv4 ? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6);
+    memcpy(&slot->target, target, targetLen);
+    if (!ipv4) ((struct sockaddr_in6*)&slot->target)->sin6_port = 0;
+
+    slot->iov.iov_base = slot->buffer;
+    slot->iov.iov_len = size;
+    memset(&slot->msg, 0, sizeof(slot->msg));
+    slot->msg.msg_name = &slot->target;
+    slot->msg.msg_namelen = targetLen;
+    slot->msg.msg_iov = &slot->iov;
+    slot->msg.msg_iovlen = 1;
+    slot->sockfd = socket->getSocket();
+    queueSend(slot);
+}
+
+// Method to queue the sendmsg of the slot
+void UringTransport::queueSend(SendSlot *slot) {
+    struct io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = slot->sockfd;
+    sqe->addr = (uint64_t)&slot->msg;
+    sqe->len = 1;
+    sqe->user_data = URING_TAG_SEND | slot->index;
+}
+
+// Method to submit the queued probes
+void UringTransport::flush() {
+    // the parked sends go out again, once the pause is over
+    if (parked > 0 && retryDue()) {
+        for (SendSlot *slot : retrySlots) queueSend(slot);
+        retrySlots.clear();
+        parked = 0;
+    }
+    submit(0);
+}
+
+// Method to wait for a completion, or the timeout
+void UringTransport::wait(int timeoutMs, bool wantSend) {
+    (void)wantSend;  // a returned send slot is a completion as well
+    timeoutMs = retryTimeoutMs(timeoutMs);
+
+    if (__atomic_load_n(cqTail, __ATOMIC_ACQUIRE) != *cqHead || timeoutMs <= 0) {
+        submit(0);
+        return;
+    }
+
+    // the timeout completes with the first other completion, or after the time
+    waitTimeout.tv_sec = timeoutMs / 1000;
+    waitTimeout.tv_nsec = (long long)(timeoutMs % 1000) * 1000000;
+    struct io_uring_sqe *sqe = getSqe();
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->addr = (uint64_t)&waitTimeout;
+    sqe->len = 1;
+    sqe->off = 1;
+    sqe->user_data = URING_TAG_WAIT;
+    submit(1);
+}
+
+// Method to add the ring to a poll set shared with other transports
+void UringTransport::addPollFds(std::vector<struct pollfd> &fds, int &timeoutMs, bool wantSend) {
+    (void)wantSend;  // a returned send slot is a completion as well
+
+    // the ring is readable, while there are completions
+    submit(0);
+    if (__atomic_load_n(cqTail, __ATOMIC_ACQUIRE) != *cqHead) timeoutMs = 0;
+    timeoutMs = retryTimeoutMs(timeoutMs);
+    fds.push_back({ringfd, POLLIN, 0});
+}
+
+// Method to handle all the completions
+void UringTransport::receive(const SegmentCallback &onSegment) {
+    uint32_t head = *cqHead;
+    uint32_t tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++) {
+        const struct io_uring_cqe *cqe = &cqes[head & (cqEntries - 1)];
+        uint64_t tag = cqe->user_data & URING_TAG_MASK;
+        uint32_t index = cqe->user_data & ~URING_TAG_MASK;
+
+        if (tag == URING_TAG_SEND) {
+            // the kernel had no room, the slot keeps the probe for the retry
+            if (cqe->res < 0 && isBackpressure(-cqe->res)) {
+                // one pause per batch, io_uring polls a full socket buffer itself, so this is a full queue
+                if (retrySlots.empty()) holdBack(ENOBUFS);
+                else backpressure++;
+                retrySlots.push_back(sendSlots[index]);
+                parked = retrySlots.size();
+                continue;
+            }
+            freeSlots.push_back(sendSlots[index]);
+            if (cqe->res < 0) {
+                errno = -cqe->res;
+                perror("sendmsg failed");
+                throw std::runtime_error("Failed to send probe");
+            }
+            if (parked == 0) backoffMs = 0;
+            continue;
+        }
+        if (tag != URING_TAG_RECV) continue;  // the wait timeout
+
+        // a multishot receive ends without the MORE flag (no buffers left, error)
+        RecvSlot *slot = recvSlots[index];
+        if (!(cqe->flags & IORING_CQE_F_MORE)) slot->armed = false;
+        if (cqe->res == -EINVAL && multishot) {
+            multishot = false;  // the kernel has no multishot receive
+            continue;
+        }
+        if (cqe->res < 0 && cqe->res != -ENOBUFS && cqe->res != -EINTR && cqe->res != -EAGAIN) {
+            errno = -cqe->res;
+            perror("recvmsg failed");
+            throw std::runtime_error("Failed to receive");
+        }
+
+        if (!(cqe->flags & IORING_CQE_F_BUFFER)) {
+            int64_t receivedNs;
+            uint32_t dropCounter = slot->dropCounter;
+            readControl(&slot->msg, receivedNs, dropCounter);
+            countDrops(slot->dropCounter, dropCounter);
+            if (cqe->res > 0) deliver(slot->protocol, slot->source, slot->buffer, cqe->res, receivedNs ? receivedNs : wallClockNs(), onSegment);
+            continue;
+        }
+
+        // provided buffer: header, address, control data, payload
+        uint16_t bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+        const char *buffer = recvBuffers + size_t(bid) * URING_RECV_BUFFER_SIZE;
+        const struct io_uring_recvmsg_out *out = (const struct io_uring_recvmsg_out*)buffer;
+        size_t offset = sizeof(*out) + slot->msg.msg_namelen + slot->msg.msg_controllen;
+        size_t payloadLen = std::min(size_t(out->payloadlen), URING_RECV_BUFFER_SIZE - offset);
+
+        if (cqe->res > 0) {
+            struct sockaddr_storage source;
+            memset(&source, 0, sizeof(source));
+            memcpy(&source, buffer + sizeof(*out), std::min(size_t(out->namelen), sizeof(source)));
+
+            // the control messages follow the address, a msghdr over them lets the CMSG macros walk them
+            struct msghdr control;
+            memset(&control, 0, sizeof(control));
+            control.msg_control = (void*)(buffer + sizeof(*out) + slot->msg.msg_namelen);
+            control.msg_controllen = std::min(size_t(out->controllen), size_t(slot->msg.msg_controllen));
+            int64_t receivedNs;
+            uint32_t dropCounter = slot->dropCounter;
+            readControl(&control, receivedNs, dropCounter);
+            countDrops(slot->dropCounter, dropCounter);
+            deliver(slot->protocol, source, buffer + offset, payloadLen, receivedNs ? receivedNs : wallClockNs(), onSegment);
+        }
+        recycleBuffer(bid);
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+    for (size_t i = 0; i < recvSlots.size(); i++) {
+        if (!recvSlots[i]->armed) armReceive(i);
+    }
+}
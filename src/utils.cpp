@@ -13,8 +13,25 @@
 #include <netinet/in.h>
 #include <unordered_set>
 #include <stdexcept>
+#include <functional>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <regex>
+#include <charconv>
+#include <limits>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/neighbour.h>
 #include "utils.hpp"
 
+const int NEIGHBOUR_RETRIES = 20;       // attempts to find the neighbour entry
+const int NEIGHBOUR_WAIT_MS = 50;       // wait between the attempts
+
 // function for header checksums
 unsigned short checkSum(const char *buf, unsigned size) {
     unsigned sum = 0, i;
@@ -27,11 +44,106 @@ unsigned short checkSum(const char *buf, unsigned size) {
     return ~sum;
 }
 
+// function to calc the checksum over two buffers, without copying them together
+unsigned short checkSum(const char *head, unsigned headSize, const char *buf, unsigned size) {
+    unsigned sum = 0, i;
+    uint16_t word;
+    for (i = 0; i + 1 < headSize; i += 2) {
+        memcpy(&word, head + i, sizeof(word));
+        sum += word;
+    }
+    for (i = 0; i + 1 < size; i += 2) {
+        memcpy(&word, buf + i, sizeof(word));
+        sum += word;
+    }
+
+    if (size & 1) sum += (unsigned char) buf[i];
+    while (sum >> 16) sum = (sum & 0xFFFF)+(sum >> 16);
+    return ~sum;
+}
+
+// function to build the network address from its binary form
+NetworkAdress makeAddress(int family, const void *addr, uint16_t port) {
+    NetworkAdress address;
+    memset(&address, 0, sizeof(address));
+    address.ipVer = (family == AF_INET) ? IpVersion::IPV4 : IpVersion::IPV6;
+    memcpy(address.addr, addr, (family == AF_INET) ? sizeof(struct in_addr) : sizeof(struct in6_addr));
+    address.port = port;
+    address.valid = true;
+    return address;
+}
+
+// function to parse the textual IPv4 or IPv6 address
+bool parseAddress(const std::string &text, NetworkAdress &address) {
+    unsigned char addr[sizeof(struct in6_addr)];
+
+    if (inet_pton(AF_INET, text.c_str(), addr) == 1) {
+        address = makeAddress(AF_INET, addr, 0);
+        return true;
+    }
+    if (inet_pton(AF_INET6, text.c_str(), addr) == 1) {
+        address = makeAddress(AF_INET6, addr, 0);
+        return true;
+    }
+    return false;
+}
+
+// function to convert the network address to text
+std::string toString(const NetworkAdress &address) {
+    char text[INET6_ADDRSTRLEN];
+    return toString(address, text, sizeof(text));
+}
+
+// function to convert the network address to text in the given buffer
+const char* toString(const NetworkAdress &address, char *text, size_t size) {
+    if (size == 0) return "";
+    text[0] = '\0';
+    if (!address.valid) return text;
+
+    int family = (address.ipVer == IpVersion::IPV4) ? AF_INET : AF_INET6;
+    if (inet_ntop(family, address.addr, text, size) == nullptr) text[0] = '\0';
+    return text;
+}
+
+// function to compare the addresses of two network addresses
+bool sameAddress(const NetworkAdress &a, const NetworkAdress &b) {
+    size_t len = (a.ipVer == IpVersion::IPV4) ? sizeof(struct in_addr) : sizeof(struct in6_addr);
+    return a.valid == b.valid && a.ipVer == b.ipVer && memcmp(a.addr, b.addr, len) == 0;
+}
+
+// function to check, if the address is a loopback address
+bool isLoopback(const NetworkAdress &address) {
+    if (!address.valid) return false;
+    if (address.ipVer == IpVersion::IPV4) return address.addr[0] == 127;
+    return IN6_IS_ADDR_LOOPBACK((const struct in6_addr*)address.addr);
+}
+
+// Function to parse a whole number in the range
+bool parseNumber(const std::string &text, int min, int max, int &value) {
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc() && end == text.data() + text.size() && value >= min && value <= max;
+}
+
+// function to fill the IPv4 socket address
+void toSockaddr(const NetworkAdress &address, struct sockaddr_in &sockAddr) {
+    memset(&sockAddr, 0, sizeof(sockAddr));
+    sockAddr.sin_family = AF_INET;
+    sockAddr.sin_port = htons(address.port);
+    memcpy(&sockAddr.sin_addr, address.addr, sizeof(sockAddr.sin_addr));
+}
+
+// function to fill the IPv6 socket address
+void toSockaddr(const NetworkAdress &address, struct sockaddr_in6 &sockAddr) {
+    memset(&sockAddr, 0, sizeof(sockAddr));
+    sockAddr.sin6_family = AF_INET6;
+    sockAddr.sin6_port = htons(address.port);
+    memcpy(&sockAddr.sin6_addr, address.addr, sizeof(sockAddr.sin6_addr));
+}
+
 // function returning the available network interfaces
-std::vector<NetworkAdress> getNetworkInterfaces() {
-    std::vector<NetworkAdress> interfaces;
+std::vector<NetworkInterface> getNetworkInterfaces() {
+    std::vector<NetworkInterface> interfaces;
     struct ifaddrs *ifaddr, *ifa;
-    char addr[INET6_ADDRSTRLEN];
 
     if (getifaddrs(&ifaddr) == -1) {
         perror("getifaddrs");
@@ -41,24 +153,16 @@ std::vector<NetworkAdress> getNetworkInterfaces() {
     for (ifa = ifaddr; ifa != nullptr; ifa = ifa->ifa_next) {
         if (ifa->ifa_addr == nullptr) continue;
 
-        NetworkAdress netAddr;
-        netAddr.hostName = ifa->ifa_name;
-        netAddr.port = -1; // deefault value, not used
-
         void *addr_ptr = nullptr;
         if (ifa->ifa_addr->sa_family == AF_INET) { // IPv4
             addr_ptr = &((struct sockaddr_in *)ifa->ifa_addr)->sin_addr;
-            netAddr.ipVer = IpVersion::IPV4;
         } else if (ifa->ifa_addr->sa_family == AF_INET6) { // IPv6
             addr_ptr = &((struct sockaddr_in6 *)ifa->ifa_addr)->sin6_addr;
-            netAddr.ipVer =  IpVersion::IPV6;
         } else {
             continue;
         }
 
-        inet_ntop(ifa->ifa_addr->sa_family, addr_ptr, addr, sizeof(addr));
-        netAddr.ip = addr;
-        interfaces.push_back(netAddr);
+        interfaces.push_back({ifa->ifa_name, makeAddress(ifa->ifa_addr->sa_family, addr_ptr, 0)});
     }
 
     freeifaddrs(ifaddr);
@@ -67,31 +171,288 @@ std::vector<NetworkAdress> getNetworkInterfaces() {
 }
 
 // function to represent the available network interfaces
-void representInterfaces(std::vector<NetworkAdress> interfaces) {
+void representInterfaces(const std::vector<NetworkInterface> &interfaces) {
 
     std::unordered_set<std::string> printedInterfaces;
 
-    for (const NetworkAdress& interface : interfaces) {
-        if (printedInterfaces.find(interface.hostName) == printedInterfaces.end()) {
-            printedInterfaces.insert(interface.hostName);
-            std::cout << "Interface: " << interface.hostName << std::endl;
+    for (const NetworkInterface& interface : interfaces) {
+        if (printedInterfaces.find(interface.name) == printedInterfaces.end()) {
+            printedInterfaces.insert(interface.name);
+            std::cout << "Interface: " << interface.name << std::endl;
         }
     }
 }   
 
 // function to validate the network interface by name form the accepted interfaces
-NetworkAdress validateInterface(std::vector<NetworkAdress>& interfaces, const std::string& interface_name, bool ipv4) {
+NetworkInterface validateInterface(std::vector<NetworkInterface>& interfaces, const std::string& interface_name, bool ipv4) {
 
     IpVersion ipVer = ipv4 ? IpVersion::IPV4 : IpVersion::IPV6;
     bool found = false;
 
     for (auto& interface : interfaces) {
-        if (interface.hostName == interface_name) {
+        if (interface.name == interface_name) {
             found = true;
-            if (interface.ipVer == ipVer) return interface;
+            if (interface.address.ipVer == ipVer) return interface;
         }
     }
 
-    if (found) return NetworkAdress{"", "", ipVer, -1}; // return empty address if found but not matching version
+    // return empty address if found but not matching version
+    if (found) {
+        NetworkInterface empty = {interface_name, NetworkAdress()};
+        empty.address.ipVer = ipVer;
+        return empty;
+    }
     throw std::runtime_error("Invalid network interface name");
-}
\ No newline at end of file
+}
+
+// function to get the link layer information of the interface
+LinkInfo getLinkInfo(const std::string &interfaceName) {
+    LinkInfo link;
+    struct ifreq ifr;
+    memset(&link, 0, sizeof(link));
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, interfaceName.c_str(), IFNAMSIZ - 1);
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sockfd < 0) {
+        throw std::runtime_error("Failed to create socket");
+    }
+
+    if (ioctl(sockfd, SIOCGIFINDEX, &ifr) < 0) {
+        close(sockfd);
+        throw std::runtime_error("Failed to get the interface index");
+    }
+    link.ifindex = ifr.ifr_ifindex;
+
+    if (ioctl(sockfd, SIOCGIFHWADDR, &ifr) < 0) {
+        close(sockfd);
+        throw std::runtime_error("Failed to get the interface hardware address");
+    }
+    close(sockfd);
+
+    // the frames are built with an Ethernet header, loopback uses one with zero addresses
+    if (ifr.ifr_hwaddr.sa_family != ARPHRD_ETHER && ifr.ifr_hwaddr.sa_family != ARPHRD_LOOPBACK) {
+        throw std::runtime_error("Interface does not use Ethernet framing");
+    }
+    link.loopback = ifr.ifr_hwaddr.sa_family == ARPHRD_LOOPBACK;
+    memcpy(link.mac, ifr.ifr_hwaddr.sa_data, sizeof(link.mac));
+    return link;
+}
+
+// function to send a netlink request and pass every answer to the callback
+static void netlinkRequest(const struct nlmsghdr *request, const std::function<void(const struct nlmsghdr*)> &onMessage) {
+    int sockfd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (sockfd < 0) {
+        throw std::runtime_error("Failed to create netlink socket");
+    }
+
+    if (send(sockfd, request, request->nlmsg_len, 0) < 0) {
+        close(sockfd);
+        throw std::runtime_error("Failed to send netlink request");
+    }
+
+    char buffer[16384];
+    bool done = false;
+    while (!done) {
+        ssize_t len = recv(sockfd, buffer, sizeof(buffer), 0);
+        if (len <= 0) break;
+
+        for (struct nlmsghdr *msg = (struct nlmsghdr*)buffer; NLMSG_OK(msg, len); msg = NLMSG_NEXT(msg, len)) {
+            if (msg->nlmsg_type == NLMSG_DONE || msg->nlmsg_type == NLMSG_ERROR) {
+                done = true;
+                break;
+            }
+            onMessage(msg);
+            // a single answer, not a dump
+            if (!(msg->nlmsg_flags & NLM_F_MULTI)) done = true;
+        }
+    }
+    close(sockfd);
+}
+
+// function to append a netlink attribute to the request
+static void addAttribute(struct nlmsghdr *msg, int type, const void *data, size_t len) {
+    struct rtattr *attr = (struct rtattr*)((char*)msg + NLMSG_ALIGN(msg->nlmsg_len));
+    attr->rta_type = type;
+    attr->rta_len = RTA_LENGTH(len);
+    memcpy(RTA_DATA(attr), data, len);
+    msg->nlmsg_len = NLMSG_ALIGN(msg->nlmsg_len) + RTA_ALIGN(attr->rta_len);
+}
+
+// function to look up the neighbour entry of the address
+static bool findNeighbour(const LinkInfo &link, int family, const unsigned char *addr, size_t addrLen, unsigned char mac[6]) {
+    struct {
+        struct nlmsghdr header;
+        struct ndmsg neighbour;
+    } request;
+    memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(struct ndmsg));
+    request.header.nlmsg_type = RTM_GETNEIGH;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.neighbour.ndm_family = family;
+
+    bool found = false;
+    netlinkRequest(&request.header, [&](const struct nlmsghdr *msg) {
+        if (found || msg->nlmsg_type != RTM_NEWNEIGH) return;
+        const struct ndmsg *neighbour = (const struct ndmsg*)NLMSG_DATA(msg);
+        if (neighbour->ndm_ifindex != link.ifindex) return;
+        if (neighbour->ndm_state & (NUD_INCOMPLETE | NUD_FAILED)) return;
+
+        const unsigned char *dst = nullptr;
+        const unsigned char *lladdr = nullptr;
+        int len = RTM_PAYLOAD(msg);
+        for (const struct rtattr *attr = RTM_RTA(neighbour); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+            if (attr->rta_type == NDA_DST && RTA_PAYLOAD(attr) == addrLen) dst = (const unsigned char*)RTA_DATA(attr);
+            if (attr->rta_type == NDA_LLADDR && RTA_PAYLOAD(attr) == 6) lladdr = (const unsigned char*)RTA_DATA(attr);
+        }
+
+        if (dst == nullptr || lladdr == nullptr || memcmp(dst, addr, addrLen) != 0) return;
+        memcpy(mac, lladdr, 6);
+        found = true;
+    });
+    return found;
+}
+
+// function to resolve the MAC address of the next hop towards the target
+void resolveNextHopMac(const LinkInfo &link, const NetworkAdress &target, unsigned char mac[6]) {
+    memset(mac, 0, 6);
+    if (link.loopback) return;
+
+    int family = (target.ipVer == IpVersion::IPV4) ? AF_INET : AF_INET6;
+    size_t addrLen = (target.ipVer == IpVersion::IPV4) ? 4 : 16;
+    unsigned char nextHop[16];
+    memcpy(nextHop, target.addr, addrLen);
+
+    // ask for the route, the next hop is the gateway, or the target itself
+    struct {
+        struct nlmsghdr header;
+        struct rtmsg route;
+        char attributes[64];
+    } request;
+    memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+    request.header.nlmsg_type = RTM_GETROUTE;
+    request.header.nlmsg_flags = NLM_F_REQUEST;
+    request.route.rtm_family = family;
+    request.route.rtm_dst_len = addrLen * 8;
+    addAttribute(&request.header, RTA_DST, nextHop, addrLen);
+    addAttribute(&request.header, RTA_OIF, &link.ifindex, sizeof(link.ifindex));
+
+    netlinkRequest(&request.header, [&](const struct nlmsghdr *msg) {
+        if (msg->nlmsg_type != RTM_NEWROUTE) return;
+        const struct rtmsg *route = (const struct rtmsg*)NLMSG_DATA(msg);
+        int len = RTM_PAYLOAD(msg);
+        for (const struct rtattr *attr = RTM_RTA(route); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+            if (attr->rta_type == RTA_GATEWAY && RTA_PAYLOAD(attr) == addrLen) memcpy(nextHop, RTA_DATA(attr), addrLen);
+        }
+    });
+
+    if (findNeighbour(link, family, nextHop, addrLen, mac)) return;
+
+    // no entry yet, let the kernel resolve it by sending a datagram to the discard port
+    int sockfd = socket(family, SOCK_DGRAM, 0);
+    if (sockfd >= 0) {
+        struct sockaddr_storage dst;
+        memset(&dst, 0, sizeof(dst));
+        socklen_t dstLen;
+        if (family == AF_INET) {
+            struct sockaddr_in *in = (struct sockaddr_in*)&dst;
+            in->sin_family = AF_INET;
+            in->sin_port = htons(9);
+            memcpy(&in->sin_addr, nextHop, addrLen);
+            dstLen = sizeof(struct sockaddr_in);
+        } else {
+            struct sockaddr_in6 *in6 = (struct sockaddr_in6*)&dst;
+            in6->sin6_family = AF_INET6;
+            in6->sin6_port = htons(9);
+            in6->sin6_scope_id = link.ifindex;
+            memcpy(&in6->sin6_addr, nextHop, addrLen);
+            dstLen = sizeof(struct sockaddr_in6);
+        }
+        sendto(sockfd, "", 0, 0, (struct sockaddr*)&dst, dstLen);
+        close(sockfd);
+    }
+
+    for (int i = 0; i < NEIGHBOUR_RETRIES; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(NEIGHBOUR_WAIT_MS));
+        if (findNeighbour(link, family, nextHop, addrLen, mac)) return;
+    }
+    throw std::runtime_error("Failed to resolve the MAC address of the next hop for " + toString(target));
+}
+
+// Function to parse the ports
+std::vector<int> parsePorts(const std::string &ports) {
+    // look for the - in the string
+    size_t found = ports.find("-"); 
+    // port range
+    if (found != std::string::npos) { 
+        // split the string, with the - index, and find lower and upper bounds
+        std::string lowerBound = ports.substr(0, found);
+        std::string upperBound = ports.substr(found + 1, ports.length()); 
+
+        // both bounds have to be port numbers, a larger one would expand into millions of ports
+        int lower, upper;
+        if (!parseNumber(lowerBound, 0, MAX_PORT_NUMBER, lower) || !parseNumber(upperBound, 0, MAX_PORT_NUMBER, upper)) {
+            throw std::invalid_argument("Invalid port range: " + ports); 
+        } 
+
+        // check if the lower bound is less than the upper bound
+        if (lower > upper) {
+            throw std::invalid_argument("Invalid port range: " + ports);
+        } 
+
+        // create a vector of integers, and add the range to it
+        std::vector<int> portList;
+        for (int i = lower; i <= upper; i++) {
+            portList.push_back(i);
+        } 
+        return portList;
+    }  
+
+    // port selection
+    std::vector<int> portList;
+    bool skip = false;
+    int start_index = 0; 
+
+    // pase the ports, and add them to the list
+    for (size_t i = 0; i < ports.length(); i++) { 
+        // moving end index, to the end of the number
+        if (ports[i] != ' ' && ports[i] != ',' && !skip) continue;         
+        if (!skip) {
+            // if we have a comma, we add the port to the list
+            std::string port = ports.substr(start_index, i - start_index);
+            int number;
+            if (!parseNumber(port, 0, std::numeric_limits<int>::max(), number)) {
+                throw std::invalid_argument("Invalid port: " + port);
+            } 
+
+            // save the port to the list
+            portList.push_back(number);
+            skip = true;
+        } 
+
+        if (ports[i] != ' ' && ports[i] != ',') {
+            skip = false;
+            start_index = i;
+        }
+    } 
+    // add the last port to the list
+    std::string port = ports.substr(start_index, ports.length() - start_index);
+    int number;
+    if (!parseNumber(port, 0, std::numeric_limits<int>::max(), number)) {
+        throw std::invalid_argument("Invalid port: " + port);
+    }
+    portList.push_back(number); 
+    return portList;
+} 
+// Function to determine the target type
+TargetType determinTargetType(const std::string &target) { 
+    // Regular expressions for IPv4, IPv6, and domain name
+    std::regex ipv4_regex("^(\\d{1,3}\\.){3}\\d{1,3}$");
+    std::regex ipv6_regex("^[0-9a-fA-F:]+$");
+    std::regex domain_regex("^[a-zA-Z0-9.-]+$"); 
+    if (std::regex_match(target, ipv4_regex)) return TargetType::IP_v4;
+    if (std::regex_match(target, ipv6_regex)) return TargetType::IP_v6;
+    if (std::regex_match(target, domain_regex)) return TargetType::DOMAIN_NAME;
+    return TargetType::UNKNOWN;
+}
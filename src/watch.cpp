@@ -0,0 +1,151 @@
+/**
+ * @file watch.cpp
+ * @brief File for the watch mode (rounds of scans, that keep the state of the ports and print its changes)
+ * @author Martin Mendl <x247581>
+ * @date 2026-01-13
+ */
+
+#include <iostream>
+#include <map>
+#include <ctime>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include "watch.hpp"
+
+// set by SIGINT and SIGTERM, the watch stops
+static volatile sig_atomic_t stopRequested = 0;
+
+// function to note the stop signal
+static void requestStop(int) {
+    stopRequested = 1;
+}
+
+// function to order the addresses for the lookup of the results
+static bool addressLess(const NetworkAdress &a, const NetworkAdress &b) {
+    if (a.ipVer != b.ipVer) return a.ipVer < b.ipVer;
+    return memcmp(a.addr, b.addr, (a.ipVer == IpVersion::IPV4) ? 4 : 16) < 0;
+}
+
+// Constructor for PortWatcher class
+PortWatcher::PortWatcher(const WatchSettings &settings, std::vector<NetworkAdress> targets, std::vector<int> tcpPorts, std::vector<int> udpPorts) {
+    this->settings = settings;
+    this->targets = targets;
+    std::sort(this->targets.begin(), this->targets.end(), addressLess);
+
+    // a port given twice is watched once
+    tcpIndex.assign(MAX_PORT_NUMBER + 1, -1);
+    udpIndex.assign(MAX_PORT_NUMBER + 1, -1);
+    for (int port : tcpPorts) {
+        if (tcpIndex[port] >= 0) continue;
+        tcpIndex[port] = tcp.size();
+        tcp.push_back(port);
+    }
+    for (int port : udpPorts) {
+        if (udpIndex[port] >= 0) continue;
+        udpIndex[port] = udp.size();
+        udp.push_back(port);
+    }
+    states.assign(this->targets.size() * (tcp.size() + udp.size()), ScanResult::UNKNOWN);
+
+    // short lists are swept whole, long ones a slice of about WATCH_SLICE_PORTS per round
+    slices = std::clamp<size_t>((tcp.size() + udp.size()) / WATCH_SLICE_PORTS, 1, WATCH_MAX_SLICES);
+}
+
+// Method to keep the new state of a port and print it, if it changed
+void PortWatcher::update(const PortResult &result) {
+    auto target = std::lower_bound(targets.begin(), targets.end(), result.target, addressLess);
+    if (target == targets.end() || addressLess(result.target, *target)) return;
+    int index = (result.protocol == Protocol::TCP) ? tcpIndex[result.port] : udpIndex[result.port];
+    if (index < 0) return;
+    if (result.protocol == Protocol::UDP) index += tcp.size();
+
+    ScanResult &state = states[(target - targets.begin()) * (tcp.size() + udp.size()) + index];
+    ScanResult previous = state;
+    state = result.result;
+    // the first round prints the open ports only, later rounds every change
+    if (previous == result.result || (previous == ScanResult::UNKNOWN && result.result != ScanResult::OPEN)) return;
+
+    char stamp[32];
+    time_t now = time(nullptr);
+    struct tm local;
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime_r(&now, &local));
+    std::cout << stamp << " " << formatResult(result, settings.showRtt) << " (was " << toString(previous) << ")" << std::endl;
+}
+
+// Method to add a job of the round
+void PortWatcher::addJob(const std::vector<NetworkAdress> &jobTargets, const std::vector<int> &tcpPorts, const std::vector<int> &udpPorts) {
+    ScanJob &job = jobs.emplace_back();
+    job.interface(settings.interfaceName).backend(settings.backend).timeout(settings.timeout).hostProbes(settings.hostProbes).banner(settings.bannerBytes);
+    job.tcpPorts(tcpPorts).udpPorts(udpPorts).onResult([this](const PortResult &result) { update(result); });
+    for (const NetworkAdress &target : jobTargets) job.target(target);
+
+    // without a first round there is no state to compare, a later round reports its error and goes on
+    ScanError error = runner.add(job);
+    if (error && round == 0) throw std::runtime_error("Failed to start the watch: " + error.message);
+}
+
+// Method to scan one round, the open ports and a slice of the rest
+bool PortWatcher::scanRound() {
+    jobs.clear();
+
+    // the slice of the round on all the targets
+    std::vector<int> sweepTcp, sweepUdp;
+    for (size_t i = 0; i < tcp.size(); i++) if (inSlice(i)) sweepTcp.push_back(tcp[i]);
+    for (size_t i = 0; i < udp.size(); i++) if (inSlice(i)) sweepUdp.push_back(udp[i]);
+    if (!sweepTcp.empty() || !sweepUdp.empty()) addJob(targets, sweepTcp, sweepUdp);
+
+    // the open ports outside the slice, the targets with the same open ports share a job
+    std::map<std::pair<std::vector<int>, std::vector<int>>, std::vector<NetworkAdress>> verify;
+    for (size_t t = 0; round > 0 && t < targets.size(); t++) {
+        const ScanResult *state = &states[t * (tcp.size() + udp.size())];
+        std::pair<std::vector<int>, std::vector<int>> open;
+        for (size_t i = 0; i < tcp.size(); i++) if (state[i] == ScanResult::OPEN && !inSlice(i)) open.first.push_back(tcp[i]);
+        for (size_t i = 0; i < udp.size(); i++) if (state[tcp.size() + i] == ScanResult::OPEN && !inSlice(i)) open.second.push_back(udp[i]);
+        if (!open.first.empty() || !open.second.empty()) verify[open].push_back(targets[t]);
+    }
+    for (const auto &[ports, group] : verify) addJob(group, ports.first, ports.second);
+
+    while (!runner.finished()) {
+        if (stopRequested) return false;
+        runner.sendDue();
+        int timeoutMs = -1;
+        fds.clear();
+        runner.addPollFds(fds, timeoutMs);
+        if (poll(fds.data(), fds.size(), timeoutMs) < 0 && errno != EINTR) {
+            perror("poll failed");
+            throw std::runtime_error("Failed to wait for the replies");
+        }
+        runner.process();
+    }
+
+    // the ports of a failed job keep their last state, the next rounds probe them again
+    for (const ScanJob &job : jobs) {
+        if (job.getError()) std::cerr << "Warning: watch round " << round << " failed: " << job.getError().message << std::endl;
+    }
+    round++;
+    return true;
+}
+
+// Method to watch the ports, until SIGINT or SIGTERM
+void PortWatcher::run() {
+    // no SA_RESTART, the signal ends the poll
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    while (!stopRequested) {
+        // the rounds start an interval apart, a round longer than that is followed right away
+        Clock::time_point next = Clock::now() + std::chrono::seconds(settings.intervalS);
+        if (!scanRound()) break;
+        while (!stopRequested && Clock::now() < next) {
+            long long waitMs = std::chrono::duration_cast<std::chrono::milliseconds>(next - Clock::now()).count();
+            poll(nullptr, 0, std::max(1LL, waitMs));
+        }
+    }
+    jobs.clear();
+}
@@ -0,0 +1,485 @@
+/**
+ * @file xdp.cpp
+ * @brief File for the AF_XDP transport (XDP socket in generic mode)
+ * @author Martin Mendl <x247581>
+ * @date 2025-30-03
+ */
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/ethernet.h>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include "xdp.hpp"
+#include "portalloc.hpp"
+
+/**
+ * @class BpfAssembler
+ * @brief Builds the instructions of the XDP program, resolving the jump labels
+ */
+class BpfAssembler {
+    public:
+        /**
+         * @brief Method to add an instruction
+         */
+        void emit(uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm) {
+            struct bpf_insn insn;
+            memset(&insn, 0, sizeof(insn));
+            insn.code = code;
+            insn.dst_reg = dst;
+            insn.src_reg = src;
+            insn.off = off;
+            insn.imm = imm;
+            insns.push_back(insn);
+        }
+        /**
+         * @brief Method to add a jump to the label, comparing the register to an immediate
+         */
+        void jump(uint8_t op, uint8_t reg, int32_t imm, int label) {
+            jumps.push_back({insns.size(), label});
+            emit(BPF_JMP | op | BPF_K, reg, 0, 0, imm);
+        }
+        /**
+         * @brief Method to add a jump to the label, comparing two registers
+         */
+        void jumpReg(uint8_t op, uint8_t dst, uint8_t src, int label) {
+            jumps.push_back({insns.size(), label});
+            emit(BPF_JMP | op | BPF_X, dst, src, 0, 0);
+        }
+        /**
+         * @brief Method to place the label at the next instruction
+         */
+        void label(int label) {
+            if (size_t(label) >= labels.size()) labels.resize(label + 1);
+            labels[label] = insns.size();
+        }
+        /**
+         * @brief Method to patch the jump offsets and return the program
+         */
+        const std::vector<struct bpf_insn>& link() {
+            for (auto [at, label] : jumps) insns[at].off = labels[label] - at - 1;
+            return insns;
+        }
+    private:
+        std::vector<struct bpf_insn> insns;                 // program
+        std::vector<std::pair<size_t, int>> jumps;          // jump instruction, target label
+        std::vector<size_t> labels;                         // label, instruction index
+};
+
+// Function to call the bpf syscall
+static int bpf(int cmd, union bpf_attr *attr) {
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+// Constructor for XdpSocket class
+XdpSocket::XdpSocket(const NetworkAdress &sender, const LinkInfo &link) : LinkTransport(sender, link) {
+    try {
+        sockfd = socket(AF_XDP, SOCK_RAW, 0);
+        if (sockfd < 0) {
+            perror("socket failed");
+            throw std::runtime_error("Failed to create XDP socket");
+        }
+
+        // the packet buffer, receive frames first, transmit frames after them
+        umemSize = size_t(XDP_RX_FRAMES + XDP_TX_FRAMES) * XDP_FRAME_SIZE;
+        void *mapping = mmap(nullptr, umemSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("Failed to allocate the UMEM");
+        }
+        umem = (char*)mapping;
+
+        struct xdp_umem_reg reg;
+        memset(&reg, 0, sizeof(reg));
+        reg.addr = (uint64_t)umem;
+        reg.len = umemSize;
+        reg.chunk_size = XDP_FRAME_SIZE;
+        if (setsockopt(sockfd, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) < 0) {
+            perror("setsockopt failed");
+            throw std::runtime_error("Failed to register the UMEM");
+        }
+
+        unsigned rxFrames = XDP_RX_FRAMES, txFrames = XDP_TX_FRAMES;
+        if (setsockopt(sockfd, SOL_XDP, XDP_UMEM_FILL_RING, &rxFrames, sizeof(rxFrames)) < 0 ||
+            setsockopt(sockfd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &txFrames, sizeof(txFrames)) < 0 ||
+            setsockopt(sockfd, SOL_XDP, XDP_RX_RING, &rxFrames, sizeof(rxFrames)) < 0 ||
+            setsockopt(sockfd, SOL_XDP, XDP_TX_RING, &txFrames, sizeof(txFrames)) < 0) {
+            perror("setsockopt failed");
+            throw std::runtime_error("Failed to set up the XDP rings");
+        }
+
+        struct xdp_mmap_offsets offsets;
+        socklen_t offsetsLen = sizeof(offsets);
+        if (getsockopt(sockfd, SOL_XDP, XDP_MMAP_OFFSETS, &offsets, &offsetsLen) < 0) {
+            perror("getsockopt failed");
+            throw std::runtime_error("Failed to get the XDP ring offsets");
+        }
+        mapRing(fillRing, offsets.fr, XDP_RX_FRAMES, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING);
+        mapRing(completionRing, offsets.cr, XDP_TX_FRAMES, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING);
+        mapRing(rxRing, offsets.rx, XDP_RX_FRAMES, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING);
+        mapRing(txRing, offsets.tx, XDP_TX_FRAMES, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING);
+
+        // all the receive frames go to the kernel right away
+        for (unsigned i = 0; i < XDP_RX_FRAMES; i++) {
+            ((uint64_t*)fillRing.desc)[i] = uint64_t(i) * XDP_FRAME_SIZE;
+        }
+        fillRing.cached = XDP_RX_FRAMES;
+        __atomic_store_n(fillRing.producer, fillRing.cached, __ATOMIC_RELEASE);
+
+        // the transmit frames keep the Ethernet source and type between the probes
+        freeFrames.reserve(XDP_TX_FRAMES);
+        for (unsigned i = 0; i < XDP_TX_FRAMES; i++) {
+            uint64_t addr = uint64_t(XDP_RX_FRAMES + i) * XDP_FRAME_SIZE;
+            fillTemplate(umem + addr);
+            freeFrames.push_back(addr);
+        }
+
+        // copy mode, the generic XDP path has no zero copy
+        struct sockaddr_xdp addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sxdp_family = AF_XDP;
+        addr.sxdp_flags = XDP_COPY;
+        addr.sxdp_ifindex = link.ifindex;
+        addr.sxdp_queue_id = XDP_QUEUE;
+        if (bind(sockfd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            perror("bind failed");
+            throw std::runtime_error("Failed to bind the XDP socket to the interface");
+        }
+
+        attachProgram();
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+// Destructor for XdpSocket class
+XdpSocket::~XdpSocket() {
+    release();
+}
+
+// Method to close the program, the rings and the socket
+void XdpSocket::release() {
+    // closing the link detaches the program from the interface
+    if (linkfd >= 0) close(linkfd);
+    if (progfd >= 0) close(progfd);
+    if (mapfd >= 0) close(mapfd);
+    if (portBits != nullptr) munmap(portBits, SOURCE_PORT_COUNT / 8);
+    if (portsfd >= 0) close(portsfd);
+    linkfd = progfd = mapfd = portsfd = -1;
+    portBits = nullptr;
+
+    for (XdpRing *ring : {&fillRing, &completionRing, &rxRing, &txRing}) {
+        if (ring->map != nullptr) munmap(ring->map, ring->mapSize);
+        ring->map = nullptr;
+    }
+    if (sockfd >= 0) close(sockfd);
+    if (umem != nullptr) munmap(umem, umemSize);
+    sockfd = -1;
+    umem = nullptr;
+}
+
+// Method to map a ring of the socket
+void XdpSocket::mapRing(XdpRing &ring, const struct xdp_ring_offset &offsets, uint32_t size, size_t descSize, uint64_t pgoff) {
+    ring.mapSize = offsets.desc + size * descSize;
+    void *mapping = mmap(nullptr, ring.mapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, sockfd, pgoff);
+    if (mapping == MAP_FAILED) {
+        perror("mmap failed");
+        throw std::runtime_error("Failed to map an XDP ring");
+    }
+
+    ring.map = mapping;
+    ring.producer = (uint32_t*)((char*)mapping + offsets.producer);
+    ring.consumer = (uint32_t*)((char*)mapping + offsets.consumer);
+    ring.desc = (char*)mapping + offsets.desc;
+    ring.size = size;
+}
+
+// Method to load the XDP program and attach it to the interface
+void XdpSocket::attachProgram() {
+    union bpf_attr attr;
+
+    // the program looks the socket up by the receive queue
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(uint32_t);
+    attr.max_entries = XDP_QUEUE + 1;
+    mapfd = bpf(BPF_MAP_CREATE, &attr);
+    if (mapfd < 0) {
+        perror("bpf failed");
+        throw std::runtime_error("Failed to create the XSKMAP");
+    }
+
+    uint32_t queue = XDP_QUEUE;
+    uint32_t socket = sockfd;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = mapfd;
+    attr.key = (uint64_t)&queue;
+    attr.value = (uint64_t)&socket;
+    attr.flags = BPF_ANY;
+    if (bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0) {
+        perror("bpf failed");
+        throw std::runtime_error("Failed to insert the socket into the XSKMAP");
+    }
+
+    // a bit per source port, the scanner sets it, while a probe from the port is in flight
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_ARRAY;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = SOURCE_PORT_COUNT / 8;
+    attr.max_entries = 1;
+    attr.map_flags = BPF_F_MMAPABLE;
+    portsfd = bpf(BPF_MAP_CREATE, &attr);
+    if (portsfd < 0) {
+        perror("bpf failed");
+        throw std::runtime_error("Failed to create the map of the source ports");
+    }
+    void *mapping = mmap(nullptr, SOURCE_PORT_COUNT / 8, PROT_READ | PROT_WRITE, MAP_SHARED, portsfd, 0);
+    if (mapping == MAP_FAILED) {
+        perror("mmap failed");
+        throw std::runtime_error("Failed to map the source ports");
+    }
+    portBits = (uint8_t*)mapping;
+
+    // the answers to the probes in flight go to the socket, the rest (ARP, NDP, host sockets, ...) to the kernel
+    enum { PORT4, ICMP4, QUOTED4, PORT6, ICMP6, QUOTED6, REDIRECT, PASS };
+    int32_t firstPort = SOURCE_PORT_BASE, lastPort = SOURCE_PORT_BASE + SOURCE_PORT_COUNT - 1;
+    BpfAssembler prog;
+
+    // the port in r5 (network byte order) is redirected, if its bit is set, the ephemeral ports of the host overlap the range
+    auto matchPort = [&]() {
+        prog.emit(BPF_ALU | BPF_END | BPF_TO_BE, BPF_REG_5, 0, 0, 16);                     // to host byte order
+        prog.jump(BPF_JLT, BPF_REG_5, firstPort, PASS);                                     // in the source port range
+        prog.jump(BPF_JGT, BPF_REG_5, lastPort, PASS);
+        prog.emit(BPF_ALU64 | BPF_SUB | BPF_K, BPF_REG_5, 0, 0, firstPort);               // r5 = bit of the port
+        prog.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_5, 0, 0);
+        prog.emit(BPF_ALU64 | BPF_RSH | BPF_K, BPF_REG_4, 0, 0, 3);                       // r4 = byte of the bit
+        prog.emit(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_VALUE, 0, portsfd); // r1 = the bitmap
+        prog.emit(0, 0, 0, 0, 0);
+        prog.emit(BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_1, BPF_REG_4, 0, 0);
+        prog.emit(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_4, BPF_REG_1, 0, 0);
+        prog.emit(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_5, 0, 0, 7);
+        prog.emit(BPF_ALU64 | BPF_RSH | BPF_X, BPF_REG_4, BPF_REG_5, 0, 0);
+        prog.emit(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_4, 0, 0, 1);
+        prog.jump(BPF_JNE, BPF_REG_4, 0, REDIRECT);
+        prog.jump(BPF_JA, 0, 0, PASS);
+    };
+
+    prog.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0);                // r6 = ctx
+    prog.emit(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_6, 0, 0);                 // r2 = data
+    prog.emit(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_3, BPF_REG_6, 4, 0);                 // r3 = data_end
+    prog.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0);
+    prog.emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, 14);
+    prog.jumpReg(BPF_JGT, BPF_REG_4, BPF_REG_3, PASS);                                  // Ethernet header
+    prog.emit(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, 12, 0);                // ether type
+    // only the IP version of the socket, the other one goes on to the raw sockets of a dual stack scan
+    prog.jump(BPF_JNE, BPF_REG_5, htons(ipv4 ? ETHERTYPE_IP : ETHERTYPE_IPV6), PASS);
+
+    if (!ipv4) {
+        // IPv6, the header and the first 4 bytes of the segment
+        prog.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0);
+        prog.emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, 14 + 40 + 4);
+        prog.jumpReg(BPF_JGT, BPF_REG_4, BPF_REG_3, PASS);
+        prog.emit(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2, 14 + 6, 0);            // next header
+        prog.jump(BPF_JEQ, BPF_REG_5, IPPROTO_ICMPV6, ICMP6);
+        prog.jump(BPF_JEQ, BPF_REG_5, IPPROTO_TCP, PORT6);
+        prog.jump(BPF_JNE, BPF_REG_5, IPPROTO_UDP, PASS);
+        prog.label(PORT6);
+        prog.emit(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, 14 + 40 + 2, 0);       // destination port
+        matchPort();
+        prog.label(ICMP6);
+        prog.emit(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2, 14 + 40, 0);           // ICMPv6 type, errors are below 128
+        prog.jump(BPF_JGE, BPF_REG_5, 128, PASS);
+        // the error quotes the IPv6 header and the ports of the probe
+        prog.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0);
+        prog.emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, 14 + 40 + 8 + 40 + 4);
+        prog.jumpReg(BPF_JGT, BPF_REG_4, BPF_REG_3, PASS);
+        prog.emit(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2, 14 + 40 + 8 + 6, 0);   // quoted next header
+        prog.jump(BPF_JEQ, BPF_REG_5, IPPROTO_TCP, QUOTED6);
+        prog.jump(BPF_JNE, BPF_REG_5, IPPROTO_UDP, PASS);
+        prog.label(QUOTED6);
+        prog.emit(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, 14 + 40 + 8 + 40, 0);  // quoted source port
+        matchPort();
+    }
+
+    if (ipv4) {
+        // IPv4 without options, the header and the first 4 bytes of the segment
+        prog.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0);
+        prog.emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, 14 + 20 + 4);
+        prog.jumpReg(BPF_JGT, BPF_REG_4, BPF_REG_3, PASS);
+        prog.emit(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2, 14, 0);                // version and header length
+        prog.jump(BPF_JNE, BPF_REG_5, 0x45, PASS);
+        prog.emit(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2, 14 + 9, 0);            // protocol
+        prog.jump(BPF_JEQ, BPF_REG_5, IPPROTO_ICMP, ICMP4);
+        prog.jump(BPF_JEQ, BPF_REG_5, IPPROTO_TCP, PORT4);
+        prog.jump(BPF_JNE, BPF_REG_5, IPPROTO_UDP, PASS);
+        prog.label(PORT4);
+        prog.emit(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, 14 + 20 + 2, 0);       // destination port
+        matchPort();
+        prog.label(ICMP4);
+        prog.emit(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2, 14 + 20, 0);           // ICMP type
+        prog.jump(BPF_JNE, BPF_REG_5, 3, PASS);                                             // destination unreachable
+        // the error quotes the IPv4 header (without options) and the ports of the probe
+        prog.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0);
+        prog.emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, 14 + 20 + 8 + 20 + 4);
+        prog.jumpReg(BPF_JGT, BPF_REG_4, BPF_REG_3, PASS);
+        prog.emit(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2, 14 + 20 + 8, 0);       // quoted version and header length
+        prog.jump(BPF_JNE, BPF_REG_5, 0x45, PASS);
+        prog.emit(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2, 14 + 20 + 8 + 9, 0);   // quoted protocol
+        prog.jump(BPF_JEQ, BPF_REG_5, IPPROTO_TCP, QUOTED4);
+        prog.jump(BPF_JNE, BPF_REG_5, IPPROTO_UDP, PASS);
+        prog.label(QUOTED4);
+        prog.emit(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, 14 + 20 + 8 + 20, 0);  // quoted source port
+        matchPort();
+    }
+
+    // bpf_redirect_map(&xsks, rx_queue_index, XDP_PASS), passes if the queue has no socket
+    prog.label(REDIRECT);
+    prog.emit(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_6, 16, 0);                // rx_queue_index
+    prog.emit(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, mapfd);
+    prog.emit(0, 0, 0, 0, 0);
+    prog.emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS);
+    prog.emit(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map);
+    prog.emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+    prog.label(PASS);
+    prog.emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS);
+    prog.emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+
+    const std::vector<struct bpf_insn> &insns = prog.link();
+    static char log[16384];
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns = (uint64_t)insns.data();
+    attr.insn_cnt = insns.size();
+    attr.license = (uint64_t)"GPL";
+    attr.log_buf = (uint64_t)log;
+    attr.log_size = sizeof(log);
+    attr.log_level = 1;
+    progfd = bpf(BPF_PROG_LOAD, &attr);
+    if (progfd < 0) {
+        perror("bpf failed");
+        std::cerr << log << std::endl;
+        throw std::runtime_error("Failed to load the XDP program");
+    }
+
+    // generic mode, the link is dropped with its descriptor
+    memset(&attr, 0, sizeof(attr));
+    attr.link_create.prog_fd = progfd;
+    attr.link_create.target_ifindex = link.ifindex;
+    attr.link_create.attach_type = BPF_XDP;
+    attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+    linkfd = bpf(BPF_LINK_CREATE, &attr);
+    if (linkfd < 0) {
+        perror("bpf failed");
+        throw std::runtime_error("Failed to attach the XDP program to the interface");
+    }
+}
+
+// Method to take the sent frames back from the completion ring
+void XdpSocket::reapCompletions() {
+    uint32_t produced = __atomic_load_n(completionRing.producer, __ATOMIC_ACQUIRE);
+    uint32_t mask = completionRing.size - 1;
+
+    while (completionRing.cached != produced) {
+        freeFrames.push_back(((uint64_t*)completionRing.desc)[completionRing.cached & mask]);
+        completionRing.cached++;
+    }
+    __atomic_store_n(completionRing.consumer, completionRing.cached, __ATOMIC_RELEASE);
+}
+
+// Method to get the next free transmit frame
+char* XdpSocket::nextFrame(size_t *size) {
+    if (freeFrames.empty()) reapCompletions();
+    if (freeFrames.empty()) return nullptr;
+
+    reservedAddr = freeFrames.back();
+    freeFrames.pop_back();
+    *size = XDP_FRAME_SIZE;
+    return umem + reservedAddr;
+}
+
+// Method to queue the frame from nextFrame for sending
+void XdpSocket::commitFrame(size_t size) {
+    struct xdp_desc *desc = &((struct xdp_desc*)txRing.desc)[txRing.cached & (txRing.size - 1)];
+    desc->addr = reservedAddr;
+    desc->len = size;
+    desc->options = 0;
+    txRing.cached++;
+    txPending++;
+}
+
+// Method to push the committed frames to the kernel
+void XdpSocket::flush() {
+    if (txPending == 0) return;
+    __atomic_store_n(txRing.producer, txRing.cached, __ATOMIC_RELEASE);
+
+    // in copy mode every kick sends a limited batch, kick until the ring is drained
+    bool full = false;
+    for (unsigned i = 0; i < XDP_KICK_TRIES; i++) {
+        if (sendto(sockfd, nullptr, 0, MSG_DONTWAIT, nullptr, 0) < 0) {
+            if (errno != EBUSY && !isBackpressure(errno)) {
+                perror("sendto failed");
+                throw std::runtime_error("Failed to kick the XDP transmit ring");
+            }
+            full = full || errno != EBUSY;
+        } else {
+            // a later kick, that went through, took the frames of the full one
+            full = false;
+        }
+        if (__atomic_load_n(txRing.consumer, __ATOMIC_ACQUIRE) == txRing.cached) break;
+    }
+    reapCompletions();
+    if (full) {
+        backpressure++;  // the frames stay in the ring, the next flush kicks it again
+        return;
+    }
+    txPending = 0;
+}
+
+// Method to get the number of received packets, the kernel dropped so far
+uint64_t XdpSocket::getDrops() {
+    // the counters of the socket are cumulative, dropped by the kernel or for a full receive ring
+    struct xdp_statistics stats;
+    socklen_t len = sizeof(stats);
+    memset(&stats, 0, sizeof(stats));
+    if (getsockopt(sockfd, SOL_XDP, XDP_STATISTICS, &stats, &len) == 0) drops = stats.rx_dropped + stats.rx_ring_full;
+    return drops;
+}
+
+// Method to note, that a probe from the source port is in flight, or no longer is
+void XdpSocket::claimPort(uint16_t port, bool inFlight) {
+    if (portBits == nullptr || port < SOURCE_PORT_BASE || uint32_t(port - SOURCE_PORT_BASE) >= SOURCE_PORT_COUNT) return;
+    uint32_t index = port - SOURCE_PORT_BASE;
+    uint8_t bit = uint8_t(1) << (index % 8);
+
+    // the bit is set before the probe is committed, the program reads the bitmap concurrently
+    if (inFlight) __atomic_fetch_or(&portBits[index / 8], bit, __ATOMIC_RELEASE);
+    else __atomic_fetch_and(&portBits[index / 8], uint8_t(~bit), __ATOMIC_RELEASE);
+}
+
+// Method to read all the waiting packets
+void XdpSocket::receive(const SegmentCallback &onSegment) {
+    uint32_t produced = __atomic_load_n(rxRing.producer, __ATOMIC_ACQUIRE);
+    uint32_t mask = rxRing.size - 1;
+    if (rxRing.cached == produced) return;
+
+    // parse in place, then give the frames back to the kernel in one batch,
+    // the frames of the copy mode carry no timestamp, the batch is stamped when it is read
+    int64_t receivedNs = wallClockNs();
+    while (rxRing.cached != produced) {
+        const struct xdp_desc *desc = &((const struct xdp_desc*)rxRing.desc)[rxRing.cached & mask];
+        handleFrame(umem + desc->addr, desc->len, receivedNs, onSegment);
+        ((uint64_t*)fillRing.desc)[fillRing.cached & (fillRing.size - 1)] = desc->addr;
+        fillRing.cached++;
+        rxRing.cached++;
+    }
+    __atomic_store_n(rxRing.consumer, rxRing.cached, __ATOMIC_RELEASE);
+    __atomic_store_n(fillRing.producer, fillRing.cached, __ATOMIC_RELEASE);
+}
@@ -57,6 +57,20 @@ run_test "UDP ports" "./argTest -u 53,123 example.com" "53 123"
 run_test "Target IPv4" "./argTest -i eth0 -t 80 -u 53 192.168.1.1" "192.168.1.1"
 run_test "Target IPv6" "./argTest -i eth0 -t 80 -u 53 fe80::1" "fe80::1"
 run_test "Timeout" "./argTest -w 5000 example.com" "5000"
+run_test "Several targets" "./argTest -i eth0 -t 80 192.168.1.1 fe80::1" "fe80::1"
+run_test "Probes per host" "./argTest -i eth0 -t 80 -c 16 192.168.1.1" "hostProbes 16"
+run_test "Top TCP ports" "./argTest -i eth0 -T 5 192.168.1.1" "80 23 443 21 22"
+run_test "Top UDP ports" "./argTest -i eth0 -U 3 192.168.1.1" "631 161 137"
+run_test "Whole TCP profile" "./argTest -i eth0 -T 322 192.168.1.1" "1046 1057 1061"
+run_test "Top ports beyond the table" "./argTest -i eth0 -T 323 192.168.1.1 2>&1" "Top ports must be a number between 1 and 322"
+run_test "Banner size" "./argTest -i eth0 -t 80 -B 128 192.168.1.1" "bannerBytes 128"
+run_test "Daemon mode" "./argTest -i eth0 -w 1000 -D /tmp/ipk-l4-scan.sock" "DAEMON"
+run_test "Watch mode" "./argTest -i eth0 -t 22 -W 60 192.168.1.1" "WATCH"
+run_test "Excluded targets" "./argTest -i eth0 -t 80 -x 192.168.1.0/24,fd00::/8 192.168.1.1 10.0.0.1" "10.0.0.1"
+run_test "Invalid timeout" "./argTest -i eth0 -t 80 -w 5s 192.168.1.1 2>&1" "Timeout must be a number greater than 0"
+run_test "Invalid top ports" "./argTest -i eth0 -T many 192.168.1.1 2>&1" "Top ports must be a number between 1 and"
+run_test "Invalid watch interval" "./argTest -i eth0 -t 80 -W 99999999999 192.168.1.1 2>&1" "Watch interval must be a number greater than 0"
+run_test "Invalid port range" "./argTest -i eth0 -t 1-99999999 192.168.1.1 2>&1" "Invalid TCP ports: 1-99999999"
 
 # Cleanup
 print_section "CLEANING UP"
@@ -0,0 +1,142 @@
+#!/bin/bash
+# CONGESTION CONTROL TEST SCRIPT
+#  *
+#  * @file testCongestion.sh
+#  * @brief This script scans a target behind a netem shaped veth pair (delay, loss, rate) and checks, that the congestion windows keep the results exact.
+#  */
+
+# ANSI escape codes for colored output
+RESET="\033[0m"
+RED="\033[1;31m"
+GREEN="\033[1;32m"
+YELLOW="\033[1;33m"
+BLUE="\033[1;34m"
+MAGENTA="\033[1;35m"
+
+# Decorations
+SEPARATOR="${BLUE}========================================================${RESET}"
+
+# Test bed, the target lives in its own namespace behind a veth pair
+NETNS="ipkcongest"
+VETH_SCAN="ipkc0"
+VETH_TARGET="ipkc1"
+ADDR_SCAN="10.78.0.1"
+ADDR_TARGET="10.78.0.2"
+PORTS=${PORTS:-"1-2000"}
+PORT_COUNT=${PORT_COUNT:-2000}
+OPEN_PORTS="22 80 1234"
+BACKEND=${BACKEND:-"raw"}
+MAX_FILTERED=${MAX_FILTERED:-5}
+
+# netem settings of the link, applied on both ends
+PROFILES=(
+    "delay 1ms"
+    "delay 20ms 5ms loss 5%"
+    "delay 50ms rate 2mbit limit 50 loss 2%"
+)
+
+TESTS_PASSED=0
+TESTS_FAILED=0
+LISTENER_PID=""
+
+# Helper function to print a formatted message
+print_section() {
+    echo -e "\n$SEPARATOR"
+    echo -e "${MAGENTA}$1${RESET}"
+    echo -e "$SEPARATOR"
+}
+
+# Helper function to remove the test bed
+cleanup() {
+    [ -n "$LISTENER_PID" ] && kill "$LISTENER_PID" 2>/dev/null
+    ip link del "$VETH_SCAN" 2>/dev/null
+    ip netns del "$NETNS" 2>/dev/null
+}
+
+# Helper function to scan the target with one netem profile and check the results
+run_profile() {
+    local profile=$1
+
+    tc qdisc replace dev "$VETH_SCAN" root netem $profile
+    ip netns exec "$NETNS" tc qdisc replace dev "$VETH_TARGET" root netem $profile
+
+    echo -e "${YELLOW}Running: netem $profile${RESET}"
+    local start=$(date +%s%N)
+    local output=$(./ipk-l4-scan -i "$VETH_SCAN" -t "$PORTS" -w 1000 -b "$BACKEND" "$ADDR_TARGET" 2>/tmp/ipkcongest.err)
+    local end=$(date +%s%N)
+
+    local total=$(echo "$output" | grep -c "tcp")
+    local open=$(echo "$output" | awk '$4 == "open" {print $2}' | sort -n | tr '\n' ' ' | sed 's/ $//')
+    local filtered=$(echo "$output" | grep -c "filtered")
+
+    echo -e "  ${total} ports in $(( (end - start) / 1000000 )) ms, open: ${open}, filtered: ${filtered}"
+    [ -s /tmp/ipkcongest.err ] && echo -e "  $(cat /tmp/ipkcongest.err)"
+
+    # every port is reported, the open ones are found, and only a few unlucky ports lose all their probes
+    if [ "$total" -eq "$PORT_COUNT" ] && [ "$open" == "$OPEN_PORTS" ] && [ "$filtered" -le "$MAX_FILTERED" ]; then
+        echo -e "${GREEN}Test passed.${RESET}"
+        ((TESTS_PASSED++))
+    else
+        echo -e "${RED}Test failed.${RESET}"
+        ((TESTS_FAILED++))
+    fi
+}
+
+if [ "$(id -u)" -ne 0 ]; then
+    echo -e "${RED}Error: the test needs root.${RESET}"
+    exit 1
+fi
+
+# Build
+print_section "BUILDING"
+make
+if [ ! -f "./ipk-l4-scan" ]; then
+    echo -e "${RED}Error: ipk-l4-scan binary not created.${RESET}"
+    exit 1
+fi
+
+# Set up the veth pair and the listeners in the namespace
+print_section "SETTING UP $VETH_SCAN <-> $VETH_TARGET"
+cleanup
+trap cleanup EXIT
+ip netns add "$NETNS" || exit 1
+ip link add "$VETH_SCAN" type veth peer name "$VETH_TARGET" || exit 1
+ip link set "$VETH_TARGET" netns "$NETNS"
+ip addr add "$ADDR_SCAN/24" dev "$VETH_SCAN"
+ip link set "$VETH_SCAN" up
+ip netns exec "$NETNS" ip addr add "$ADDR_TARGET/24" dev "$VETH_TARGET"
+ip netns exec "$NETNS" ip link set "$VETH_TARGET" up
+ip netns exec "$NETNS" ip link set lo up
+if ! tc qdisc replace dev "$VETH_SCAN" root netem delay 1ms; then
+    echo -e "${RED}Error: the netem qdisc is not available (sch_netem).${RESET}"
+    exit 1
+fi
+ip netns exec "$NETNS" python3 -c "
+import socket, time
+listeners = []
+for port in [int(p) for p in '$OPEN_PORTS'.split()]:
+    s = socket.socket()
+    s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    s.bind(('$ADDR_TARGET', port))
+    s.listen(1024)
+    listeners.append(s)
+time.sleep(3600)
+" &
+LISTENER_PID=$!
+sleep 1
+
+# Run the scans
+print_section "SCANNING TCP PORTS $PORTS OVER NETEM"
+for profile in "${PROFILES[@]}"; do
+    run_profile "$profile"
+done
+
+# Display summary
+print_section "TEST SUMMARY"
+echo -e "${GREEN}Passed: $TESTS_PASSED${RESET}"
+echo -e "${RED}Failed: $TESTS_FAILED${RESET}"
+
+if [ "$TESTS_FAILED" -ne 0 ]; then
+    exit 1
+fi
+exit 0
@@ -0,0 +1,114 @@
+#!/bin/bash
+# CONNECT SCAN TEST SCRIPT
+#  *
+#  * @file testConnect.sh
+#  * @brief This script scans listeners on the loopback with the connect backend as an unprivileged user and checks the results.
+#  */
+
+# ANSI escape codes for colored output
+RESET="\033[0m"
+RED="\033[1;31m"
+GREEN="\033[1;32m"
+YELLOW="\033[1;33m"
+BLUE="\033[1;34m"
+MAGENTA="\033[1;35m"
+
+# Decorations
+SEPARATOR="${BLUE}========================================================${RESET}"
+
+# The listeners sit in a range no other service uses
+PORTS=${PORTS:-"40000-47999"}
+PORT_COUNT=${PORT_COUNT:-8000}
+OPEN_PORTS="40022 44080 47999"
+
+TESTS_PASSED=0
+TESTS_FAILED=0
+LISTENER_PID=""
+
+# root runs the scans as nobody, so the test shows, that no capability is needed
+RUN_AS=""
+if [ "$(id -u)" -eq 0 ]; then
+    RUN_AS="setpriv --reuid=nobody --regid=nogroup --clear-groups"
+fi
+
+# Helper function to print a formatted message
+print_section() {
+    echo -e "\n$SEPARATOR"
+    echo -e "${MAGENTA}$1${RESET}"
+    echo -e "$SEPARATOR"
+}
+
+# Helper function to stop the listeners
+cleanup() {
+    [ -n "$LISTENER_PID" ] && kill "$LISTENER_PID" 2>/dev/null
+}
+
+# Helper function to scan a loopback address and check the results
+run_scan() {
+    local description=$1
+    local target=$2
+    local limit=$3
+
+    echo -e "${YELLOW}Running: $description${RESET}"
+    local start=$(date +%s%N)
+    local output=$(ulimit -Sn "$limit" && $RUN_AS ./ipk-l4-scan -i lo -b connect -t "$PORTS" -w 1000 "$target" 2>/tmp/ipkconnect.err)
+    local end=$(date +%s%N)
+
+    local total=$(echo "$output" | grep -c "tcp")
+    local open=$(echo "$output" | awk '$4 == "open" {print $2}' | sort -n | tr '\n' ' ' | sed 's/ $//')
+    local filtered=$(echo "$output" | grep -c "filtered")
+
+    echo -e "  ${total} ports in $(( (end - start) / 1000000 )) ms with ${limit} open files, open: ${open}, filtered: ${filtered}"
+    [ -s /tmp/ipkconnect.err ] && echo -e "  $(cat /tmp/ipkconnect.err)"
+
+    # every port is reported, the listeners are open, the rest refused
+    if [ "$total" -eq "$PORT_COUNT" ] && [ "$open" == "$OPEN_PORTS" ] && [ "$filtered" -eq 0 ]; then
+        echo -e "${GREEN}Test passed.${RESET}"
+        ((TESTS_PASSED++))
+    else
+        echo -e "${RED}Test failed.${RESET}"
+        ((TESTS_FAILED++))
+    fi
+}
+
+# Build
+print_section "BUILDING"
+make
+if [ ! -f "./ipk-l4-scan" ]; then
+    echo -e "${RED}Error: ipk-l4-scan binary not created.${RESET}"
+    exit 1
+fi
+
+# Listeners on both loopback addresses
+print_section "STARTING THE LISTENERS"
+trap cleanup EXIT
+python3 -c "
+import socket, time
+listeners = []
+for family, address in [(socket.AF_INET, '127.0.0.1'), (socket.AF_INET6, '::1')]:
+    for port in [int(p) for p in '$OPEN_PORTS'.split()]:
+        s = socket.socket(family)
+        s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        s.bind((address, port))
+        s.listen(1024)
+        listeners.append(s)
+time.sleep(3600)
+" &
+LISTENER_PID=$!
+sleep 1
+
+# Run the scans
+print_section "SCANNING TCP PORTS $PORTS WITH CONNECT() ${RUN_AS:+AS NOBODY}"
+run_scan "IPv4 loopback" "127.0.0.1" 1024
+run_scan "IPv6 loopback" "::1" 1024
+run_scan "IPv4 loopback, low open file limit" "127.0.0.1" 128
+
+# Display summary
+print_section "TEST SUMMARY"
+echo -e "${GREEN}Passed: $TESTS_PASSED${RESET}"
+echo -e "${RED}Failed: $TESTS_FAILED${RESET}"
+
+if [ "$TESTS_FAILED" -ne 0 ]; then
+    exit 1
+fi
+exit 0
@@ -0,0 +1,163 @@
+#!/bin/bash
+# DAEMON TEST SCRIPT
+#  *
+#  * @file testDaemon.sh
+#  * @brief This script runs the scanner as a daemon on the loopback, submits concurrent, invalid and cancelled jobs over its socket and checks the answers.
+#  */
+
+# ANSI escape codes for colored output
+RESET="\033[0m"
+RED="\033[1;31m"
+GREEN="\033[1;32m"
+YELLOW="\033[1;33m"
+BLUE="\033[1;34m"
+MAGENTA="\033[1;35m"
+
+# Decorations
+SEPARATOR="${BLUE}========================================================${RESET}"
+
+SOCKET=${SOCKET:-"/tmp/ipk-l4-scan-test.sock"}
+OPEN_PORTS="40022 44080 47999"
+
+TESTS_PASSED=0
+TESTS_FAILED=0
+LISTENER_PID=""
+DAEMON_PID=""
+
+# raw sockets need root, the connect backend runs without
+BACKEND="raw"
+if [ "$(id -u)" -ne 0 ]; then
+    BACKEND="connect"
+fi
+
+# Helper function to print a formatted message
+print_section() {
+    echo -e "\n$SEPARATOR"
+    echo -e "${MAGENTA}$1${RESET}"
+    echo -e "$SEPARATOR"
+}
+
+# Helper function to stop the daemon and the listeners
+cleanup() {
+    [ -n "$DAEMON_PID" ] && kill "$DAEMON_PID" 2>/dev/null
+    [ -n "$LISTENER_PID" ] && kill "$LISTENER_PID" 2>/dev/null
+}
+
+# Helper function to check the output of a client
+check() {
+    local description=$1
+    local output=$2
+    local expected=$3
+
+    echo -e "${YELLOW}Running: $description${RESET}"
+    echo -e "  $output"
+    if [ "$output" == "$expected" ]; then
+        echo -e "${GREEN}Test passed.${RESET}"
+        ((TESTS_PASSED++))
+    else
+        echo -e "${RED}Test failed, expected: $expected${RESET}"
+        ((TESTS_FAILED++))
+    fi
+}
+
+# Client of the daemon, sends the jobs of the arguments at once and prints a summary line per job
+CLIENT='
+import socket, struct, sys, threading, time
+def submit(job):
+    s = socket.socket(socket.AF_UNIX)
+    s.connect(sys.argv[1])
+    payload = job.removeprefix("stall;").removeprefix("halfclose;").replace(";", "\n").encode()
+    s.sendall(struct.pack("!I", len(payload)) + payload)
+    if job.startswith("cancel"):
+        s.close()
+        return "cancelled"
+    # a client, that shuts down its sending side, still reads the answers
+    if job.startswith("halfclose"):
+        s.shutdown(socket.SHUT_WR)
+    # a client, that does not read, falls behind its results
+    if job.startswith("stall"):
+        time.sleep(8)
+    buffer, results, opened = b"", 0, []
+    while True:
+        data = s.recv(65536)
+        if not data:
+            return "connection closed"
+        buffer += data
+        while len(buffer) >= 4 and len(buffer) >= 4 + struct.unpack("!I", buffer[:4])[0]:
+            length = struct.unpack("!I", buffer[:4])[0]
+            frame, buffer = buffer[4:4 + length].decode(), buffer[4 + length:]
+            if frame.startswith("result"):
+                results += 1
+                if " open" in frame: opened.append(frame.split()[2])
+            if frame.startswith("error"):
+                return frame
+            if frame.startswith("done"):
+                return "%d results, open: %s" % (results, " ".join(sorted(opened, key=int)))
+jobs = sys.argv[2:]
+answers = [None] * len(jobs)
+def run(i): answers[i] = submit(jobs[i])
+threads = [threading.Thread(target=run, args=(i,)) for i in range(len(jobs))]
+for t in threads: t.start()
+for t in threads: t.join()
+print(" | ".join(answers))
+'
+
+# Build
+print_section "BUILDING"
+make
+if [ ! -f "./ipk-l4-scan" ]; then
+    echo -e "${RED}Error: ipk-l4-scan binary not created.${RESET}"
+    exit 1
+fi
+
+# Listeners and the daemon
+print_section "STARTING THE LISTENERS AND THE DAEMON (BACKEND $BACKEND)"
+trap cleanup EXIT
+python3 -c "
+import socket, time
+listeners = []
+for port in [int(p) for p in '$OPEN_PORTS'.split()]:
+    s = socket.socket()
+    s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    s.bind(('127.0.0.1', port))
+    s.listen(1024)
+    listeners.append(s)
+time.sleep(3600)
+" &
+LISTENER_PID=$!
+sleep 1
+./ipk-l4-scan -i lo -b "$BACKEND" -w 1000 -D "$SOCKET" &
+DAEMON_PID=$!
+for i in $(seq 50); do [ -S "$SOCKET" ] && break; sleep 0.1; done
+
+# Run the jobs
+print_section "SUBMITTING JOBS"
+check "Four concurrent jobs" "$(python3 -c "$CLIENT" "$SOCKET" "target 127.0.0.1;tcp 40000-41999" "target 127.0.0.1;tcp 42000-43999" "target 127.0.0.1;tcp 44000-45999" "target 127.0.0.1;tcp 46000-47999")" \
+    "2000 results, open: 40022 | 2000 results, open:  | 2000 results, open: 44080 | 2000 results, open: 47999"
+check "Invalid jobs" "$(python3 -c "$CLIENT" "$SOCKET" "target 127.0.0.1;tcp 70000" "tcp 22" "target 127.0.0.1;speed 9")" \
+    "error invalid TCP port: 70000 | error no target | error unknown key: speed"
+check "Cancelled jobs" "$(python3 -c "$CLIENT" "$SOCKET" "cancel;target 127.0.0.1;tcp 1-65535" "cancel;target 127.0.0.1;tcp 1-65535")" \
+    "cancelled | cancelled"
+check "Half closed client" "$(python3 -c "$CLIENT" "$SOCKET" "halfclose;target 127.0.0.1;tcp 40000-40099")" \
+    "100 results, open: 40022"
+check "Stalled client dropped" "$(python3 -c "$CLIENT" "$SOCKET" "stall;target 127.0.0.1;tcp 1-65535")" \
+    "connection closed"
+check "Job after the cancelled ones" "$(python3 -c "$CLIENT" "$SOCKET" "target 127.0.0.1;tcp 40000-47999")" \
+    "8000 results, open: 40022 44080 47999"
+
+check "Socket only for the owner" "$(stat -c %a "$SOCKET")" "600"
+
+kill "$DAEMON_PID"
+wait "$DAEMON_PID" 2>/dev/null
+DAEMON_PID=""
+check "Socket removed on SIGTERM" "$([ -e "$SOCKET" ] && echo "exists" || echo "removed")" "removed"
+
+# Display summary
+print_section "TEST SUMMARY"
+echo -e "${GREEN}Passed: $TESTS_PASSED${RESET}"
+echo -e "${RED}Failed: $TESTS_FAILED${RESET}"
+
+if [ "$TESTS_FAILED" -ne 0 ]; then
+    exit 1
+fi
+exit 0
@@ -0,0 +1,131 @@
+#!/bin/bash
+# WATCH MODE TEST SCRIPT
+#  *
+#  * @file testWatch.sh
+#  * @brief This script watches listeners on the loopback, opens and closes ports during the watch and checks, that exactly the changes are printed.
+#  */
+
+# ANSI escape codes for colored output
+RESET="\033[0m"
+RED="\033[1;31m"
+GREEN="\033[1;32m"
+YELLOW="\033[1;33m"
+BLUE="\033[1;34m"
+MAGENTA="\033[1;35m"
+
+# Decorations
+SEPARATOR="${BLUE}========================================================${RESET}"
+
+# 2048 ports are swept in 16 slices, one per round
+PORTS="40000-42047"
+OUTPUT="/tmp/ipk-l4-scan-watch.out"
+
+TESTS_PASSED=0
+TESTS_FAILED=0
+STAYING_PID=""
+CLOSING_PID=""
+OPENING_PID=""
+WATCH_PID=""
+
+# raw sockets need root, the connect backend runs without
+BACKEND="raw"
+if [ "$(id -u)" -ne 0 ]; then
+    BACKEND="connect"
+fi
+
+# Helper function to print a formatted message
+print_section() {
+    echo -e "\n$SEPARATOR"
+    echo -e "${MAGENTA}$1${RESET}"
+    echo -e "$SEPARATOR"
+}
+
+# Helper function to stop the watch and the listeners
+cleanup() {
+    for pid in $WATCH_PID $STAYING_PID $CLOSING_PID $OPENING_PID; do
+        kill "$pid" 2>/dev/null
+    done
+}
+
+# Helper function to listen on a port of the loopback
+listen() {
+    python3 -c "
+import socket, time
+s = socket.socket()
+s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+s.bind(('127.0.0.1', $1))
+s.listen(128)
+time.sleep(3600)
+" &
+}
+
+# Helper function to check a value
+check() {
+    local description=$1
+    local output=$2
+    local expected=$3
+
+    echo -e "${YELLOW}Running: $description${RESET}"
+    echo -e "  $output"
+    if [ "$output" == "$expected" ]; then
+        echo -e "${GREEN}Test passed.${RESET}"
+        ((TESTS_PASSED++))
+    else
+        echo -e "${RED}Test failed, expected: $expected${RESET}"
+        ((TESTS_FAILED++))
+    fi
+}
+
+# Helper function to get the printed changes of a port, without the time
+changes() {
+    grep " $1 tcp " "$OUTPUT" | cut -d' ' -f3- | tr '\n' '|'
+}
+
+# Build
+print_section "BUILDING"
+make
+if [ ! -f "./ipk-l4-scan" ]; then
+    echo -e "${RED}Error: ipk-l4-scan binary not created.${RESET}"
+    exit 1
+fi
+
+# Watch, while a port closes and another one opens
+print_section "WATCHING $PORTS ON THE LOOPBACK (BACKEND $BACKEND)"
+trap cleanup EXIT
+listen 40022
+STAYING_PID=$!
+listen 41500
+CLOSING_PID=$!
+sleep 0.5
+
+./ipk-l4-scan -i lo -b "$BACKEND" -w 200 -t "$PORTS" -W 1 127.0.0.1 > "$OUTPUT" &
+WATCH_PID=$!
+sleep 3
+kill "$CLOSING_PID"
+CLOSING_PID=""
+listen 41000
+OPENING_PID=$!
+# the slice of 41000 comes within 16 rounds
+sleep 18
+kill -INT "$WATCH_PID"
+wait "$WATCH_PID"
+STATUS=$?
+WATCH_PID=""
+cat "$OUTPUT"
+
+print_section "CHECKING THE CHANGES"
+check "Open port printed once" "$(changes 40022)" "127.0.0.1 40022 tcp open (was unknown)|"
+check "Closed port" "$(changes 41500)" "127.0.0.1 41500 tcp open (was unknown)|127.0.0.1 41500 tcp closed (was open)|"
+check "Opened port" "$(changes 41000)" "127.0.0.1 41000 tcp open (was closed)|"
+check "No other changes" "$(wc -l < "$OUTPUT")" "4"
+check "Stopped by SIGINT" "exit $STATUS" "exit 0"
+
+# Display summary
+print_section "TEST SUMMARY"
+echo -e "${GREEN}Passed: $TESTS_PASSED${RESET}"
+echo -e "${RED}Failed: $TESTS_FAILED${RESET}"
+
+if [ "$TESTS_FAILED" -ne 0 ]; then
+    exit 1
+fi
+exit 0
@@ -0,0 +1,167 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <utility>
+#include <cstring>
+#include <arpa/inet.h>
+#include "exclude.hpp"
+
+using Clock = std::chrono::steady_clock;
+using Key = std::pair<uint64_t, uint64_t>;
+
+const size_t PREFIXES = 100000;
+const size_t LOOKUPS = 1000000;
+const char *PREFIX_FILE = "/tmp/benchExclude.txt";
+
+// excluded prefix, kept for the baseline
+struct Prefix {
+    NetworkAdress address;
+    int length;
+};
+
+// print the time per operation
+static void report(const char *name, Clock::time_point start, size_t count) {
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+    std::cout << name << ": " << ns << " ns/op" << std::endl;
+}
+
+// the address of the family, like makeAddress() without linking utils.cpp
+static NetworkAdress toAddress(int family, const void *addr) {
+    NetworkAdress address;
+    memset(&address, 0, sizeof(address));
+    memcpy(address.addr, addr, (family == AF_INET) ? 4 : 16);
+    address.ipVer = (family == AF_INET) ? IpVersion::IPV4 : IpVersion::IPV6;
+    address.valid = true;
+    return address;
+}
+
+// the address as a 128 bit key, IPv4 in the first 32 bits
+static Key toKey(const NetworkAdress &address) {
+    uint64_t key[2] = {0, 0};
+    int bytes = (address.ipVer == IpVersion::IPV4) ? 4 : 16;
+    for (int i = 0; i < bytes; i++) key[i / 8] |= uint64_t(address.addr[i]) << (56 - 8 * (i % 8));
+    return {key[0], key[1]};
+}
+
+// the baseline, the prefixes of one IP version as sorted and merged ranges
+static std::vector<std::pair<Key, Key>> toRanges(const std::vector<Prefix> &prefixes, IpVersion version) {
+    std::vector<std::pair<Key, Key>> ranges;
+    for (const Prefix &prefix : prefixes) {
+        if (prefix.address.ipVer != version) continue;
+        // IPv4 sits in the first 32 bits, everything past the length is host bits
+        int hostBits = 128 - prefix.length;
+        uint64_t highHost = (hostBits > 64) ? ~uint64_t(0) >> (128 - hostBits) : 0;
+        uint64_t lowHost = (hostBits >= 64) ? ~uint64_t(0) : (hostBits == 0) ? 0 : ~uint64_t(0) >> (64 - hostBits);
+        Key first = toKey(prefix.address);
+        first.first &= ~highHost;
+        first.second &= ~lowHost;
+        Key last = {first.first | highHost, first.second | lowHost};
+        ranges.push_back({first, last});
+    }
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<std::pair<Key, Key>> merged;
+    for (const auto &range : ranges) {
+        if (!merged.empty() && range.first <= merged.back().second) merged.back().second = std::max(merged.back().second, range.second);
+        else merged.push_back(range);
+    }
+    return merged;
+}
+
+// the baseline lookup, binary search over the ranges
+static bool inRanges(const std::vector<std::pair<Key, Key>> &ranges, const Key &key) {
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), key, [](const Key &k, const std::pair<Key, Key> &r) { return k < r.first; });
+    return it != ranges.begin() && key <= std::prev(it)->second;
+}
+
+int main() {
+    std::mt19937_64 random(42);
+
+    // 90% IPv4 (half of them /24), 10% IPv6 in 2001::/16
+    std::vector<Prefix> prefixes;
+    std::ofstream file(PREFIX_FILE);
+    file << "# benchmark exclusions" << std::endl;
+    char text[INET6_ADDRSTRLEN];
+    for (size_t i = 0; i < PREFIXES; i++) {
+        Prefix prefix;
+        if (i % 10 != 0) {
+            uint32_t addr = random();
+            prefix.length = (random() & 1) ? 24 : 16 + random() % 17;
+            prefix.address = toAddress(AF_INET, &addr);
+        } else {
+            unsigned char addr[16];
+            for (unsigned char &byte : addr) byte = random();
+            addr[0] = 0x20; addr[1] = 0x01;
+            prefix.length = 32 + random() % 33;
+            prefix.address = toAddress(AF_INET6, addr);
+        }
+        prefixes.push_back(prefix);
+        file << inet_ntop((prefix.address.ipVer == IpVersion::IPV4) ? AF_INET : AF_INET6, prefix.address.addr, text, sizeof(text)) << "/" << prefix.length << std::endl;
+    }
+    file.close();
+
+    // loading the file is parsing, inserting and the table
+    Clock::time_point start = Clock::now();
+    ExcludeList list;
+    list.addFile(PREFIX_FILE);
+    list.build();
+    std::cout << "ExcludeList load of " << list.size() << " prefixes: "
+        << std::chrono::duration<double, std::milli>(Clock::now() - start).count() << " ms" << std::endl;
+    std::remove(PREFIX_FILE);
+
+    // the addresses, half of them in a prefix of the list
+    std::vector<NetworkAdress> addresses;
+    addresses.reserve(LOOKUPS);
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        NetworkAdress address = prefixes[random() % PREFIXES].address;
+        if (i & 1) {
+            for (int byte = (address.ipVer == IpVersion::IPV4) ? 2 : 8; byte < 16; byte++) address.addr[byte] = random();
+            if (address.ipVer == IpVersion::IPV4) std::fill(address.addr + 4, address.addr + 16, 0);
+        } else if (address.ipVer == IpVersion::IPV4) {
+            uint32_t addr = random();
+            address = toAddress(AF_INET, &addr);
+        }
+        addresses.push_back(address);
+    }
+
+    // a scan walks its targets in order, the nodes of the range stay in the cache
+    std::vector<NetworkAdress> sweep;
+    sweep.reserve(LOOKUPS);
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        uint32_t addr = htonl(0x0a000000 + i);
+        sweep.push_back(toAddress(AF_INET, &addr));
+    }
+
+    // the trie
+    size_t excluded = 0, swept = 0;
+    start = Clock::now();
+    for (const NetworkAdress &address : addresses) excluded += list.contains(address);
+    report("ExcludeList lookup, random addresses", start, LOOKUPS);
+    start = Clock::now();
+    for (const NetworkAdress &address : sweep) swept += list.contains(address);
+    report("ExcludeList lookup, scan order", start, LOOKUPS);
+
+    // the baseline
+    std::vector<std::pair<Key, Key>> ranges4 = toRanges(prefixes, IpVersion::IPV4);
+    std::vector<std::pair<Key, Key>> ranges6 = toRanges(prefixes, IpVersion::IPV6);
+    std::vector<Key> keys;
+    for (const NetworkAdress &address : addresses) keys.push_back(toKey(address));
+    std::vector<Key> sweepKeys;
+    for (const NetworkAdress &address : sweep) sweepKeys.push_back(toKey(address));
+    size_t found = 0, sweptFound = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < LOOKUPS; i++) found += inRanges((addresses[i].ipVer == IpVersion::IPV4) ? ranges4 : ranges6, keys[i]);
+    report("sorted ranges lookup, random addresses", start, LOOKUPS);
+    start = Clock::now();
+    for (const Key &key : sweepKeys) sweptFound += inRanges(ranges4, key);
+    report("sorted ranges lookup, scan order", start, LOOKUPS);
+
+    std::cout << excluded << " of " << LOOKUPS << " addresses excluded" << std::endl;
+    if (excluded != found || swept != sweptFound) {
+        std::cout << "FAILED: the trie excluded " << excluded << " and " << swept << " addresses, the ranges " << found << " and " << sweptFound << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+#include <algorithm>
+#include <random>
+#include <arpa/inet.h>
+#include "probetable.hpp"
+
+const size_t PROBES = 1000000;
+
+// hash for the std::unordered_map baseline
+struct ProbeKeyHash {
+    size_t operator()(const ProbeKey &key) const {
+        return std::hash<uint64_t>()(key.addr[0] ^ key.addr[1] * 31) ^ (key.port << 8 | key.protocol);
+    }
+};
+
+// print the time per operation
+static void report(const char *name, Clock::time_point start, size_t count) {
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+    std::cout << name << ": " << ns << " ns/op" << std::endl;
+}
+
+int main() {
+    // 1M probes, 16 ports on every address of 10.0.0.0/12
+    std::vector<ProbeKey> keys;
+    keys.reserve(PROBES);
+    for (size_t i = 0; i < PROBES; i++) {
+        uint32_t addr = htonl(0x0a000000 + i / 16);
+        keys.push_back(makeProbeKey(AF_INET, &addr, 1 + i % 16, (i & 1) ? Protocol::UDP : Protocol::TCP));
+    }
+    // the answers come back out of order
+    std::vector<ProbeKey> answers = keys;
+    std::shuffle(answers.begin(), answers.end(), std::mt19937(42));
+    size_t found = 0;
+
+    // the table
+    ProbeTable table(PROBES);
+    Clock::time_point start = Clock::now();
+    for (const ProbeKey &key : keys) table.insert(key)->inFlight = true;
+    report("ProbeTable insert", start, PROBES);
+
+    start = Clock::now();
+    for (const ProbeKey &key : answers) found += table.find(key) != nullptr;
+    report("ProbeTable lookup", start, PROBES);
+
+    start = Clock::now();
+    for (const ProbeKey &key : keys) table.erase(table.find(key));
+    report("ProbeTable expire", start, PROBES);
+
+    // the baseline
+    std::unordered_map<ProbeKey, Probe, ProbeKeyHash> map;
+    map.reserve(PROBES);
+    start = Clock::now();
+    for (const ProbeKey &key : keys) map[key].port = key.port;
+    report("unordered_map insert", start, PROBES);
+
+    start = Clock::now();
+    for (const ProbeKey &key : answers) found += map.find(key) != map.end();
+    report("unordered_map lookup", start, PROBES);
+
+    start = Clock::now();
+    for (const ProbeKey &key : keys) map.erase(key);
+    report("unordered_map expire", start, PROBES);
+
+    if (found != 2 * PROBES || table.size() != 0 || !map.empty()) {
+        std::cout << "FAILED: lookups or erases went wrong" << std::endl;
+        return 1;
+    }
+    return 0;
+}
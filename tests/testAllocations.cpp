@@ -0,0 +1,107 @@
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include "pool.hpp"
+#include "scheduler.hpp"
+
+const int SCAN_PORTS = 5000;    // TCP ports scanned on the loopback
+const int WARM_UP = 100;        // results before the scan loop counts as warm
+
+// number of the heap allocations, counted by the replaced operator new
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    void *ptr = std::malloc(size ? size : 1);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+    allocations++;
+    size_t alignment = static_cast<size_t>(align);
+    void *ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size, std::align_val_t align) {
+    return ::operator new(size, align);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+static int failures = 0;
+
+// print the result of a check
+static void check(const char *name, size_t allocated) {
+    std::cout << name << ": " << allocated << " allocations " << (allocated == 0 ? "OK" : "FAILED") << std::endl;
+    if (allocated != 0) failures++;
+}
+
+// a ring with a steady size keeps its storage
+static void testRingQueue() {
+    RingQueue<int> queue;
+    queue.reserve(64);
+
+    size_t before = allocations;
+    for (int i = 0; i < 100000; i++) {
+        queue.push_back(i);
+        if (queue.size() > 48) queue.pop_front();
+        if (i % 7 == 0) queue.push_front(i);
+        if (i % 5 == 0) queue.erase(i - 3);
+    }
+    check("RingQueue push/pop/erase", allocations - before);
+}
+
+// the scan loop of the scheduler does not allocate, once it is running
+static void testScheduler(Backend backend, const char *name) {
+    NetworkInterface lo;
+    NetworkAdress target;
+    lo.name = "lo";
+    if (!parseAddress("127.0.0.1", lo.address) || !parseAddress("127.0.0.1", target)) {
+        std::cout << name << ": no loopback address, FAILED" << std::endl;
+        failures++;
+        return;
+    }
+    std::vector<int> ports;
+    for (int port = 1; port <= SCAN_PORTS; port++) ports.push_back(port);
+
+    try {
+        Scheduler<Ipv4> scheduler(lo, {target}, ports, {}, 1000, backend);
+        int results = 0;
+        size_t warm = 0;
+        scheduler.run([&](const PortResult &) {
+            if (++results == WARM_UP) warm = allocations;
+        });
+        if (results != SCAN_PORTS) {
+            std::cout << name << ": " << results << " of " << SCAN_PORTS << " ports, FAILED" << std::endl;
+            failures++;
+            return;
+        }
+        check(name, allocations - warm);
+    } catch (const std::runtime_error &e) {
+        // raw sockets need root
+        std::cout << name << ": skipped (" << e.what() << ")" << std::endl;
+    }
+}
+
+int main() {
+    testRingQueue();
+    testScheduler(Backend::RAW, "Scheduler scan loop (raw)");
+    testScheduler(Backend::IO_URING, "Scheduler scan loop (io_uring)");
+    return failures == 0 ? 0 : 1;
+}
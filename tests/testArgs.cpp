@@ -5,13 +5,13 @@
 
 int main(int argc, char *argv[]) {
 
-    NetworkAdress addr;
+    NetworkAdress *addr;
 
     // Parse arguments
     Settings settings(argc, argv);
 
     std::cout << settings.getInterface() << std::endl;
-    std::cout << (settings.getMode() == Mode::SCAN ? "SCAN" : "PRINT_INTERFACES") << std::endl;
+    std::cout << (settings.getMode() == Mode::SCAN ? "SCAN" : settings.getMode() == Mode::DAEMON ? "DAEMON" : settings.getMode() == Mode::WATCH ? "WATCH" : "PRINT_INTERFACES") << std::endl;
     std::cout << settings.getTCPports().size() << std::endl;
     for (auto port : settings.getTCPports()) {
         std::cout << port << " ";
@@ -24,17 +24,21 @@ int main(int argc, char *argv[]) {
     std::cout << std::endl;
 
     addr = settings.getTargetIp4();
-    std::cout << addr.hostName << std::endl;
-    std::cout << addr.ip << std::endl;
-    std::cout << (addr.ipVer == IpVersion::IPV4 ? "IPV4" : "IPV6") << std::endl;
+    if (addr != nullptr) {
+        std::cout << toString(*addr) << std::endl;
+        std::cout << (addr->ipVer == IpVersion::IPV4 ? "IPV4" : "IPV6") << std::endl;
+    }
     std::cout << settings.isTargetIpv4() << std::endl;
 
     addr = settings.getTargetIp6();
-    std::cout << addr.hostName << std::endl;
-    std::cout << addr.ip << std::endl;
-    std::cout << (addr.ipVer == IpVersion::IPV4 ? "IPV4" : "IPV6") << std::endl;
+    if (addr != nullptr) {
+        std::cout << toString(*addr) << std::endl;
+        std::cout << (addr->ipVer == IpVersion::IPV4 ? "IPV4" : "IPV6") << std::endl;
+    }
     std::cout << settings.isTargetIpv6() << std::endl;
 
     std::cout << settings.getTimeout() << std::endl;
+    std::cout << "hostProbes " << settings.getHostProbes() << std::endl;
+    std::cout << "bannerBytes " << settings.getBannerBytes() << std::endl;
 
 }
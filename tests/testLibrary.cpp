@@ -0,0 +1,133 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "l4scan.hpp"
+#include "portalloc.hpp"
+
+const int FIRST_PORT = 41000;                       // ports of the concurrent jobs, 41000-41199
+const std::vector<int> OPEN_PORTS = {41010, 41150, 41199};
+
+static int failures = 0;
+
+// print the result of a check
+static void check(const std::string &name, bool ok) {
+    std::cout << name << ": " << (ok ? "OK" : "FAILED") << std::endl;
+    if (!ok) failures++;
+}
+
+// raw sockets need root, the connect backend runs without
+static Backend testBackend() {
+    return geteuid() == 0 ? Backend::RAW : Backend::CONNECT;
+}
+
+// the setting errors are returned, the library neither throws nor exits
+static void testErrors() {
+    check("no interface", ScanJob().target("127.0.0.1").tcpPorts("22").run().message == "no interface");
+    check("no target", ScanJob().interface("lo").tcpPorts("22").run().message == "no target");
+    check("no ports", ScanJob().interface("lo").target("127.0.0.1").run().message == "no ports");
+    check("invalid port", ScanJob().interface("lo").target("127.0.0.1").tcpPorts("70000").run().message == "invalid TCP port: 70000");
+    check("invalid port range", ScanJob().interface("lo").target("127.0.0.1").udpPorts("9-x").run().message == "invalid UDP ports: 9-x");
+    check("invalid target", ScanJob().interface("lo").target("300.1.1.1").tcpPorts("22").run().message == "invalid target IP address: 300.1.1.1");
+    check("invalid timeout", ScanJob().interface("lo").target("127.0.0.1").tcpPorts("22").timeout(0).run().message == "timeout must be greater than 0");
+    check("excluded targets", ScanJob().interface("lo").target("127.0.0.1").tcpPorts("22").exclude("127.0.0.0/8").run().message == "all targets are excluded");
+    check("loopback with other targets", ScanJob().interface("lo").target("127.0.0.1").target("10.0.0.1").tcpPorts("22").run().message == "loopback and other IPv4 targets can not be scanned together");
+    check("unknown interface", bool(ScanJob().interface("nosuchif0").target("10.0.0.1").tcpPorts("22").run()));
+
+    ScanJob job;
+    job.interface("lo").target("127.0.0.1");
+    PortResult result;
+    check("failed job yields no results", !job.next(result) && job.finished() && bool(job.getError()));
+}
+
+// two jobs in one runner, one with a callback, one with the queue of next()
+static void testRunner() {
+    std::vector<int> callbackOpen, pulledOpen;
+    size_t callbackResults = 0, pulledResults = 0;
+
+    ScanJob withCallback, withQueue;
+    withCallback.interface("lo").target("127.0.0.1").tcpPorts(std::to_string(FIRST_PORT) + "-" + std::to_string(FIRST_PORT + 99)).timeout(500).backend(testBackend());
+    withCallback.onResult([&](const PortResult &result) {
+        callbackResults++;
+        if (result.result == ScanResult::OPEN) callbackOpen.push_back(result.port);
+    });
+    withQueue.interface("lo").target("127.0.0.1").tcpPorts(std::to_string(FIRST_PORT + 100) + "-" + std::to_string(FIRST_PORT + 199)).timeout(500).backend(testBackend());
+
+    ScanRunner runner;
+    check("runner takes the jobs", !runner.add(withCallback) && !runner.add(withQueue));
+    check("job is not added twice", bool(runner.add(withQueue)));
+    runner.run();
+
+    PortResult result;
+    while (withQueue.next(result)) {
+        pulledResults++;
+        if (result.result == ScanResult::OPEN) pulledOpen.push_back(result.port);
+    }
+    std::sort(pulledOpen.begin(), pulledOpen.end());
+    check("callback job finished", withCallback.finished() && !withCallback.getError() && callbackResults == 100 && callbackOpen == std::vector<int>{41010});
+    check("queued job finished", withQueue.finished() && !withQueue.getError() && pulledResults == 100 && pulledOpen == std::vector<int>{41150, 41199});
+}
+
+// a job destroyed in the middle of its scan leaves the runner and gives its ports back
+static void testCancel() {
+    ScanRunner runner;
+    {
+        ScanJob job;
+        job.interface("lo").target("127.0.0.1").tcpPorts("1-65535").timeout(500).backend(testBackend());
+        runner.add(job);
+        std::vector<struct pollfd> fds;
+        for (int i = 0; i < 3; i++) {
+            runner.sendDue();
+            int timeoutMs = -1;
+            fds.clear();
+            runner.addPollFds(fds, timeoutMs);
+            poll(fds.data(), fds.size(), timeoutMs);
+            runner.process();
+        }
+    }
+    check("cancelled job left the runner", runner.finished());
+    check("ports of the cancelled job released", sourcePorts().inUse() == 0);
+
+    // a job of its own, pulled without a runner
+    ScanJob job;
+    job.interface("lo").target("127.0.0.1").tcpPorts(std::to_string(FIRST_PORT) + "-" + std::to_string(FIRST_PORT + 199)).timeout(500).backend(testBackend());
+    size_t results = 0, open = 0;
+    PortResult result;
+    while (job.next(result)) {
+        results++;
+        open += result.result == ScanResult::OPEN;
+    }
+    check("job after the cancelled one", !job.getError() && results == 200 && open == OPEN_PORTS.size());
+}
+
+int main() {
+    // listeners on the open ports of the jobs
+    std::vector<int> listeners;
+    for (int port : OPEN_PORTS) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 128) < 0) {
+            std::cout << "listener on " << port << ": FAILED" << std::endl;
+            return 1;
+        }
+        listeners.push_back(fd);
+    }
+
+    testErrors();
+    testRunner();
+    testCancel();
+
+    for (int fd : listeners) close(fd);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include "portalloc.hpp"
+
+const int THREADS = 4;              // threads drawing ports at once
+const int PORTS_PER_THREAD = 4000;  // ports held by every thread
+
+static int failures = 0;
+
+// print the result of a check
+static void check(const char *name, bool ok) {
+    std::cout << name << ": " << (ok ? "OK" : "FAILED") << std::endl;
+    if (!ok) failures++;
+}
+
+// every port of the range comes once, then the allocator is exhausted
+static void testExhaust() {
+    PortAllocator allocator(1024, 256);
+    std::vector<uint16_t> ports;
+    for (int i = 0; i < 256; i++) ports.push_back(allocator.acquire());
+
+    std::vector<uint16_t> sorted = ports;
+    std::sort(sorted.begin(), sorted.end());
+    bool unique = std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end();
+    bool inRange = sorted.front() == 1024 && sorted.back() == 1024 + 255;
+    check("whole range handed out once", unique && inRange);
+    check("exhausted range returns 0", allocator.acquire() == 0 && allocator.inUse() == 256);
+
+    allocator.release(ports[100]);
+    check("released port comes back", allocator.acquire() == ports[100]);
+}
+
+// a released port is handed out again only after the rest of the range
+static void testRecycle() {
+    PortAllocator allocator(1024, 256);
+    uint16_t first = allocator.acquire();
+    allocator.release(first);
+
+    bool reused = false;
+    for (int i = 0; i < 200; i++) {
+        uint16_t port = allocator.acquire();
+        reused |= port == first;
+        allocator.release(port);
+    }
+    check("released port not reused right away", !reused);
+}
+
+// threads never get the same port
+static void testThreads() {
+    PortAllocator &allocator = sourcePorts();
+    std::vector<std::vector<uint16_t>> held(THREADS);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&allocator, &held, t]() {
+            for (int i = 0; i < PORTS_PER_THREAD; i++) held[t].push_back(allocator.acquire());
+        });
+    }
+    for (std::thread &thread : threads) thread.join();
+
+    std::vector<uint16_t> all;
+    for (const std::vector<uint16_t> &ports : held) all.insert(all.end(), ports.begin(), ports.end());
+    std::sort(all.begin(), all.end());
+    bool unique = std::adjacent_find(all.begin(), all.end()) == all.end();
+    check("concurrent ports unique", unique && all.front() >= SOURCE_PORT_BASE);
+
+    for (uint16_t port : all) allocator.release(port);
+    check("all ports released", allocator.inUse() == 0);
+}
+
+int main() {
+    testExhaust();
+    testRecycle();
+    testThreads();
+    return failures == 0 ? 0 : 1;
+}